@@ -179,6 +179,7 @@ if(APPLE OR
 else()
   set(HAVE_MEMRCHR 1)
 endif()
+set(HAVE_MMAP 1)
 set(HAVE_MSG_NOSIGNAL 1)
 set(HAVE_NETDB_H 1)
 if(ANDROID)
@@ -203,18 +204,29 @@ elseif(CMAKE_SYSTEM_NAME STREQUAL "Linux" OR
 endif()
 set(HAVE_POLL 1)
 set(HAVE_POLL_H 1)
+if(APPLE)
+  set(HAVE_POSIX_FALLOCATE 0)
+else()
+  set(HAVE_POSIX_FALLOCATE 1)
+endif()
 if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
   set(HAVE_POSIX_STRERROR_R 0)
 else()
   set(HAVE_POSIX_STRERROR_R 1)
 endif()
 set(HAVE_PWD_H 1)
+set(HAVE_PWRITE 1)
 set(HAVE_REALPATH 1)
 set(HAVE_RECV 1)
 set(HAVE_SA_FAMILY_T 1)
 set(HAVE_SCHED_YIELD 1)
 set(HAVE_SELECT 1)
 set(HAVE_SEND 1)
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(HAVE_SENDFILE 1)
+else()
+  set(HAVE_SENDFILE 0)
+endif()
 if(APPLE OR
    CYGWIN)
   set(HAVE_SENDMMSG 0)
@@ -280,6 +292,11 @@ set(HAVE_SYS_PARAM_H 1)
 set(HAVE_SYS_POLL_H 1)
 set(HAVE_SYS_RESOURCE_H 1)
 set(HAVE_SYS_SELECT_H 1)
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(HAVE_SYS_SENDFILE_H 1)
+else()
+  set(HAVE_SYS_SENDFILE_H 0)
+endif()
 if(CYGWIN OR
    CMAKE_SYSTEM_NAME STREQUAL "Linux")
   set(HAVE_SYS_SOCKIO_H 0)
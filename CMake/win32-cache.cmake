@@ -128,6 +128,7 @@ set(HAVE_IO_H 1)
 set(HAVE_LINUX_TCP_H 0)
 set(HAVE_LOCALE_H 1)
 set(HAVE_MEMRCHR 0)
+set(HAVE_MMAP 0)
 set(HAVE_MSG_NOSIGNAL 0)
 set(HAVE_NETDB_H 0)
 set(HAVE_NETINET_IN6_H 0)
@@ -139,11 +140,14 @@ set(HAVE_PIPE 0)
 set(HAVE_PIPE2 0)
 set(HAVE_POLL 0)
 set(HAVE_POLL_H 0)
+set(HAVE_POSIX_FALLOCATE 0)
 set(HAVE_POSIX_STRERROR_R 0)
 set(HAVE_PWD_H 0)
+set(HAVE_PWRITE 0)
 set(HAVE_RECV 1)
 set(HAVE_SELECT 1)
 set(HAVE_SEND 1)
+set(HAVE_SENDFILE 0)
 set(HAVE_SENDMMSG 0)
 set(HAVE_SENDMSG 0)
 set(HAVE_SETLOCALE 1)
@@ -168,6 +172,7 @@ set(HAVE_SYS_IOCTL_H 0)
 set(HAVE_SYS_POLL_H 0)
 set(HAVE_SYS_RESOURCE_H 0)
 set(HAVE_SYS_SELECT_H 0)
+set(HAVE_SYS_SENDFILE_H 0)
 set(HAVE_SYS_SOCKIO_H 0)
 set(HAVE_SYS_TYPES_H 1)
 set(HAVE_SYS_UN_H 0)
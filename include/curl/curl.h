@@ -2258,6 +2258,18 @@ typedef enum {
   /* set TLS supported signature algorithms */
   CURLOPT(CURLOPT_SSL_SIGNATURE_ALGORITHMS, CURLOPTTYPE_STRINGPOINT, 328),
 
+  /* compress the request body with this content-encoding */
+  CURLOPT(CURLOPT_UPLOAD_ENCODING, CURLOPTTYPE_STRINGPOINT, 329),
+
+  /* compression dictionary for dcb and dcz content-encodings */
+  CURLOPT(CURLOPT_COMPRESSION_DICT_BLOB, CURLOPTTYPE_BLOB, 330),
+
+  /* store dictionaries from Use-As-Dictionary: responses */
+  CURLOPT(CURLOPT_COMPRESSION_DICT_LEARN, CURLOPTTYPE_LONG, 331),
+
+  /* journal cookie changes next to the cookie jar instead of rewriting it */
+  CURLOPT(CURLOPT_COOKIEJOURNAL, CURLOPTTYPE_LONG, 332),
+
   CURLOPT_LASTENTRY /* the last unused */
 } CURLoption;
 
@@ -3079,6 +3091,7 @@ typedef enum {
   CURLSHOPT_UNLOCKFUNC, /* pass in a 'curl_unlock_function' pointer */
   CURLSHOPT_USERDATA,   /* pass in a user data pointer used in the lock/unlock
                            callback functions */
+  CURLSHOPT_BUILTIN_LOCKS, /* pass in a long, 1 to use libcurl's own locks */
   CURLSHOPT_LAST  /* never use */
 } CURLSHoption;
 
@@ -398,6 +398,9 @@ typedef enum {
   /* network has changed, adjust caches/connection reuse */
   CURLOPT(CURLMOPT_NETWORK_CHANGED, CURLOPTTYPE_LONG, 17),
 
+  /* time in ms between automatic upkeep of idle connections, 0 for none */
+  CURLOPT(CURLMOPT_UPKEEP_INTERVAL, CURLOPTTYPE_LONG, 18),
+
   CURLMOPT_LASTENTRY /* the last unused */
 } CURLMoption;
 
@@ -506,6 +509,40 @@ typedef int (*curl_push_callback)(CURL *parent,
                                   struct curl_pushheaders *headers,
                                   void *userp);
 
+/*
+ * Name:    curl_multi_preconnect()
+ *
+ * Desc:    Make 'count' connections to each of the URLs in the list and
+ *          leave them idle in the connection pool, for transfers to reuse.
+ *          The transfers doing it are owned by the multi handle and take
+ *          their options from the given easy handle, or use the defaults
+ *          if it is NULL. They are driven by curl_multi_perform() or
+ *          curl_multi_socket_action() like other transfers.
+ *
+ * Returns: CURLMcode type, general multi error code.
+ */
+CURL_EXTERN CURLMcode curl_multi_preconnect(CURLM *multi_handle,
+                                            CURL *easy_handle,
+                                            struct curl_slist *urls,
+                                            unsigned int count);
+
+/*
+ * Name:    curl_multi_handoff()
+ *
+ * Desc:    Move up to 'max' idle connections from the connection pool of
+ *          one multi handle to the pool of another. With 'url' set, only
+ *          connections to its scheme, host and port are moved. The number
+ *          of connections moved is stored in 'moved' if not NULL. Neither
+ *          multi handle may be used in another thread during the call.
+ *
+ * Returns: CURLMcode type, general multi error code.
+ */
+CURL_EXTERN CURLMcode curl_multi_handoff(CURLM *from_multi,
+                                         CURLM *to_multi,
+                                         const char *url,
+                                         unsigned int max,
+                                         unsigned int *moved);
+
 /*
  * Name:    curl_multi_waitfds()
  *
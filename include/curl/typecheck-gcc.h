@@ -481,6 +481,7 @@ CURLWARNING(_curl_easy_getinfo_err_curl_off_t,
    (option) == CURLOPT_TLSAUTH_TYPE ||                                  \
    (option) == CURLOPT_TLSAUTH_USERNAME ||                              \
    (option) == CURLOPT_UNIX_SOCKET_PATH ||                              \
+   (option) == CURLOPT_UPLOAD_ENCODING ||                               \
    (option) == CURLOPT_URL ||                                           \
    (option) == CURLOPT_USERAGENT ||                                     \
    (option) == CURLOPT_USERNAME ||                                      \
@@ -56,6 +56,29 @@ CURL_EXTERN CURLcode curl_ws_recv(CURL *curl, void *buffer, size_t buflen,
                                   size_t *recv,
                                   const struct curl_ws_frame **metap);
 
+/*
+ * NAME curl_ws_recv_view()
+ *
+ * DESCRIPTION
+ *
+ * Like curl_ws_recv(), but instead of copying, returns a pointer to the
+ * received data inside libcurl's buffer. The data stays valid until
+ * curl_ws_recv_release() or another receive call on the handle.
+ */
+CURL_EXTERN CURLcode curl_ws_recv_view(CURL *curl, const void **bufp,
+                                       size_t *lenp,
+                                       const struct curl_ws_frame **metap);
+
+/*
+ * NAME curl_ws_recv_release()
+ *
+ * DESCRIPTION
+ *
+ * Consumes the first `len` bytes of the data returned by the last
+ * curl_ws_recv_view().
+ */
+CURL_EXTERN CURLcode curl_ws_recv_release(CURL *curl, size_t len);
+
 /* flags for curl_ws_send() */
 #define CURLWS_PONG       (1<<6)
 
@@ -72,6 +95,25 @@ CURL_EXTERN CURLcode curl_ws_send(CURL *curl, const void *buffer,
                                   curl_off_t fragsize,
                                   unsigned int flags);
 
+/* a frame for curl_ws_sendv() */
+struct curl_ws_vec {
+  const void *buffer;  /* the payload */
+  size_t buflen;       /* length of the payload */
+  unsigned int flags;  /* See the CURLWS_* defines */
+};
+
+/*
+ * NAME curl_ws_sendv()
+ *
+ * DESCRIPTION
+ *
+ * Sends several complete frames over the websocket connection, passing
+ * them on to the network in one go. Returns the number of frames accepted.
+ */
+CURL_EXTERN CURLcode curl_ws_sendv(CURL *curl,
+                                   const struct curl_ws_vec *frames,
+                                   size_t nframes, size_t *nsent);
+
 /*
  * NAME curl_ws_start_frame()
  *
@@ -88,6 +130,8 @@ CURL_EXTERN CURLcode curl_ws_start_frame(CURL *curl,
 /* bits for the CURLOPT_WS_OPTIONS bitmask: */
 #define CURLWS_RAW_MODE   (1L<<0)
 #define CURLWS_NOAUTOPONG (1L<<1)
+#define CURLWS_DEFLATE    (1L<<2)
+#define CURLWS_DEFLATE_NOTAKEOVER (1L<<3)
 
 CURL_EXTERN const struct curl_ws_frame *curl_ws_meta(CURL *curl);
 
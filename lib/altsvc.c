@@ -52,8 +52,15 @@
 #define MAX_ALTSVC_HOSTLEN 2048
 #define MAX_ALTSVC_ALPNLEN 10
 
+#define ALTSVC_HASH_SIZE 31
+
 #define H3VERSION "h3"
 
+/* the entries for one source host */
+struct altsvc_host {
+  struct Curl_llist list;
+};
+
 /* Given the ALPN ID, return the name */
 const char *Curl_alpnid2str(enum alpnid id)
 {
@@ -77,6 +84,65 @@ static void altsvc_free(struct altsvc *as)
   free(as);
 }
 
+static void altsvc_host_dtor(void *p)
+{
+  struct altsvc_host *ah = p;
+  struct Curl_llist_node *e = Curl_llist_head(&ah->list);
+  while(e) {
+    struct altsvc *as = Curl_node_elem(e);
+    e = Curl_node_next(e);
+    Curl_node_remove(&as->node);
+    altsvc_free(as);
+  }
+  free(ah);
+}
+
+/* the entries for this source host, a trailing dot is ignored */
+static struct altsvc_host *altsvc_host(struct altsvcinfo *asi,
+                                       const char *host)
+{
+  size_t hlen = strlen(host);
+  if(hlen && (host[hlen - 1] == '.'))
+    hlen--;
+  return Curl_hash_pick(&asi->hosts, CURL_UNCONST(host), hlen);
+}
+
+/* add the entry to the cache, it is freed on failure */
+static CURLcode altsvc_append(struct altsvcinfo *asi, struct altsvc *as)
+{
+  size_t hlen = strlen(as->src.host);
+  struct altsvc_host *ah = Curl_hash_pick(&asi->hosts, as->src.host, hlen);
+  if(!ah) {
+    ah = calloc(1, sizeof(*ah));
+    if(ah) {
+      Curl_llist_init(&ah->list, NULL);
+      if(!Curl_hash_add(&asi->hosts, as->src.host, hlen, ah)) {
+        free(ah);
+        ah = NULL;
+      }
+    }
+    if(!ah) {
+      altsvc_free(as);
+      return CURLE_OUT_OF_MEMORY;
+    }
+    Curl_hash_grow_if_needed(&asi->hosts);
+  }
+  Curl_llist_append(&ah->list, as, &as->hnode);
+  Curl_llist_append(&asi->list, as, &as->node);
+  return CURLE_OK;
+}
+
+static void altsvc_remove(struct altsvcinfo *asi, struct altsvc_host *ah,
+                          struct altsvc *as)
+{
+  Curl_node_remove(&as->node);
+  Curl_node_remove(&as->hnode);
+  if(!Curl_llist_count(&ah->list))
+    /* the last one for this host */
+    Curl_hash_delete(&asi->hosts, as->src.host, strlen(as->src.host));
+  altsvc_free(as);
+}
+
 static struct altsvc *altsvc_createid(const char *srchost,
                                       size_t hlen,
                                       const char *dsthost,
@@ -200,7 +266,7 @@ static CURLcode altsvc_add(struct altsvcinfo *asi, const char *line)
       as->expires = expires;
       as->prio = 0; /* not supported to just set zero */
       as->persist = persist ? 1 : 0;
-      Curl_llist_append(&asi->list, as, &as->node);
+      return altsvc_append(asi, as);
     }
   }
 
@@ -302,6 +368,8 @@ struct altsvcinfo *Curl_altsvc_init(void)
   if(!asi)
     return NULL;
   Curl_llist_init(&asi->list, NULL);
+  Curl_hash_init(&asi->hosts, ALTSVC_HASH_SIZE, Curl_hash_str_nocase,
+                 Curl_hash_str_casecompare, altsvc_host_dtor);
 
   /* set default behavior */
   asi->flags = CURLALTSVC_H1
@@ -341,14 +409,8 @@ CURLcode Curl_altsvc_ctrl(struct altsvcinfo *asi, const long ctrl)
 void Curl_altsvc_cleanup(struct altsvcinfo **altsvcp)
 {
   if(*altsvcp) {
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
     struct altsvcinfo *altsvc = *altsvcp;
-    for(e = Curl_llist_head(&altsvc->list); e; e = n) {
-      struct altsvc *as = Curl_node_elem(e);
-      n = Curl_node_next(e);
-      altsvc_free(as);
-    }
+    Curl_hash_destroy(&altsvc->hosts);
     free(altsvc->filename);
     free(altsvc);
     *altsvcp = NULL; /* clear the pointer */
@@ -402,38 +464,23 @@ CURLcode Curl_altsvc_save(struct Curl_easy *data,
   return result;
 }
 
-/* hostcompare() returns true if 'host' matches 'check'. The first host
- * argument may have a trailing dot present that will be ignored.
- */
-static bool hostcompare(const char *host, const char *check)
-{
-  size_t hlen = strlen(host);
-  size_t clen = strlen(check);
-
-  if(hlen && (host[hlen - 1] == '.'))
-    hlen--;
-  if(hlen != clen)
-    /* they cannot match if they have different lengths */
-    return FALSE;
-  return curl_strnequal(host, check, hlen);
-}
-
 /* altsvc_flush() removes all alternatives for this source origin from the
    list */
 static void altsvc_flush(struct altsvcinfo *asi, enum alpnid srcalpnid,
                          const char *srchost, unsigned short srcport)
 {
+  struct altsvc_host *ah = altsvc_host(asi, srchost);
   struct Curl_llist_node *e;
   struct Curl_llist_node *n;
-  for(e = Curl_llist_head(&asi->list); e; e = n) {
+  if(!ah)
+    return;
+  for(e = Curl_llist_head(&ah->list); e; e = n) {
     struct altsvc *as = Curl_node_elem(e);
     n = Curl_node_next(e);
     if((srcalpnid == as->src.alpnid) &&
-       (srcport == as->src.port) &&
-       hostcompare(srchost, as->src.host)) {
-      Curl_node_remove(e);
-      altsvc_free(as);
-    }
+       (srcport == as->src.port))
+      /* removes 'ah' with the last entry, when 'n' is NULL */
+      altsvc_remove(asi, ah, as);
   }
 }
 
@@ -600,7 +647,8 @@ CURLcode Curl_altsvc_parse(struct Curl_easy *data,
             else
               as->expires = maxage + secs;
             as->persist = persist;
-            Curl_llist_append(&asi->list, as, &as->node);
+            if(altsvc_append(asi, as))
+              return CURLE_OUT_OF_MEMORY;
             infof(data, "Added alt-svc: %.*s:%d over %s",
                   (int)curlx_strlen(&dsthost), curlx_str(&dsthost),
                   dstport, Curl_alpnid2str(dstalpnid));
@@ -636,6 +684,7 @@ bool Curl_altsvc_lookup(struct altsvcinfo *asi,
                         struct altsvc **dstentry,
                         const int versions) /* one or more bits */
 {
+  struct altsvc_host *ah;
   struct Curl_llist_node *e;
   struct Curl_llist_node *n;
   time_t now = time(NULL);
@@ -643,17 +692,18 @@ bool Curl_altsvc_lookup(struct altsvcinfo *asi,
   DEBUGASSERT(srchost);
   DEBUGASSERT(dstentry);
 
-  for(e = Curl_llist_head(&asi->list); e; e = n) {
+  ah = altsvc_host(asi, srchost);
+  if(!ah)
+    return FALSE;
+  for(e = Curl_llist_head(&ah->list); e; e = n) {
     struct altsvc *as = Curl_node_elem(e);
     n = Curl_node_next(e);
     if(as->expires < now) {
       /* an expired entry, remove */
-      Curl_node_remove(e);
-      altsvc_free(as);
+      altsvc_remove(asi, ah, as);
       continue;
     }
     if((as->src.alpnid == srcalpnid) &&
-       hostcompare(srchost, as->src.host) &&
        (as->src.port == srcport) &&
        (versions & (int)as->dst.alpnid)) {
       /* match */
@@ -28,6 +28,7 @@
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_ALTSVC)
 #include <curl/curl.h>
 #include "llist.h"
+#include "hash.h"
 
 struct althost {
   char *host;
@@ -39,7 +40,8 @@ struct altsvc {
   struct althost src;
   struct althost dst;
   time_t expires;
-  struct Curl_llist_node node;
+  struct Curl_llist_node node;  /* in the cache's list */
+  struct Curl_llist_node hnode; /* in the list for the source host */
   unsigned int prio;
   BIT(persist);
 };
@@ -47,6 +49,7 @@ struct altsvc {
 struct altsvcinfo {
   char *filename;
   struct Curl_llist list; /* list of entries */
+  struct Curl_hash hosts; /* the same entries, grouped on source host */
   long flags; /* the publicly set bitmask */
 };
 
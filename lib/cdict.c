@@ -0,0 +1,555 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+/*
+ * Compression Dictionary Transport is defined in RFC 9842:
+ * https://datatracker.ietf.org/doc/html/rfc9842
+ */
+#include "curl_setup.h"
+
+#ifdef USE_COMPRESSION_DICT
+#include <curl/curl.h>
+#include "urldata.h"
+#include "cdict.h"
+#include "content_encoding.h"
+#include "sendf.h"
+#include "transfer.h"
+#include "strdup.h"
+#include "curlx/base64.h"
+#include "curlx/dynbuf.h"
+#include "curlx/strparse.h"
+
+/* The last 3 #include files should be in this order */
+#include "curl_printf.h"
+#include "curl_memory.h"
+#include "memdebug.h"
+
+#define MAX_CDICT_SIZE    (16 * 1024 * 1024) /* a single learned dictionary */
+#define MAX_CDICT_TOTAL   (64 * 1024 * 1024) /* all learned dictionaries */
+#define MAX_CDICT_ENTRIES 16                 /* learned dictionaries */
+#define MAX_CDICT_IDLEN   1024
+#define MAX_CDICT_MATCHLEN 2048
+
+static void cdict_free(struct cdict *d)
+{
+  free(d->origin);
+  free(d->match);
+  free(d->id);
+  free(d->data);
+  free(d);
+}
+
+struct cdictinfo *Curl_cdict_init(void)
+{
+  struct cdictinfo *ci = calloc(1, sizeof(struct cdictinfo));
+  if(ci)
+    Curl_llist_init(&ci->list, NULL);
+  return ci;
+}
+
+void Curl_cdict_cleanup(struct cdictinfo **cdictp)
+{
+  if(*cdictp) {
+    struct Curl_llist_node *e;
+    struct Curl_llist_node *n;
+    struct cdictinfo *ci = *cdictp;
+    for(e = Curl_llist_head(&ci->list); e; e = n) {
+      struct cdict *d = Curl_node_elem(e);
+      n = Curl_node_next(e);
+      cdict_free(d);
+    }
+    free(ci);
+    *cdictp = NULL; /* clear the pointer */
+  }
+}
+
+static void cdict_remove(struct Curl_easy *data, struct cdictinfo *ci,
+                         struct cdict *d)
+{
+  if(data->req.cdict == d)
+    data->req.cdict = NULL;
+  if(d->origin)
+    ci->total -= d->len;
+  else
+    ci->app_set = FALSE;
+  Curl_node_remove(&d->node);
+  cdict_free(d);
+}
+
+void Curl_cdict_app_reset(struct cdictinfo *ci)
+{
+  struct Curl_llist_node *e;
+  for(e = Curl_llist_head(&ci->list); e; e = Curl_node_next(e)) {
+    struct cdict *d = Curl_node_elem(e);
+    if(!d->origin) {
+      Curl_node_remove(&d->node);
+      cdict_free(d);
+      break;
+    }
+  }
+  ci->app_set = FALSE;
+}
+
+/*
+ * Add a dictionary, replacing one with the same origin and match pattern.
+ * Takes ownership of 'dict' and the strings, also on failure.
+ */
+static CURLcode cdict_add(struct Curl_easy *data, struct cdictinfo *ci,
+                          char *origin, char *match, char *id,
+                          unsigned char *dict, size_t len)
+{
+  struct Curl_llist_node *e;
+  struct Curl_llist_node *n;
+  struct cdict *d = calloc(1, sizeof(struct cdict));
+  CURLcode result;
+
+  if(!d) {
+    free(origin);
+    free(match);
+    free(id);
+    free(dict);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  d->origin = origin;
+  d->match = match;
+  d->id = id;
+  d->data = dict;
+  d->len = len;
+  result = Curl_sha256it(d->hash, dict, len);
+  if(result) {
+    cdict_free(d);
+    return result;
+  }
+
+  for(e = Curl_llist_head(&ci->list); e; e = n) {
+    struct cdict *o = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if((!o->origin == !origin) &&
+       (!origin || !strcmp(o->origin, origin)) && !strcmp(o->match, match))
+      cdict_remove(data, ci, o);
+  }
+
+  if(origin) {
+    /* make room, evicting the oldest learned dictionaries */
+    ci->total += len;
+    for(e = Curl_llist_head(&ci->list); e &&
+          ((ci->total > MAX_CDICT_TOTAL) ||
+           (Curl_llist_count(&ci->list) >= MAX_CDICT_ENTRIES));
+        e = n) {
+      struct cdict *o = Curl_node_elem(e);
+      n = Curl_node_next(e);
+      if(o->origin)
+        cdict_remove(data, ci, o);
+    }
+  }
+  else
+    ci->app_set = TRUE;
+  Curl_llist_append(&ci->list, d, &d->node);
+  return CURLE_OK;
+}
+
+/* Bring the application dictionary in sync with the blob option */
+static CURLcode cdict_app_sync(struct Curl_easy *data)
+{
+  struct curl_blob *blob = data->set.blobs[BLOB_COMPRESSION_DICT];
+  unsigned char *dict;
+  char *match;
+
+  if(!blob) {
+    if(data->cdicts && data->cdicts->app_set)
+      Curl_cdict_app_reset(data->cdicts);
+    return CURLE_OK;
+  }
+  if(data->cdicts && data->cdicts->app_set)
+    return CURLE_OK;
+  if(!data->cdicts) {
+    data->cdicts = Curl_cdict_init();
+    if(!data->cdicts)
+      return CURLE_OUT_OF_MEMORY;
+  }
+  dict = Curl_memdup0(blob->data, blob->len);
+  match = strdup("*");
+  if(!dict || !match) {
+    free(dict);
+    free(match);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  return cdict_add(data, data->cdicts, NULL, match, NULL, dict, blob->len);
+}
+
+/* Dictionaries are only learned from and offered to secure contexts */
+static bool cdict_secure(struct Curl_easy *data)
+{
+  const char *host = data->state.up.hostname;
+  if(curl_strequal(data->state.up.scheme, "https"))
+    return TRUE;
+  return host && (curl_strequal(host, "localhost") ||
+                  !strcmp(host, "127.0.0.1") || !strcmp(host, "[::1]"));
+}
+
+static char *cdict_origin(struct Curl_easy *data)
+{
+  return aprintf("%s://%s:%s", data->state.up.scheme,
+                 data->state.up.hostname, data->state.up.port);
+}
+
+/* Match 'path' against 'pattern' where '*' matches any sequence */
+static bool cdict_match(const char *pattern, const char *path)
+{
+  const char *star_pattern = NULL;
+  const char *star_path = NULL;
+
+  while(*path) {
+    if(*pattern == '*') {
+      star_pattern = ++pattern;
+      star_path = path;
+    }
+    else if(*pattern == *path) {
+      pattern++;
+      path++;
+    }
+    else if(star_pattern) {
+      pattern = star_pattern;
+      path = ++star_path;
+    }
+    else
+      return FALSE;
+  }
+  while(*pattern == '*')
+    pattern++;
+  return !*pattern;
+}
+
+CURLcode Curl_cdict_select(struct Curl_easy *data)
+{
+  struct Curl_llist_node *e;
+  struct cdict *best = NULL;
+  size_t bestlen = 0;
+  char *origin = NULL;
+  CURLcode result;
+
+  data->req.cdict = NULL;
+  if(!data->set.str[STRING_ENCODING] || data->set.http_ce_skip ||
+     !Curl_dict_encodings() ||
+     Curl_checkheaders(data, STRCONST("Available-Dictionary")))
+    return CURLE_OK;
+
+  result = cdict_app_sync(data);
+  if(result || !data->cdicts)
+    return result;
+
+  if(cdict_secure(data)) {
+    origin = cdict_origin(data);
+    if(!origin)
+      return CURLE_OUT_OF_MEMORY;
+  }
+
+  /* the most specific match wins, the most recent one on a tie */
+  for(e = Curl_llist_head(&data->cdicts->list); e; e = Curl_node_next(e)) {
+    struct cdict *d = Curl_node_elem(e);
+    size_t mlen;
+    if(d->origin && (!origin || strcmp(d->origin, origin)))
+      continue;
+    if(!cdict_match(d->match, data->state.up.path))
+      continue;
+    mlen = strlen(d->match);
+    if(!best || (mlen >= bestlen)) {
+      best = d;
+      bestlen = mlen;
+    }
+  }
+  free(origin);
+
+  data->req.cdict = best;
+  if(best)
+    infof(data, "Offering compression dictionary for '%s'", best->match);
+  return CURLE_OK;
+}
+
+const char *Curl_cdict_accept(struct Curl_easy *data)
+{
+  return data->req.cdict ? Curl_dict_encodings() : NULL;
+}
+
+CURLcode Curl_cdict_add_headers(struct Curl_easy *data, struct dynbuf *req)
+{
+  const struct cdict *d = data->req.cdict;
+  char *b64;
+  size_t blen;
+  CURLcode result;
+
+  if(!d)
+    return CURLE_OK;
+
+  result = curlx_base64_encode((const char *)d->hash, sizeof(d->hash),
+                               &b64, &blen);
+  if(result)
+    return result;
+  /* the hash is sent as a structured field byte sequence */
+  result = curlx_dyn_addf(req, "Available-Dictionary: :%s:\r\n", b64);
+  free(b64);
+  if(!result && d->id && !Curl_checkheaders(data, STRCONST("Dictionary-ID")))
+    result = curlx_dyn_addf(req, "Dictionary-ID: \"%s\"\r\n", d->id);
+  return result;
+}
+
+/*
+ * Client writer collecting a response body to use as a dictionary once it
+ * has been received in full.
+ */
+struct cw_cdict_ctx {
+  struct Curl_cwriter super;
+  struct dynbuf body;
+  char *origin;
+  char *match;
+  char *id;
+  BIT(failed);
+};
+
+static CURLcode cw_cdict_init(struct Curl_easy *data,
+                              struct Curl_cwriter *writer)
+{
+  struct cw_cdict_ctx *ctx = writer->ctx;
+  (void)data;
+  curlx_dyn_init(&ctx->body, MAX_CDICT_SIZE);
+  return CURLE_OK;
+}
+
+static CURLcode cw_cdict_write(struct Curl_easy *data,
+                               struct Curl_cwriter *writer, int type,
+                               const char *buf, size_t nbytes)
+{
+  struct cw_cdict_ctx *ctx = writer->ctx;
+
+  if((type & CLIENTWRITE_BODY) && nbytes && !ctx->failed &&
+     curlx_dyn_addn(&ctx->body, buf, nbytes)) {
+    /* too large or out of memory, do not use it as a dictionary */
+    infof(data, "Response not stored as compression dictionary");
+    ctx->failed = TRUE;
+  }
+  return Curl_cwriter_write(data, writer->next, type, buf, nbytes);
+}
+
+static void cw_cdict_close(struct Curl_easy *data,
+                           struct Curl_cwriter *writer)
+{
+  struct cw_cdict_ctx *ctx = writer->ctx;
+  (void)data;
+  curlx_dyn_free(&ctx->body);
+  free(ctx->origin);
+  free(ctx->match);
+  free(ctx->id);
+}
+
+static const struct Curl_cwtype cw_cdict = {
+  "cw-cdict",
+  NULL,
+  cw_cdict_init,
+  cw_cdict_write,
+  cw_cdict_close,
+  sizeof(struct cw_cdict_ctx)
+};
+
+/*
+ * Get the next value in a structured field dictionary. Strings are returned
+ * without the quotes, escapes are kept. Inner lists are returned as-is.
+ */
+static bool sf_value(const char **pp, struct Curl_str *out, bool *is_string)
+{
+  const char *p = *pp;
+  const char *start = p;
+
+  *is_string = FALSE;
+  if(*p == '"') {
+    start = ++p;
+    while(*p != '"') {
+      if(!*p || ((*p == '\\') && !*++p))
+        return FALSE;
+      p++;
+    }
+    curlx_str_assign(out, start, p - start);
+    *pp = p + 1;
+    *is_string = TRUE;
+    return TRUE;
+  }
+  if(*p == '(') {
+    while(*p != ')') {
+      if(*p == '"') {
+        struct Curl_str skip;
+        bool str;
+        if(!sf_value(&p, &skip, &str))
+          return FALSE;
+        continue;
+      }
+      if(!*p)
+        return FALSE;
+      p++;
+    }
+    p++;
+  }
+  else
+    while(*p && !strchr(",; \t\r\n", *p))
+      p++;
+  curlx_str_assign(out, start, p - start);
+  *pp = p;
+  return p > start;
+}
+
+/* Get a key and optional value. A key without value is a boolean true. */
+static bool sf_member(const char **pp, struct Curl_str *key,
+                      struct Curl_str *val, bool *is_string)
+{
+  const char *p = *pp;
+  const char *start = p;
+
+  while(ISLOWER(*p) || ISDIGIT(*p) || (*p && strchr("_-.*", *p)))
+    p++;
+  if(p == start)
+    return FALSE;
+  curlx_str_assign(key, start, p - start);
+  curlx_str_init(val);
+  *is_string = FALSE;
+  if((*p == '=') && (p++, !sf_value(&p, val, is_string)))
+    return FALSE;
+  *pp = p;
+  return TRUE;
+}
+
+/*
+ * Parse a Use-As-Dictionary: header value, as in
+ *
+ *   match="/assets/app-*.js", id="app-v1", type=raw
+ *
+ * and if acceptable, collect the response body to use as a dictionary.
+ */
+CURLcode Curl_cdict_parse(struct Curl_easy *data, const char *value)
+{
+  struct Curl_str match;
+  struct Curl_str id;
+  struct Curl_cwriter *writer = NULL;
+  struct cw_cdict_ctx *ctx;
+  const char *p = value;
+  CURLcode result;
+
+  curlx_str_init(&match);
+  curlx_str_init(&id);
+
+  if(!cdict_secure(data) || data->set.http_ce_skip ||
+     Curl_cwriter_get_by_type(data, &cw_cdict))
+    return CURLE_OK;
+
+  for(;;) {
+    struct Curl_str key;
+    struct Curl_str val;
+    bool is_string;
+
+    curlx_str_passblanks(&p);
+    if(!sf_member(&p, &key, &val, &is_string))
+      goto bad;
+    /* parameters are not used */
+    while(*p == ';') {
+      struct Curl_str pkey;
+      struct Curl_str pval;
+      bool pstring;
+      p++;
+      curlx_str_passblanks(&p);
+      if(!sf_member(&p, &pkey, &pval, &pstring))
+        goto bad;
+    }
+    if(curlx_str_cmp(&key, "match") && is_string)
+      match = val;
+    else if(curlx_str_cmp(&key, "id") && is_string)
+      id = val;
+    else if(curlx_str_cmp(&key, "type") && !curlx_str_cmp(&val, "raw")) {
+      infof(data, "Use-As-Dictionary: type not supported");
+      return CURLE_OK;
+    }
+    curlx_str_passblanks(&p);
+    if(!*p || ISNEWLINE(*p))
+      break;
+    if(*p++ != ',')
+      goto bad;
+  }
+
+  /* only plain path patterns are supported, with '*' as the wildcard */
+  if(!curlx_strlen(&match) || (curlx_strlen(&match) > MAX_CDICT_MATCHLEN) ||
+     (curlx_strlen(&id) > MAX_CDICT_IDLEN) || (curlx_str(&match)[0] != '/'))
+    goto bad;
+  for(p = curlx_str(&match); p < curlx_str(&match) + curlx_strlen(&match);
+      p++) {
+    if(strchr(":{}()+?\\", *p))
+      goto bad;
+  }
+
+  result = Curl_cwriter_create(&writer, data, &cw_cdict, CURL_CW_CLIENT);
+  if(result)
+    return result;
+  ctx = writer->ctx;
+  ctx->origin = cdict_origin(data);
+  ctx->match = Curl_memdup0(curlx_str(&match), curlx_strlen(&match));
+  if(curlx_strlen(&id))
+    ctx->id = Curl_memdup0(curlx_str(&id), curlx_strlen(&id));
+  if(!ctx->origin || !ctx->match || (curlx_strlen(&id) && !ctx->id))
+    result = CURLE_OUT_OF_MEMORY;
+  else
+    result = Curl_cwriter_add(data, writer);
+  if(result)
+    Curl_cwriter_free(data, writer);
+  return result;
+
+bad:
+  infof(data, "Use-As-Dictionary: header ignored");
+  return CURLE_OK;
+}
+
+CURLcode Curl_cdict_done(struct Curl_easy *data, bool premature)
+{
+  struct Curl_cwriter *writer = Curl_cwriter_get_by_type(data, &cw_cdict);
+  struct cw_cdict_ctx *ctx;
+  unsigned char *dict;
+  size_t len;
+  CURLcode result;
+
+  if(!writer)
+    return CURLE_OK;
+  ctx = writer->ctx;
+  if(premature || ctx->failed || !data->req.download_done ||
+     !curlx_dyn_len(&ctx->body))
+    return CURLE_OK;
+
+  if(!data->cdicts) {
+    data->cdicts = Curl_cdict_init();
+    if(!data->cdicts)
+      return CURLE_OUT_OF_MEMORY;
+  }
+  dict = (unsigned char *)curlx_dyn_take(&ctx->body, &len);
+  infof(data, "Stored %zu bytes compression dictionary for '%s'",
+        len, ctx->match);
+  result = cdict_add(data, data->cdicts, ctx->origin, ctx->match, ctx->id,
+                     dict, len);
+  ctx->origin = ctx->match = ctx->id = NULL; /* now owned by the cache */
+  ctx->failed = TRUE; /* done */
+  return result;
+}
+
+#endif /* USE_COMPRESSION_DICT */
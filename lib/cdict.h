@@ -0,0 +1,73 @@
+#ifndef HEADER_CURL_CDICT_H
+#define HEADER_CURL_CDICT_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+
+#ifdef USE_COMPRESSION_DICT
+#include <curl/curl.h>
+#include "llist.h"
+#include "curl_sha256.h"
+
+struct dynbuf;
+
+/* A compression dictionary, RFC 9842 */
+struct cdict {
+  struct Curl_llist_node node;
+  char *origin;  /* "scheme://host:port" it is for, NULL for all origins */
+  char *match;   /* path pattern, '*' matches any sequence */
+  char *id;      /* Dictionary-ID to send, NULL if none */
+  unsigned char *data;
+  size_t len;
+  unsigned char hash[CURL_SHA256_DIGEST_LENGTH];
+};
+
+struct cdictinfo {
+  struct Curl_llist list; /* dictionaries, the oldest first */
+  size_t total;           /* sum of the learned dictionary sizes */
+  BIT(app_set);           /* the application dictionary is in the list */
+};
+
+struct cdictinfo *Curl_cdict_init(void);
+void Curl_cdict_cleanup(struct cdictinfo **cdictp);
+/* forget the dictionary built from CURLOPT_COMPRESSION_DICT_BLOB */
+void Curl_cdict_app_reset(struct cdictinfo *ci);
+/* pick the dictionary to offer in the upcoming request */
+CURLcode Curl_cdict_select(struct Curl_easy *data);
+/* the dictionary content encodings to accept, or NULL */
+const char *Curl_cdict_accept(struct Curl_easy *data);
+CURLcode Curl_cdict_add_headers(struct Curl_easy *data, struct dynbuf *req);
+/* handle a Use-As-Dictionary: response header */
+CURLcode Curl_cdict_parse(struct Curl_easy *data, const char *value);
+/* store the collected response body as a dictionary if it is complete */
+CURLcode Curl_cdict_done(struct Curl_easy *data, bool premature);
+#else
+/* disabled */
+#define Curl_cdict_cleanup(x) Curl_nop_stmt
+#define Curl_cdict_select(x) CURLE_OK
+#define Curl_cdict_accept(x) NULL
+#define Curl_cdict_add_headers(x,y) CURLE_OK
+#define Curl_cdict_done(x,y) CURLE_OK
+#endif /* USE_COMPRESSION_DICT */
+#endif /* HEADER_CURL_CDICT_H */
@@ -60,6 +60,9 @@
 /* Required for __DragonFly_version */
 #include <sys/param.h>
 #endif
+#ifdef USE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 
 #include "urldata.h"
 #include "bufq.h"
@@ -2263,3 +2266,62 @@ CURLcode Curl_cf_socket_peek(struct Curl_cfilter *cf,
   }
   return CURLE_FAILED_INIT;
 }
+
+CURLcode Curl_cf_socket_sendfile(struct Curl_cfilter *cf,
+                                 struct Curl_easy *data,
+                                 int fd, curl_off_t offset, size_t len,
+                                 size_t *pnwritten)
+{
+#ifdef USE_SENDFILE
+  struct cf_socket_ctx *ctx = cf->ctx;
+  off_t off = (off_t)offset;
+  ssize_t nwritten;
+  CURLcode result = CURLE_OK;
+
+  *pnwritten = 0;
+  if(!ctx || cf->cft == &Curl_cft_udp || !cf_is_socket(cf) ||
+     cf->conn->bits.tcp_fastopen)
+    return CURLE_NOT_BUILT_IN;
+#ifdef DEBUGBUILD
+  /* simulated blocking and partial writes are done on send() only */
+  if(ctx->wblock_percent > 0 || ctx->wpartial_percent > 0)
+    return CURLE_NOT_BUILT_IN;
+#endif
+
+  nwritten = sendfile(ctx->sock, fd, &off, len);
+  if(nwritten < 0) {
+    int err = errno;
+
+    if((SOCKEWOULDBLOCK == err) || (EAGAIN == err) || (SOCKEINTR == err))
+      result = CURLE_OK; /* blocked, nothing sent */
+    else if((SOCKEINVAL == err) || (ENOSYS == err) || (EOVERFLOW == err) ||
+            (ESPIPE == err))
+      /* not for this kind of file, read it instead */
+      result = CURLE_NOT_BUILT_IN;
+    else {
+      char buffer[STRERROR_LEN];
+      failf(data, "Send failure: %s",
+            Curl_strerror(err, buffer, sizeof(buffer)));
+      data->state.os_errno = err;
+      result = CURLE_SEND_ERROR;
+    }
+  }
+  else if(!nwritten && len)
+    /* the file ended early, have the regular read report it */
+    result = CURLE_NOT_BUILT_IN;
+  else
+    *pnwritten = (size_t)nwritten;
+
+  CURL_TRC_CF(data, cf, "sendfile(len=%zu) -> %d, %zu",
+              len, result, *pnwritten);
+  return result;
+#else
+  (void)cf;
+  (void)data;
+  (void)fd;
+  (void)offset;
+  (void)len;
+  *pnwritten = 0;
+  return CURLE_NOT_BUILT_IN;
+#endif
+}
@@ -159,6 +159,17 @@ CURLcode Curl_cf_socket_peek(struct Curl_cfilter *cf,
                              const struct Curl_sockaddr_ex **paddr,
                              struct ip_quadruple *pip);
 
+/**
+ * Send `len` bytes from file `fd`, starting at `offset`, with sendfile()
+ * on the socket of filter `cf`.
+ * Returns CURLE_NOT_BUILT_IN if the filter, the platform or the file do
+ * not support it.
+ */
+CURLcode Curl_cf_socket_sendfile(struct Curl_cfilter *cf,
+                                 struct Curl_easy *data,
+                                 int fd, curl_off_t offset, size_t len,
+                                 size_t *pnwritten);
+
 extern struct Curl_cftype Curl_cft_tcp;
 extern struct Curl_cftype Curl_cft_udp;
 extern struct Curl_cftype Curl_cft_unix;
@@ -27,6 +27,7 @@
 #include "urldata.h"
 #include "strerror.h"
 #include "cfilters.h"
+#include "cf-socket.h"
 #include "connect.h"
 #include "url.h"
 #include "sendf.h"
@@ -1146,3 +1147,26 @@ CURLcode Curl_conn_send(struct Curl_easy *data, int sockindex,
   *pnwritten = 0;
   return CURLE_FAILED_INIT;
 }
+
+CURLcode Curl_conn_sendfile(struct Curl_easy *data, int sockindex,
+                            int fd, curl_off_t offset, size_t len,
+                            size_t *pnwritten)
+{
+  struct Curl_cfilter *cf;
+
+  *pnwritten = 0;
+  DEBUGASSERT(data);
+  DEBUGASSERT(data->conn);
+  if(!CONN_SOCK_IDX_VALID(sockindex) ||
+     data->conn->send[sockindex] != Curl_cf_send)
+    return CURLE_NOT_BUILT_IN;
+  /* Filters without a type only help to connect and pass everything
+   * through once they are. Below them, the socket needs to be the
+   * last filter. */
+  cf = data->conn->cfilter[sockindex];
+  while(cf && cf->connected && !cf->cft->flags)
+    cf = cf->next;
+  if(!cf || !cf->connected || cf->next)
+    return CURLE_NOT_BUILT_IN;
+  return Curl_cf_socket_sendfile(cf, data, fd, offset, len, pnwritten);
+}
@@ -632,6 +632,18 @@ CURLcode Curl_conn_send(struct Curl_easy *data, int sockindex,
                         const void *buf, size_t blen, bool eos,
                         size_t *pnwritten);
 
+/*
+ * Send `len` bytes of the file `fd`, starting at `offset`, on the
+ * connection without copying them through a buffer. This is only
+ * possible when the connection is a plain socket that sends all
+ * bytes unchanged.
+ * Returns CURLE_OK, also when blocked and nothing was sent, and
+ * CURLE_NOT_BUILT_IN when the connection or the file do not allow this.
+ */
+CURLcode Curl_conn_sendfile(struct Curl_easy *data, int sockindex,
+                            int fd, curl_off_t offset, size_t len,
+                            size_t *pnwritten);
+
 
 /**
  * Types and macros used to keep the current easy handle in filter calls,
@@ -78,6 +78,7 @@
 /* A list of connections to the same destination. */
 struct cpool_bundle {
   struct Curl_llist conns; /* connections in the bundle */
+  struct Curl_llist idle; /* idle ones, the least recently used first */
   size_t dest_len; /* total length of destination, including NUL */
   char *dest[1]; /* destination of bundle, allocated to keep dest_len bytes */
 };
@@ -97,6 +98,7 @@ static struct cpool_bundle *cpool_bundle_create(const char *dest)
   if(!bundle)
     return NULL;
   Curl_llist_init(&bundle->conns, NULL);
+  Curl_llist_init(&bundle->idle, NULL);
   bundle->dest_len = dest_len + 1;
   memcpy(bundle->dest, dest, bundle->dest_len);
   return bundle;
@@ -105,6 +107,7 @@ static struct cpool_bundle *cpool_bundle_create(const char *dest)
 static void cpool_bundle_destroy(struct cpool_bundle *bundle)
 {
   DEBUGASSERT(!Curl_llist_count(&bundle->conns));
+  DEBUGASSERT(!Curl_llist_count(&bundle->idle));
   free(bundle);
 }
 
@@ -127,6 +130,61 @@ static void cpool_bundle_remove(struct cpool_bundle *bundle,
   conn->bits.in_cpool = FALSE;
 }
 
+/*
+ * The idle lists keep connections in the order they became idle. A
+ * connection that gets used again is not removed right away, it is dropped
+ * when found at the head of a list or appended again when idle once more.
+ */
+static void cpool_idle_remove(struct connectdata *conn)
+{
+  if(Curl_node_llist(&conn->idle_node))
+    Curl_node_remove(&conn->idle_node);
+  if(Curl_node_llist(&conn->bundle_idle_node))
+    Curl_node_remove(&conn->bundle_idle_node);
+}
+
+static void cpool_idle_add(struct cpool *cpool,
+                           struct cpool_bundle *bundle,
+                           struct connectdata *conn)
+{
+  cpool_idle_remove(conn);
+  Curl_llist_append(&cpool->idle, conn, &conn->idle_node);
+  if(bundle)
+    Curl_llist_append(&bundle->idle, conn, &conn->bundle_idle_node);
+}
+
+/* Insert a connection into an idle list, keeping it ordered by the time the
+   connections were last used */
+static void cpool_idle_insert(struct Curl_llist *idle,
+                              struct connectdata *conn,
+                              struct Curl_llist_node *node)
+{
+  struct Curl_llist_node *n = Curl_llist_tail(idle);
+
+  while(n) {
+    struct connectdata *c = Curl_node_elem(n);
+    if(curlx_timediff(conn->lastused, c->lastused) >= 0)
+      break;
+    n = Curl_node_prev(n);
+  }
+  Curl_llist_insert_next(idle, n, conn, node);
+}
+
+/* Return the least recently used connection that may be discarded */
+static struct connectdata *cpool_idle_oldest(struct Curl_llist *idle)
+{
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(idle); n; n = Curl_llist_head(idle)) {
+    struct connectdata *conn = Curl_node_elem(n);
+    if(!CONN_INUSE(conn) && !conn->bits.close && !conn->connect_only)
+      return conn;
+    /* in use again or not to be reused, no longer idle */
+    cpool_idle_remove(conn);
+  }
+  return NULL;
+}
+
 static void cpool_bundle_free_entry(void *freethis)
 {
   cpool_bundle_destroy((struct cpool_bundle *)freethis);
@@ -139,6 +197,7 @@ void Curl_cpool_init(struct cpool *cpool,
 {
   Curl_hash_init(&cpool->dest2bundle, size, Curl_hash_str,
                  curlx_str_key_compare, cpool_bundle_free_entry);
+  Curl_llist_init(&cpool->idle, NULL);
 
   DEBUGASSERT(idata);
 
@@ -189,6 +248,7 @@ static void cpool_remove_conn(struct cpool *cpool,
 {
   struct Curl_llist *list = Curl_node_llist(&conn->cpool_node);
   DEBUGASSERT(cpool);
+  cpool_idle_remove(conn);
   if(list) {
     /* The connection is certainly in the pool, but where? */
     struct cpool_bundle *bundle = cpool_find_bundle(cpool, conn);
@@ -283,71 +343,6 @@ cpool_add_bundle(struct cpool *cpool, struct connectdata *conn)
   return bundle;
 }
 
-static struct connectdata *
-cpool_bundle_get_oldest_idle(struct cpool_bundle *bundle)
-{
-  struct Curl_llist_node *curr;
-  timediff_t highscore = -1;
-  timediff_t score;
-  struct curltime now;
-  struct connectdata *oldest_idle = NULL;
-  struct connectdata *conn;
-
-  now = curlx_now();
-  curr = Curl_llist_head(&bundle->conns);
-  while(curr) {
-    conn = Curl_node_elem(curr);
-
-    if(!CONN_INUSE(conn)) {
-      /* Set higher score for the age passed since the connection was used */
-      score = curlx_timediff(now, conn->lastused);
-
-      if(score > highscore) {
-        highscore = score;
-        oldest_idle = conn;
-      }
-    }
-    curr = Curl_node_next(curr);
-  }
-  return oldest_idle;
-}
-
-static struct connectdata *cpool_get_oldest_idle(struct cpool *cpool)
-{
-  struct Curl_hash_iterator iter;
-  struct Curl_llist_node *curr;
-  struct Curl_hash_element *he;
-  struct connectdata *oldest_idle = NULL;
-  struct cpool_bundle *bundle;
-  struct curltime now;
-  timediff_t highscore =- 1;
-  timediff_t score;
-
-  now = curlx_now();
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
-
-  for(he = Curl_hash_next_element(&iter); he;
-      he = Curl_hash_next_element(&iter)) {
-    struct connectdata *conn;
-    bundle = he->ptr;
-
-    for(curr = Curl_llist_head(&bundle->conns); curr;
-        curr = Curl_node_next(curr)) {
-      conn = Curl_node_elem(curr);
-      if(CONN_INUSE(conn) || conn->bits.close || conn->connect_only)
-        continue;
-      /* Set higher score for the age passed since the connection was used */
-      score = curlx_timediff(now, conn->lastused);
-      if(score > highscore) {
-        highscore = score;
-        oldest_idle = conn;
-      }
-    }
-  }
-  return oldest_idle;
-}
-
-
 int Curl_cpool_check_limits(struct Curl_easy *data,
                             struct connectdata *conn)
 {
@@ -388,7 +383,7 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
         struct connectdata *oldest_idle = NULL;
         /* The bundle is full. Extract the oldest connection that may
          * be removed now, if there is one. */
-        oldest_idle = cpool_bundle_get_oldest_idle(bundle);
+        oldest_idle = cpool_idle_oldest(&bundle->idle);
         if(!oldest_idle)
           break;
         /* disconnect the old conn and continue */
@@ -419,7 +414,7 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
           break;
       }
       else {
-        struct connectdata *oldest_idle = cpool_get_oldest_idle(cpool);
+        struct connectdata *oldest_idle = cpool_idle_oldest(&cpool->idle);
         if(!oldest_idle)
           break;
         /* disconnect the old conn and continue */
@@ -523,6 +518,16 @@ static bool cpool_foreach(struct Curl_easy *data,
   return FALSE;
 }
 
+/* Have the pool's internal handle run the upkeep `ms` from now */
+static void cpool_upkeep_arm(struct cpool *cpool,
+                             const struct curltime *nowp,
+                             timediff_t ms)
+{
+  cpool->upkeep_start = *nowp;
+  cpool->upkeep_ms = ms;
+  Curl_expire_ex(cpool->idata, nowp, ms, EXPIRE_UPKEEP);
+}
+
 /*
  * A connection (already in the pool) has become idle. Do any
  * cleanups in regard to the pool's limits.
@@ -539,21 +544,36 @@ bool Curl_cpool_conn_now_idle(struct Curl_easy *data,
   bool kept = TRUE;
 
   conn->lastused = curlx_now(); /* it was used up until now */
-  if(cpool && maxconnects) {
+  if(cpool) {
     /* may be called form a callback already under lock */
     bool do_lock = !CPOOL_IS_LOCKED(cpool);
     if(do_lock)
       CPOOL_LOCK(cpool, data);
-    if(cpool->num_conn > maxconnects) {
+    if(conn->bits.in_cpool)
+      cpool_idle_add(cpool, cpool_find_bundle(cpool, conn), conn);
+    if(maxconnects && (cpool->num_conn > maxconnects)) {
       infof(data, "Connection pool is full, closing the oldest of %zu/%u",
             cpool->num_conn, maxconnects);
 
-      oldest_idle = cpool_get_oldest_idle(cpool);
+      oldest_idle = cpool_idle_oldest(&cpool->idle);
       kept = (oldest_idle != conn);
       if(oldest_idle) {
         Curl_conn_terminate(data, oldest_idle, FALSE);
       }
     }
+    if(kept && conn->bits.in_cpool)
+      /* learn about the connection closing from socket events */
+      (void)Curl_multi_ev_watch_idle(cpool->idata->multi, cpool->idata,
+                                     conn, TRUE);
+    if(kept && cpool->upkeep && conn->bits.in_cpool) {
+      /* the connection was just in use, it needs no upkeep before the
+       * interval has passed. Any connection that became idle earlier is
+       * due before it, so an already set timer stays as it is. */
+      conn->keepalive = conn->lastused;
+      if(!cpool->upkeep_ms)
+        cpool_upkeep_arm(cpool, &conn->lastused,
+                         cpool->idata->set.upkeep_interval_ms + 1);
+    }
     if(do_lock)
       CPOOL_UNLOCK(cpool, data);
   }
@@ -701,47 +721,63 @@ void Curl_conn_terminate(struct Curl_easy *data,
 }
 
 
-struct cpool_reaper_ctx {
-  struct curltime now;
-};
-
-static int cpool_reap_dead_cb(struct Curl_easy *data,
-                              struct connectdata *conn, void *param)
+/*
+ * Close the connections that have been idle for too long. They are at the
+ * head of the idle list, so this stops at the first one that is not.
+ */
+static void cpool_prune_idle(struct Curl_easy *data, struct cpool *cpool,
+                             struct curltime now)
 {
-  struct cpool_reaper_ctx *rctx = param;
-  if((!CONN_INUSE(conn) && conn->bits.no_reuse) ||
-     Curl_conn_seems_dead(conn, data, &rctx->now)) {
-    /* stop the iteration here, pass back the connection that was pruned */
+  struct connectdata *conn;
+
+  if(!data->set.conn_max_idle_ms)
+    return;
+  for(conn = cpool_idle_oldest(&cpool->idle); conn;
+      conn = cpool_idle_oldest(&cpool->idle)) {
+    if(curlx_timediff(now, conn->lastused) <= data->set.conn_max_idle_ms)
+      break;
     Curl_conn_terminate(data, conn, FALSE);
-    return 1;
   }
-  return 0; /* continue iteration */
 }
 
 /*
- * This function scans the data's connection pool for half-open/dead
- * connections, closes and removes them.
- * The cleanup is done at most once per second.
+ * This function closes and removes the connections in the data's pool that
+ * have been idle for too long. Once per second, it also checks the idle
+ * connections for half-open/dead ones.
  *
  * When called, this transfer has no connection attached.
  */
 void Curl_cpool_prune_dead(struct Curl_easy *data)
 {
   struct cpool *cpool = cpool_get_instance(data);
-  struct cpool_reaper_ctx rctx;
+  struct curltime now;
   timediff_t elapsed;
 
   if(!cpool)
     return;
 
-  rctx.now = curlx_now();
+  now = curlx_now();
   CPOOL_LOCK(cpool, data);
-  elapsed = curlx_timediff(rctx.now, cpool->last_cleanup);
+  cpool_prune_idle(data, cpool, now);
+  elapsed = curlx_timediff(now, cpool->last_cleanup);
 
   if(elapsed >= 1000L) {
-    while(cpool_foreach(data, cpool, &rctx, cpool_reap_dead_cb))
-      ;
-    cpool->last_cleanup = rctx.now;
+    struct Curl_llist_node *n = Curl_llist_head(&cpool->idle);
+    while(n) {
+      struct connectdata *conn = Curl_node_elem(n);
+      /* get the next one now, the connection might be removed */
+      n = Curl_node_next(n);
+      if(CONN_INUSE(conn))
+        cpool_idle_remove(conn);
+      else if(conn->bits.no_reuse ||
+              Curl_conn_seems_dead(conn, data, &now))
+        Curl_conn_terminate(data, conn, FALSE);
+      else if(!conn->bits.idle_watched)
+        /* alive after it signalled, watch it again */
+        (void)Curl_multi_ev_watch_idle(cpool->idata->multi, cpool->idata,
+                                       conn, TRUE);
+    }
+    cpool->last_cleanup = now;
   }
   CPOOL_UNLOCK(cpool, data);
 }
@@ -769,6 +805,165 @@ CURLcode Curl_cpool_upkeep(void *data)
   return CURLE_OK;
 }
 
+void Curl_cpool_upkeep_auto(struct Curl_easy *data, timediff_t interval_ms)
+{
+  struct cpool *cpool = cpool_get_instance(data);
+
+  if(!cpool)
+    return;
+
+  CPOOL_LOCK(cpool, data);
+  cpool->upkeep = (interval_ms > 0);
+  if(cpool->upkeep) {
+    struct curltime now = curlx_now();
+    data->set.upkeep_interval_ms = (long)interval_ms;
+    /* check the connections that are already idle soon */
+    cpool_upkeep_arm(cpool, &now, 1);
+  }
+  else {
+    cpool->upkeep_ms = 0;
+    Curl_expire_done(data, EXPIRE_UPKEEP);
+  }
+  CPOOL_UNLOCK(cpool, data);
+}
+
+void Curl_cpool_upkeep_timer(struct Curl_easy *data)
+{
+  struct cpool *cpool = cpool_get_instance(data);
+  struct Curl_llist_node *n;
+  struct curltime now;
+  timediff_t next_ms = 0;
+
+  if(!cpool || !cpool->upkeep_ms)
+    return;
+  now = curlx_now();
+  if(curlx_timediff(now, cpool->upkeep_start) < cpool->upkeep_ms)
+    return;
+
+  CPOOL_LOCK(cpool, data);
+  cpool->upkeep_ms = 0;
+  n = Curl_llist_head(&cpool->idle);
+  while(n) {
+    struct connectdata *conn = Curl_node_elem(n);
+    timediff_t left_ms;
+    /* get the next one now, the connection might be removed */
+    n = Curl_node_next(n);
+    if(CONN_INUSE(conn)) {
+      cpool_idle_remove(conn);
+      continue;
+    }
+    if(conn->bits.close || conn->connect_only)
+      continue;
+    if(Curl_conn_upkeep(data, conn, &now)) {
+      infof(data, "Connection #%" FMT_OFF_T " failed upkeep, closing",
+            conn->connection_id);
+      Curl_conn_terminate(data, conn, FALSE);
+      continue;
+    }
+    /* Curl_conn_upkeep() acts once the interval is exceeded */
+    left_ms = data->set.upkeep_interval_ms -
+      curlx_timediff(now, conn->keepalive) + 1;
+    if(!next_ms || (left_ms < next_ms))
+      next_ms = left_ms;
+  }
+  if(next_ms)
+    cpool_upkeep_arm(cpool, &now, next_ms);
+  CPOOL_UNLOCK(cpool, data);
+}
+
+/* Can `conn` be moved to another pool? Only idle TCP connections to the
+   given origin can. */
+static bool cpool_conn_movable(struct Curl_easy *data,
+                               struct connectdata *conn,
+                               const char *scheme,
+                               const char *host,
+                               int port)
+{
+  if(CONN_INUSE(conn) || conn->bits.close || conn->connect_only ||
+     !conn->bits.in_cpool)
+    return FALSE;
+  if(scheme && (!curl_strequal(conn->handler->scheme, scheme) ||
+                !curl_strequal(conn->host.name, host) ||
+                (conn->remote_port != port)))
+    return FALSE;
+  if(Curl_conn_get_transport(data, conn) != TRNSPRT_TCP)
+    return FALSE;
+  return !Curl_conn_seems_dead(conn, data, NULL);
+}
+
+CURLcode Curl_cpool_handoff(struct Curl_easy *data,
+                            struct Curl_easy *dest,
+                            const char *scheme,
+                            const char *host,
+                            int port,
+                            unsigned int max,
+                            unsigned int *pmoved)
+{
+  struct cpool *src = cpool_get_instance(data);
+  struct cpool *dst = cpool_get_instance(dest);
+  struct Curl_multi *dmulti = dest->multi;
+  struct Curl_llist_node *n;
+  CURLcode result = CURLE_OK;
+
+  *pmoved = 0;
+  if(!src || !dst || (src == dst))
+    return CURLE_OK;
+
+  CPOOL_LOCK(src, data);
+  CPOOL_LOCK(dst, dest);
+  /* the most recently used connections first */
+  n = Curl_llist_tail(&src->idle);
+  while(n && (*pmoved < max)) {
+    struct connectdata *conn = Curl_node_elem(n);
+    struct cpool_bundle *bundle;
+    curl_off_t old_id = conn->connection_id;
+
+    n = Curl_node_prev(n);
+    if(!cpool_conn_movable(data, conn, scheme, host, port))
+      continue;
+    if(dmulti->max_total_connections > 0 &&
+       dst->num_conn >= (size_t)dmulti->max_total_connections)
+      break;
+
+    bundle = cpool_find_bundle(dst, conn);
+    if(bundle) {
+      if(dmulti->max_host_connections > 0 &&
+         Curl_llist_count(&bundle->conns) >=
+         (size_t)dmulti->max_host_connections)
+        continue;
+    }
+    else {
+      bundle = cpool_add_bundle(dst, conn);
+      if(!bundle) {
+        result = CURLE_OUT_OF_MEMORY;
+        break;
+      }
+    }
+
+    cpool_remove_conn(src, conn);
+    /* the source multi no longer watches its socket */
+    Curl_multi_ev_conn_done(data->multi, data, conn);
+    conn->bits.idle_watched = FALSE;
+
+    cpool_bundle_add(bundle, conn);
+    conn->connection_id = dst->next_connection_id++;
+    dst->num_conn++;
+    cpool_idle_insert(&dst->idle, conn, &conn->idle_node);
+    cpool_idle_insert(&bundle->idle, conn, &conn->bundle_idle_node);
+    (void)Curl_multi_ev_watch_idle(dmulti, dst->idata, conn, TRUE);
+    (*pmoved)++;
+    CURL_TRC_M(data, "[CPOOL] handed off connection %" FMT_OFF_T
+               ", it is now %" FMT_OFF_T, old_id, conn->connection_id);
+  }
+  if(*pmoved && dst->upkeep && !dst->upkeep_ms) {
+    struct curltime now = curlx_now();
+    cpool_upkeep_arm(dst, &now, 1);
+  }
+  CPOOL_UNLOCK(dst, dest);
+  CPOOL_UNLOCK(src, data);
+  return result;
+}
+
 struct cpool_find_ctx {
   curl_off_t id;
   struct connectdata *conn;
@@ -51,14 +51,19 @@ void Curl_conn_terminate(struct Curl_easy *data,
 struct cpool {
    /* the pooled connections, bundled per destination */
   struct Curl_hash dest2bundle;
+  /* idle connections, the least recently used first */
+  struct Curl_llist idle;
   size_t num_conn;
   curl_off_t next_connection_id;
   curl_off_t next_easy_id;
   struct curltime last_cleanup;
+  struct curltime upkeep_start; /* when the upkeep timer was set */
+  timediff_t upkeep_ms;         /* the upkeep timer, 0 when not set */
   struct Curl_easy *idata; /* internal handle for maintenance */
   struct Curl_share *share; /* != NULL if pool belongs to share */
   BIT(locked);
   BIT(initialised);
+  BIT(upkeep); /* do upkeep on idle connections without being asked */
 };
 
 /* Init the pool, pass multi only if pool is owned by it.
@@ -141,6 +146,19 @@ void Curl_cpool_prune_dead(struct Curl_easy *data);
  */
 CURLcode Curl_cpool_upkeep(void *data);
 
+/**
+ * Make the pool do upkeep on its idle connections by itself, every
+ * `interval_ms` milliseconds per connection. 0 switches it off.
+ * `data` is the pool's internal handle.
+ */
+void Curl_cpool_upkeep_auto(struct Curl_easy *data, timediff_t interval_ms);
+
+/**
+ * Perform the automatic upkeep on the idle connections that are due, when
+ * the upkeep timer has expired. `data` is the pool's internal handle.
+ */
+void Curl_cpool_upkeep_timer(struct Curl_easy *data);
+
 typedef void Curl_cpool_conn_do_cb(struct connectdata *conn,
                                    struct Curl_easy *data,
                                    void *cbdata);
@@ -163,6 +181,20 @@ void Curl_cpool_do_locked(struct Curl_easy *data,
                           struct connectdata *conn,
                           Curl_cpool_conn_do_cb *cb, void *cbdata);
 
+/**
+ * Move up to `max` idle connections from the pool of `data` to the pool of
+ * `dest`, both the internal handle of their multi. With `scheme` set, only
+ * connections to the origin of `scheme`, `host` and `port` are moved.
+ * The number of moved connections is returned in `pmoved`.
+ */
+CURLcode Curl_cpool_handoff(struct Curl_easy *data,
+                            struct Curl_easy *dest,
+                            const char *scheme,
+                            const char *host,
+                            int port,
+                            unsigned int max,
+                            unsigned int *pmoved);
+
 /* Close all unused connections, prevent reuse of existing ones. */
 void Curl_cpool_nw_changed(struct Curl_easy *data);
 
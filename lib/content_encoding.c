@@ -51,6 +51,7 @@
 #include "sendf.h"
 #include "http.h"
 #include "content_encoding.h"
+#include "cdict.h"
 #include "strdup.h"
 
 /* The last 3 #include files should be in this order */
@@ -69,6 +70,57 @@
 #define DECOMPRESS_BUFFER_SIZE 16384 /* buffer size for decompressed data */
 #endif
 
+#ifdef USE_COMPRESSION_DICT
+#if defined(HAVE_BROTLI) && defined(SHARED_BROTLI_MAX_COMPOUND_DICTS)
+/* brotli 1.1.0 or later, able to use a raw dictionary */
+#define USE_DCB
+#endif
+#if defined(HAVE_ZSTD) && (ZSTD_VERSION_NUMBER >= 10400)
+#define USE_DCZ
+#endif
+#endif
+
+#if defined(USE_DCB) || defined(USE_DCZ)
+/* Dictionary-compressed content starts with a magic number followed by the
+ * SHA-256 hash of the dictionary, RFC 9842 section 4 */
+#ifdef USE_DCB
+static const unsigned char dcb_magic[] = { 0xff, 0x44, 0x43, 0x42 };
+#define DCB_HEADER_LEN (sizeof(dcb_magic) + CURL_SHA256_DIGEST_LENGTH)
+#endif
+#ifdef USE_DCZ
+static const unsigned char dcz_magic[] = {
+  0x5e, 0x2a, 0x4d, 0x18, 0x20, 0x00, 0x00, 0x00 };
+#define DCZ_HEADER_LEN (sizeof(dcz_magic) + CURL_SHA256_DIGEST_LENGTH)
+#endif
+
+/*
+ * Collect the dictionary header from the start of the content. Advances
+ * over the header bytes in `*pbuf`, leaving the compressed data.
+ */
+static CURLcode dict_header(struct Curl_easy *data,
+                            unsigned char *hdr, size_t *phdrlen,
+                            const unsigned char *magic, size_t mlen,
+                            const char **pbuf, size_t *pnbytes)
+{
+  size_t need = mlen + CURL_SHA256_DIGEST_LENGTH - *phdrlen;
+  size_t n = CURLMIN(need, *pnbytes);
+
+  memcpy(hdr + *phdrlen, *pbuf, n);
+  *phdrlen += n;
+  *pbuf += n;
+  *pnbytes -= n;
+  if(n < need)
+    return CURLE_OK;
+
+  if(memcmp(hdr, magic, mlen) || !data->req.cdict ||
+     memcmp(hdr + mlen, data->req.cdict->hash, CURL_SHA256_DIGEST_LENGTH)) {
+    failf(data, "Content compressed with an unknown dictionary");
+    return CURLE_BAD_CONTENT_ENCODING;
+  }
+  return CURLE_OK;
+}
+#endif
+
 #ifdef HAVE_LIBZ
 
 #if !defined(ZLIB_VERNUM) || (ZLIB_VERNUM < 0x1252)
@@ -93,16 +145,14 @@ struct zlib_writer {
 };
 
 
-static voidpf
-zalloc_cb(voidpf opaque, unsigned int items, unsigned int size)
+voidpf Curl_zalloc_cb(voidpf opaque, unsigned int items, unsigned int size)
 {
   (void)opaque;
   /* not a typo, keep it calloc() */
   return (voidpf) calloc(items, size);
 }
 
-static void
-zfree_cb(voidpf opaque, voidpf ptr)
+void Curl_zfree_cb(voidpf opaque, voidpf ptr)
 {
   (void)opaque;
   free(ptr);
@@ -252,8 +302,8 @@ static CURLcode deflate_do_init(struct Curl_easy *data,
   z_stream *z = &zp->z;     /* zlib state structure */
 
   /* Initialize zlib */
-  z->zalloc = (alloc_func) zalloc_cb;
-  z->zfree = (free_func) zfree_cb;
+  z->zalloc = (alloc_func) Curl_zalloc_cb;
+  z->zfree = (free_func) Curl_zfree_cb;
 
   if(inflateInit(z) != Z_OK)
     return process_zlib_error(data, z);
@@ -309,8 +359,8 @@ static CURLcode gzip_do_init(struct Curl_easy *data,
   z_stream *z = &zp->z;     /* zlib state structure */
 
   /* Initialize zlib */
-  z->zalloc = (alloc_func) zalloc_cb;
-  z->zfree = (free_func) zfree_cb;
+  z->zalloc = (alloc_func) Curl_zalloc_cb;
+  z->zfree = (free_func) Curl_zfree_cb;
 
   if(inflateInit2(z, MAX_WBITS + 32) != Z_OK)
     return process_zlib_error(data, z);
@@ -482,6 +532,59 @@ static const struct Curl_cwtype brotli_encoding = {
   brotli_do_close,
   sizeof(struct brotli_writer)
 };
+
+#ifdef USE_DCB
+/* Dictionary-compressed brotli writer. */
+struct dcb_writer {
+  struct brotli_writer bw;
+  unsigned char hdr[DCB_HEADER_LEN];
+  size_t hdrlen;
+};
+
+static CURLcode dcb_do_init(struct Curl_easy *data,
+                            struct Curl_cwriter *writer)
+{
+  struct brotli_writer *bp = (struct brotli_writer *) writer;
+  const struct cdict *d = data->req.cdict;
+  CURLcode result;
+
+  if(!d)
+    return CURLE_BAD_CONTENT_ENCODING;
+  result = brotli_do_init(data, writer);
+  if(!result &&
+     !BrotliDecoderAttachDictionary(bp->br, BROTLI_SHARED_DICTIONARY_RAW,
+                                    d->len, d->data))
+    result = CURLE_BAD_CONTENT_ENCODING;
+  return result;
+}
+
+static CURLcode dcb_do_write(struct Curl_easy *data,
+                             struct Curl_cwriter *writer, int type,
+                             const char *buf, size_t nbytes)
+{
+  struct dcb_writer *dp = (struct dcb_writer *) writer;
+
+  if(!(type & CLIENTWRITE_BODY) || !nbytes)
+    return Curl_cwriter_write(data, writer->next, type, buf, nbytes);
+
+  if(dp->hdrlen < sizeof(dp->hdr)) {
+    CURLcode result = dict_header(data, dp->hdr, &dp->hdrlen, dcb_magic,
+                                  sizeof(dcb_magic), &buf, &nbytes);
+    if(result || !nbytes)
+      return result;
+  }
+  return brotli_do_write(data, writer, type, buf, nbytes);
+}
+
+static const struct Curl_cwtype dcb_encoding = {
+  "dcb",
+  NULL,
+  dcb_do_init,
+  dcb_do_write,
+  brotli_do_close,
+  sizeof(struct dcb_writer)
+};
+#endif /* USE_DCB */
 #endif
 
 #ifdef HAVE_ZSTD
@@ -585,6 +688,59 @@ static const struct Curl_cwtype zstd_encoding = {
   zstd_do_close,
   sizeof(struct zstd_writer)
 };
+
+#ifdef USE_DCZ
+/* Dictionary-compressed zstd writer. */
+struct dcz_writer {
+  struct zstd_writer zw;
+  unsigned char hdr[DCZ_HEADER_LEN];
+  size_t hdrlen;
+};
+
+static CURLcode dcz_do_init(struct Curl_easy *data,
+                            struct Curl_cwriter *writer)
+{
+  struct zstd_writer *zp = (struct zstd_writer *) writer;
+  const struct cdict *d = data->req.cdict;
+  CURLcode result;
+
+  if(!d)
+    return CURLE_BAD_CONTENT_ENCODING;
+  result = zstd_do_init(data, writer);
+  /* a dictionary without the zstd dictionary magic is used as raw content */
+  if(!result &&
+     ZSTD_isError(ZSTD_DCtx_loadDictionary(zp->zds, d->data, d->len)))
+    result = CURLE_BAD_CONTENT_ENCODING;
+  return result;
+}
+
+static CURLcode dcz_do_write(struct Curl_easy *data,
+                             struct Curl_cwriter *writer, int type,
+                             const char *buf, size_t nbytes)
+{
+  struct dcz_writer *dp = (struct dcz_writer *) writer;
+
+  if(!(type & CLIENTWRITE_BODY) || !nbytes)
+    return Curl_cwriter_write(data, writer->next, type, buf, nbytes);
+
+  if(dp->hdrlen < sizeof(dp->hdr)) {
+    CURLcode result = dict_header(data, dp->hdr, &dp->hdrlen, dcz_magic,
+                                  sizeof(dcz_magic), &buf, &nbytes);
+    if(result || !nbytes)
+      return result;
+  }
+  return zstd_do_write(data, writer, type, buf, nbytes);
+}
+
+static const struct Curl_cwtype dcz_encoding = {
+  "dcz",
+  NULL,
+  dcz_do_init,
+  dcz_do_write,
+  zstd_do_close,
+  sizeof(struct dcz_writer)
+};
+#endif /* USE_DCZ */
 #endif
 
 /* Identity handler. */
@@ -613,6 +769,34 @@ static const struct Curl_cwtype * const general_unencoders[] = {
   NULL
 };
 
+#if defined(USE_DCB) || defined(USE_DCZ)
+/* supported content decoders using a compression dictionary */
+static const struct Curl_cwtype * const dict_unencoders[] = {
+#ifdef USE_DCB
+  &dcb_encoding,
+#endif
+#ifdef USE_DCZ
+  &dcz_encoding,
+#endif
+  NULL
+};
+#endif
+
+/* Return the dictionary content encodings this build supports, as a list
+   to use in Accept-Encoding: or NULL if there are none. */
+const char *Curl_dict_encodings(void)
+{
+#if defined(USE_DCB) && defined(USE_DCZ)
+  return "dcb, dcz";
+#elif defined(USE_DCB)
+  return "dcb";
+#elif defined(USE_DCZ)
+  return "dcz";
+#else
+  return NULL;
+#endif
+}
+
 /* supported content decoders only for transfer encodings */
 static const struct Curl_cwtype * const transfer_unencoders[] = {
 #ifndef CURL_DISABLE_HTTP
@@ -703,7 +887,8 @@ static const struct Curl_cwtype error_writer = {
 };
 
 /* Find the content encoding by name. */
-static const struct Curl_cwtype *find_unencode_writer(const char *name,
+static const struct Curl_cwtype *find_unencode_writer(struct Curl_easy *data,
+                                                      const char *name,
                                                       size_t len,
                                                       Curl_cwriter_phase phase)
 {
@@ -725,6 +910,18 @@ static const struct Curl_cwtype *find_unencode_writer(const char *name,
        (ce->alias && curl_strnequal(name, ce->alias, len) && !ce->alias[len]))
       return ce;
   }
+#if defined(USE_DCB) || defined(USE_DCZ)
+  /* and the dictionary decoders, if a dictionary was offered */
+  if((phase == CURL_CW_CONTENT_DECODE) && data->req.cdict) {
+    for(cep = dict_unencoders; *cep; cep++) {
+      const struct Curl_cwtype *ce = *cep;
+      if(curl_strnequal(name, ce->name, len) && !ce->name[len])
+        return ce;
+    }
+  }
+#else
+  (void)data;
+#endif
   return NULL;
 }
 
@@ -789,7 +986,7 @@ CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
         return CURLE_BAD_CONTENT_ENCODING;
       }
 
-      cwt = find_unencode_writer(name, namelen, phase);
+      cwt = find_unencode_writer(data, name, namelen, phase);
       if(cwt && is_chunked && Curl_cwriter_get_by_type(data, cwt)) {
         /* A 'chunked' transfer encoding has already been added.
          * Ignore duplicates. See #13451.
@@ -838,6 +1035,329 @@ CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
   return CURLE_OK;
 }
 
+/*
+ * Request body encoders, client readers compressing the upload.
+ */
+
+#if defined(HAVE_ZSTD) && defined(ZSTD_VERSION_NUMBER) && \
+  (ZSTD_VERSION_NUMBER >= 10400)
+/* ZSTD_compressStream2() is stable API since zstd 1.4.0 */
+#define USE_ZSTD_ENCODER
+#endif
+
+#if defined(HAVE_LIBZ) || defined(USE_ZSTD_ENCODER)
+#define COMPRESS_BUFFER_SIZE 16384 /* buffer size for uncompressed data */
+
+static curl_off_t enc_total_length(struct Curl_easy *data,
+                                   struct Curl_creader *reader)
+{
+  /* the compressed length is not known before it is done */
+  (void)data;
+  (void)reader;
+  return -1;
+}
+#endif
+
+#ifdef HAVE_LIBZ
+/* Deflate and gzip reader. */
+struct zlib_reader {
+  struct Curl_creader super;
+  z_stream z;                /* State structure for zlib. */
+  char buffer[COMPRESS_BUFFER_SIZE]; /* Uncompressed data from next reader */
+  BIT(zlib_init);            /* z has been initialized */
+  BIT(read_eos);             /* we read an EOS from the next reader */
+  BIT(eos);                  /* we have returned an EOS */
+};
+
+static CURLcode zlib_enc_init(struct Curl_easy *data,
+                              struct Curl_creader *reader, int window_bits)
+{
+  struct zlib_reader *zp = reader->ctx;
+  z_stream *z = &zp->z;     /* zlib state structure */
+
+  z->zalloc = (alloc_func) Curl_zalloc_cb;
+  z->zfree = (free_func) Curl_zfree_cb;
+
+  if(deflateInit2(z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits,
+                  8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    failf(data, "Error initializing request body compression");
+    return CURLE_BAD_CONTENT_ENCODING;
+  }
+  zp->zlib_init = TRUE;
+  return CURLE_OK;
+}
+
+static CURLcode deflate_enc_init(struct Curl_easy *data,
+                                 struct Curl_creader *reader)
+{
+  return zlib_enc_init(data, reader, MAX_WBITS);
+}
+
+static CURLcode gzip_enc_init(struct Curl_easy *data,
+                              struct Curl_creader *reader)
+{
+  /* adding 16 to the window bits makes zlib write a gzip wrapper */
+  return zlib_enc_init(data, reader, MAX_WBITS + 16);
+}
+
+static CURLcode zlib_enc_read(struct Curl_easy *data,
+                              struct Curl_creader *reader,
+                              char *buf, size_t blen,
+                              size_t *pnread, bool *peos)
+{
+  struct zlib_reader *zp = reader->ctx;
+  z_stream *z = &zp->z;
+  CURLcode result = CURLE_OK;
+  size_t nread;
+  bool eos;
+  int status;
+
+  *pnread = 0;
+  *peos = zp->eos;
+  if(zp->eos || !blen)
+    return CURLE_OK;
+
+  z->next_out = (Bytef *)buf;
+  z->avail_out = (uInt)CURLMIN(blen, UINT_MAX);
+  while(z->avail_out) {
+    if(!z->avail_in && !zp->read_eos) {
+      result = Curl_creader_read(data, reader->next, zp->buffer,
+                                 sizeof(zp->buffer), &nread, &eos);
+      if(result)
+        return result;
+      zp->read_eos = eos;
+      z->next_in = (Bytef *)zp->buffer;
+      z->avail_in = (uInt)nread;
+      if(!nread && !eos) /* nothing to compress right now */
+        break;
+    }
+
+    status = deflate(z, zp->read_eos ? Z_FINISH : Z_NO_FLUSH);
+    if(status == Z_STREAM_END) {
+      zp->eos = TRUE;
+      break;
+    }
+    else if(status != Z_OK) {
+      failf(data, "Error while compressing request body: %s",
+            z->msg ? z->msg : "unknown failure");
+      return CURLE_BAD_CONTENT_ENCODING;
+    }
+  }
+
+  *pnread = blen - z->avail_out;
+  *peos = zp->eos;
+  CURL_TRC_READ(data, "%s_read(len=%zu) -> %d, nread=%zu, eos=%d",
+                reader->crt->name, blen, result, *pnread, *peos);
+  return result;
+}
+
+static void zlib_enc_close(struct Curl_easy *data,
+                           struct Curl_creader *reader)
+{
+  struct zlib_reader *zp = reader->ctx;
+
+  (void)data;
+  if(zp->zlib_init) {
+    deflateEnd(&zp->z);
+    zp->zlib_init = FALSE;
+  }
+}
+
+static const struct Curl_crtype deflate_encoder = {
+  "deflate",
+  deflate_enc_init,
+  zlib_enc_read,
+  zlib_enc_close,
+  Curl_creader_def_needs_rewind,
+  enc_total_length,
+  Curl_creader_def_resume_from,
+  Curl_creader_def_cntrl,
+  Curl_creader_def_is_paused,
+  Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
+  sizeof(struct zlib_reader)
+};
+
+static const struct Curl_crtype gzip_encoder = {
+  "gzip",
+  gzip_enc_init,
+  zlib_enc_read,
+  zlib_enc_close,
+  Curl_creader_def_needs_rewind,
+  enc_total_length,
+  Curl_creader_def_resume_from,
+  Curl_creader_def_cntrl,
+  Curl_creader_def_is_paused,
+  Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
+  sizeof(struct zlib_reader)
+};
+#endif /* HAVE_LIBZ */
+
+#ifdef USE_ZSTD_ENCODER
+/* Zstd reader. */
+struct zstd_reader {
+  struct Curl_creader super;
+  ZSTD_CCtx *zcs;            /* State structure for zstd. */
+  ZSTD_inBuffer in;          /* Uncompressed data in `buffer` */
+  char buffer[COMPRESS_BUFFER_SIZE];
+  BIT(read_eos);             /* we read an EOS from the next reader */
+  BIT(eos);                  /* we have returned an EOS */
+};
+
+static CURLcode zstd_enc_init(struct Curl_easy *data,
+                              struct Curl_creader *reader)
+{
+  struct zstd_reader *zp = reader->ctx;
+
+  (void)data;
+#ifdef ZSTD_STATIC_LINKING_ONLY
+  zp->zcs = ZSTD_createCCtx_advanced((ZSTD_customMem) {
+    .customAlloc = Curl_zstd_alloc,
+    .customFree  = Curl_zstd_free,
+    .opaque      = NULL
+  });
+#else
+  zp->zcs = ZSTD_createCCtx();
+#endif
+  zp->in.src = zp->buffer;
+  return zp->zcs ? CURLE_OK : CURLE_OUT_OF_MEMORY;
+}
+
+static CURLcode zstd_enc_read(struct Curl_easy *data,
+                              struct Curl_creader *reader,
+                              char *buf, size_t blen,
+                              size_t *pnread, bool *peos)
+{
+  struct zstd_reader *zp = reader->ctx;
+  ZSTD_outBuffer out;
+  CURLcode result = CURLE_OK;
+  size_t nread, zr;
+  bool eos;
+
+  *pnread = 0;
+  *peos = zp->eos;
+  if(zp->eos || !blen)
+    return CURLE_OK;
+
+  out.dst = buf;
+  out.size = blen;
+  out.pos = 0;
+  while(out.pos < out.size) {
+    if((zp->in.pos == zp->in.size) && !zp->read_eos) {
+      result = Curl_creader_read(data, reader->next, zp->buffer,
+                                 sizeof(zp->buffer), &nread, &eos);
+      if(result)
+        return result;
+      zp->read_eos = eos;
+      zp->in.size = nread;
+      zp->in.pos = 0;
+      if(!nread && !eos) /* nothing to compress right now */
+        break;
+    }
+
+    zr = ZSTD_compressStream2(zp->zcs, &out, &zp->in,
+                              zp->read_eos ? ZSTD_e_end : ZSTD_e_continue);
+    if(ZSTD_isError(zr)) {
+      failf(data, "Error while compressing request body: %s",
+            ZSTD_getErrorName(zr));
+      return CURLE_BAD_CONTENT_ENCODING;
+    }
+    if(zp->read_eos && !zr) {
+      /* input consumed and frame completely flushed */
+      zp->eos = TRUE;
+      break;
+    }
+  }
+
+  *pnread = out.pos;
+  *peos = zp->eos;
+  CURL_TRC_READ(data, "zstd_read(len=%zu) -> %d, nread=%zu, eos=%d",
+                blen, result, *pnread, *peos);
+  return result;
+}
+
+static void zstd_enc_close(struct Curl_easy *data,
+                           struct Curl_creader *reader)
+{
+  struct zstd_reader *zp = reader->ctx;
+
+  (void)data;
+  if(zp->zcs) {
+    ZSTD_freeCCtx(zp->zcs);
+    zp->zcs = NULL;
+  }
+}
+
+static const struct Curl_crtype zstd_encoder = {
+  "zstd",
+  zstd_enc_init,
+  zstd_enc_read,
+  zstd_enc_close,
+  Curl_creader_def_needs_rewind,
+  enc_total_length,
+  Curl_creader_def_resume_from,
+  Curl_creader_def_cntrl,
+  Curl_creader_def_is_paused,
+  Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
+  sizeof(struct zstd_reader)
+};
+#endif /* USE_ZSTD_ENCODER */
+
+/* supported request body encoders */
+static const struct Curl_crtype * const general_encoders[] = {
+#ifdef HAVE_LIBZ
+  &deflate_encoder,
+  &gzip_encoder,
+#endif
+#ifdef USE_ZSTD_ENCODER
+  &zstd_encoder,
+#endif
+  NULL
+};
+
+static const struct Curl_crtype *find_encode_reader(const char *name)
+{
+  const struct Curl_crtype * const *cep;
+
+  for(cep = general_encoders; *cep; cep++) {
+    if(curl_strequal(name, (*cep)->name))
+      return *cep;
+  }
+  return NULL;
+}
+
+bool Curl_upload_encoding_supported(const char *name)
+{
+  return find_encode_reader(name) != NULL;
+}
+
+/* Add a client reader compressing the request body with `name`. */
+CURLcode Curl_upload_encoder_add(struct Curl_easy *data, const char *name)
+{
+  const struct Curl_crtype *crt = find_encode_reader(name);
+  struct Curl_creader *reader = NULL;
+  CURLcode result;
+
+  if(!crt) {
+    failf(data, "Unsupported upload encoding: %s", name);
+    return CURLE_NOT_BUILT_IN;
+  }
+
+  result = Curl_creader_create(&reader, data, crt, CURL_CR_CONTENT_ENCODE);
+  if(!result)
+    result = Curl_creader_add(data, reader);
+  CURL_TRC_READ(data, "added %s encoder -> %d", crt->name, result);
+
+  if(result && reader)
+    Curl_creader_free(data, reader);
+  return result;
+}
+
 #else
 /* Stubs for builds without HTTP. */
 CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
@@ -849,6 +1369,24 @@ CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
   return CURLE_NOT_BUILT_IN;
 }
 
+bool Curl_upload_encoding_supported(const char *name)
+{
+  (void)name;
+  return FALSE;
+}
+
+CURLcode Curl_upload_encoder_add(struct Curl_easy *data, const char *name)
+{
+  (void)data;
+  (void)name;
+  return CURLE_NOT_BUILT_IN;
+}
+
+const char *Curl_dict_encodings(void)
+{
+  return NULL;
+}
+
 void Curl_all_content_encodings(char *buf, size_t blen)
 {
   DEBUGASSERT(buf);
@@ -25,10 +25,25 @@
  ***************************************************************************/
 #include "curl_setup.h"
 
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
 struct Curl_cwriter;
 
 void Curl_all_content_encodings(char *buf, size_t blen);
 
 CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
                                      const char *enclist, int is_transfer);
+
+const char *Curl_dict_encodings(void);
+bool Curl_upload_encoding_supported(const char *name);
+CURLcode Curl_upload_encoder_add(struct Curl_easy *data, const char *name);
+
+#if defined(HAVE_LIBZ) && !defined(CURL_DISABLE_HTTP)
+/* zlib memory callbacks using the libcurl allocator */
+voidpf Curl_zalloc_cb(voidpf opaque, unsigned int items, unsigned int size);
+void Curl_zfree_cb(voidpf opaque, voidpf ptr);
+#endif
+
 #endif /* HEADER_CURL_CONTENT_ENCODING_H */
@@ -43,7 +43,7 @@ SENDING COOKIE INFORMATION
 
 Curl_cookie_getlist()
 
-        For a given host and path, return a linked list of cookies that
+        For a given host and path, return the cookies that
         the client should send to the server if used now. The secure
         boolean informs the cookie if a secure connection is achieved or
         not.
@@ -95,6 +95,10 @@ Example set of cookies:
 #include "memdebug.h"
 
 static void strstore(char **str, const char *newstr, size_t len);
+static char *get_netscape_format(const struct Cookie *co);
+static CURLcode cookie_output(struct Curl_easy *data,
+                              struct CookieInfo *ci,
+                              const char *filename);
 
 /* number of seconds in 400 days */
 #define COOKIES_MAXAGE (400*24*3600)
@@ -235,45 +239,172 @@ static const char *get_top_domain(const char * const domain, size_t *outlen)
   return first ? first : domain;
 }
 
-/* Avoid C1001, an "internal error" with MSVC14 */
-#if defined(_MSC_VER) && (_MSC_VER == 1900)
-#pragma optimize("", off)
+/*
+ * Return the part of the domain its cookie group is keyed on: the registrable
+ * domain when libpsl knows it, the top-level domain otherwise. A cookie is
+ * keyed like every host it can be sent to, except when it is set on a public
+ * suffix: those are only found via cookie_suffix_domain().
+ */
+static const char *get_domain_key(const char * const domain, size_t *outlen,
+                                  bool *registrable)
+{
+#ifdef USE_LIBPSL
+  /* the built-in list never changes, so the keys of a jar stay the same */
+  const psl_ctx_t *psl = psl_builtin();
+  size_t len = strlen(domain);
+  char lcase[256];
+
+  if(psl && (len < sizeof(lcase))) {
+    const char *reg;
+    /* libpsl requires a lowercase domain name */
+    Curl_strntolower(lcase, domain, len + 1);
+    reg = psl_registrable_domain(psl, lcase);
+    if(reg) {
+      *outlen = len - (size_t)(reg - lcase);
+      *registrable = TRUE;
+      return domain + (reg - lcase);
+    }
+  }
 #endif
+  *registrable = FALSE;
+  return get_top_domain(domain, outlen);
+}
 
 /*
- * A case-insensitive hash for the cookie domains.
+ * The cookies of a jar are grouped on the registrable domain. All cookies a
+ * host may get, but those set on its public suffix, are in the same group,
+ * kept in the order they are sent.
  */
-static size_t cookie_hash_domain(const char *domain, const size_t len)
-{
-  const char *end = domain + len;
-  size_t h = 5381;
+struct CookieDomain {
+  struct Curl_llist list;
+};
 
-  while(domain < end) {
-    size_t j = (size_t)Curl_raw_toupper(*domain++);
-    h += h << 5;
-    h ^= j;
+static void cookie_domain_dtor(void *p)
+{
+  struct CookieDomain *cd = p;
+  struct Curl_llist_node *n = Curl_llist_head(&cd->list);
+  while(n) {
+    struct Cookie *co = Curl_node_elem(n);
+    n = Curl_node_next(n);
+    freecookie(co);
   }
+  free(cd);
+}
 
-  return (h % COOKIE_HASH_SIZE);
+static int cookie_domain_empty(void *user, void *p)
+{
+  struct CookieDomain *cd = p;
+  (void)user;
+  return !Curl_llist_count(&cd->list);
 }
 
-#if defined(_MSC_VER) && (_MSC_VER == 1900)
-#pragma optimize("", on)
+/*
+ * Find the cookie group for this domain, optionally creating it. IP
+ * addresses and cookies without domain share a group with an empty key.
+ */
+static struct CookieDomain *cookie_domain(struct CookieInfo *ci,
+                                          const char *domain, bool create)
+{
+  struct CookieDomain *cd;
+  const char *key = "";
+  size_t len = 0;
+  bool registrable;
+
+  if(domain && !Curl_host_is_ipnum(domain))
+    key = get_domain_key(domain, &len, &registrable);
+
+  cd = Curl_hash_pick(&ci->domains, CURL_UNCONST(key), len);
+  if(!cd && create) {
+    cd = malloc(sizeof(struct CookieDomain));
+    if(!cd)
+      return NULL;
+    Curl_llist_init(&cd->list, NULL);
+    if(!Curl_hash_add(&ci->domains, CURL_UNCONST(key), len, cd)) {
+      free(cd);
+      return NULL;
+    }
+    Curl_hash_grow_if_needed(&ci->domains);
+  }
+  return cd;
+}
+
+/*
+ * Find the group of the cookies set on the public suffix of a host, when it
+ * is not the group of the host itself. Only cookies read from a file or set
+ * with CURLOPT_COOKIELIST can end up there.
+ */
+static struct CookieDomain *cookie_suffix_domain(struct CookieInfo *ci,
+                                                 const char *host)
+{
+#ifdef USE_LIBPSL
+  const char *key;
+  size_t len, toplen;
+  bool registrable;
+
+  if(Curl_host_is_ipnum(host))
+    return NULL;
+  key = get_domain_key(host, &len, &registrable);
+  if(registrable) {
+    const char *top = get_top_domain(host, &toplen);
+    if(top != key)
+      return Curl_hash_pick(&ci->domains, CURL_UNCONST(top), toplen);
+  }
+#else
+  (void)ci;
+  (void)host;
 #endif
+  return NULL;
+}
 
 /*
- * Hash this domain.
+ * cookie_cmp
+ *
+ * Order cookies such that the longest path gets before the shorter path.
+ * Path, domain and name lengths are considered in that order, with the
+ * creationtime as the tiebreaker. The creationtime is guaranteed to be
+ * unique per cookie, so we know we will get an ordering at that point.
  */
-static size_t cookiehash(const char * const domain)
+static int cookie_cmp(const struct Cookie *c1, const struct Cookie *c2)
 {
-  const char *top;
-  size_t len;
+  size_t l1, l2;
 
-  if(!domain || Curl_host_is_ipnum(domain))
-    return 0;
+  /* 1 - compare cookie path lengths */
+  l1 = c1->path ? strlen(c1->path) : 0;
+  l2 = c2->path ? strlen(c2->path) : 0;
 
-  top = get_top_domain(domain, &len);
-  return cookie_hash_domain(top, len);
+  if(l1 != l2)
+    return (l2 > l1) ? 1 : -1; /* avoid size_t <=> int conversions */
+
+  /* 2 - compare cookie domain lengths */
+  l1 = c1->domain ? strlen(c1->domain) : 0;
+  l2 = c2->domain ? strlen(c2->domain) : 0;
+
+  if(l1 != l2)
+    return (l2 > l1) ? 1 : -1; /* avoid size_t <=> int conversions */
+
+  /* 3 - compare cookie name lengths */
+  l1 = c1->name ? strlen(c1->name) : 0;
+  l2 = c2->name ? strlen(c2->name) : 0;
+
+  if(l1 != l2)
+    return (l2 > l1) ? 1 : -1;
+
+  /* 4 - compare cookie creation time */
+  return (c2->creationtime > c1->creationtime) ? 1 : -1;
+}
+
+/* Insert the cookie at its place in the ordered group */
+static void cookie_insert(struct CookieDomain *cd, struct Cookie *co)
+{
+  struct Curl_llist_node *prev = NULL;
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&cd->list); n; n = Curl_node_next(n)) {
+    if(cookie_cmp(co, Curl_node_elem(n)) < 0)
+      break;
+    prev = n;
+  }
+  Curl_llist_insert_next(&cd->list, prev, co, &co->node);
 }
 
 /*
@@ -365,7 +496,9 @@ static void remove_expired(struct CookieInfo *ci)
 {
   struct Cookie *co;
   curl_off_t now = (curl_off_t)time(NULL);
-  unsigned int i;
+  struct Curl_hash_iterator iter;
+  struct Curl_hash_element *he;
+  bool removed = FALSE;
 
   /*
    * If the earliest expiration timestamp in the jar is in the future we can
@@ -381,11 +514,14 @@ static void remove_expired(struct CookieInfo *ci)
   else
     ci->next_expiration = CURL_OFF_T_MAX;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
+  Curl_hash_start_iterate(&ci->domains, &iter);
+  for(he = Curl_hash_next_element(&iter); he;
+      he = Curl_hash_next_element(&iter)) {
+    struct CookieDomain *cd = he->ptr;
     struct Curl_llist_node *n;
     struct Curl_llist_node *e = NULL;
 
-    for(n = Curl_llist_head(&ci->cookielist[i]); n; n = e) {
+    for(n = Curl_llist_head(&cd->list); n; n = e) {
       co = Curl_node_elem(n);
       e = Curl_node_next(n);
       if(co->expires) {
@@ -393,6 +529,7 @@ static void remove_expired(struct CookieInfo *ci)
           Curl_node_remove(n);
           freecookie(co);
           ci->numcookies--;
+          removed = TRUE;
         }
         else if(co->expires < ci->next_expiration)
           /*
@@ -403,6 +540,8 @@ static void remove_expired(struct CookieInfo *ci)
       }
     }
   }
+  if(removed)
+    Curl_hash_clean_with_criterium(&ci->domains, NULL, cookie_domain_empty);
 }
 
 #ifndef USE_LIBPSL
@@ -934,15 +1073,14 @@ is_public_suffix(struct Curl_easy *data,
 static int
 replace_existing(struct Curl_easy *data,
                  struct Cookie *co,
-                 struct CookieInfo *ci,
+                 struct CookieDomain *cd,
                  bool secure,
                  bool *replacep)
 {
   bool replace_old = FALSE;
   struct Curl_llist_node *replace_n = NULL;
   struct Curl_llist_node *n;
-  size_t myhash = cookiehash(co->domain);
-  for(n = Curl_llist_head(&ci->cookielist[myhash]); n; n = Curl_node_next(n)) {
+  for(n = Curl_llist_head(&cd->list); n; n = Curl_node_next(n)) {
     struct Cookie *clist = Curl_node_elem(n);
     if(!strcmp(clist->name, co->name)) {
       /* the names are identical */
@@ -1036,6 +1174,82 @@ replace_existing(struct Curl_easy *data,
   return CERR_OK;
 }
 
+/* Journaling is used when enabled and there is a jar file to journal */
+static const char *cookie_journal_jar(struct Curl_easy *data)
+{
+  const char *jar = data->set.str[STRING_COOKIEJAR];
+  if(data->set.cookiejournal && jar && strcmp(jar, "-"))
+    return jar;
+  return NULL;
+}
+
+/*
+ * Rewrite the cookie jar with all cookies and remove the journal, which is
+ * then no longer needed.
+ */
+static CURLcode cookie_journal_remove(struct CookieInfo *ci, const char *jar)
+{
+  char *journal;
+
+  if(ci->journal) {
+    fclose(ci->journal);
+    ci->journal = NULL;
+  }
+  journal = aprintf("%s-journal", jar);
+  if(!journal)
+    return CURLE_OUT_OF_MEMORY;
+  unlink(journal);
+  free(journal);
+  ci->journal_lines = 0;
+  ci->journal_gen++;
+  ci->compact = FALSE;
+  return CURLE_OK;
+}
+
+static CURLcode cookie_compact(struct Curl_easy *data, struct CookieInfo *ci,
+                               const char *jar)
+{
+  CURLcode result = cookie_output(data, ci, jar);
+  if(result)
+    return result;
+  return cookie_journal_remove(ci, jar);
+}
+
+/*
+ * Append the added, updated or expired cookie to the journal. Replaying the
+ * journal on top of the jar restores the jar's current state.
+ */
+static void cookie_journal(struct Curl_easy *data, struct CookieInfo *ci,
+                           const struct Cookie *co)
+{
+  const char *jar = cookie_journal_jar(data);
+  char *line;
+
+  if(!jar || !co->domain)
+    return;
+
+  if(!ci->journal) {
+    char *journal = aprintf("%s-journal", jar);
+    if(!journal)
+      return;
+    ci->journal = fopen(journal, FOPEN_APPENDTEXT);
+    if(!ci->journal)
+      infof(data, "WARNING: failed to open cookie journal \"%s\"", journal);
+    free(journal);
+    if(!ci->journal)
+      return;
+  }
+
+  line = get_netscape_format(co);
+  if(!line)
+    return;
+  fprintf(ci->journal, "%s\n", line);
+  fflush(ci->journal);
+  free(line);
+  ci->journal_lines++;
+  ci->journal_gen++;
+}
+
 /*
  * Curl_cookie_add
  *
@@ -1059,7 +1273,7 @@ Curl_cookie_add(struct Curl_easy *data,
                 bool secure)  /* TRUE if connection is over secure origin */
 {
   struct Cookie *co;
-  size_t myhash;
+  struct CookieDomain *cd;
   int rc;
   bool replaces = FALSE;
 
@@ -1117,12 +1331,15 @@ Curl_cookie_add(struct Curl_easy *data,
   if(is_public_suffix(data, co, domain))
     goto fail;
 
-  if(replace_existing(data, co, ci, secure, &replaces))
+  cd = cookie_domain(ci, co->domain, TRUE);
+  if(!cd)
+    goto fail;
+
+  if(replace_existing(data, co, cd, secure, &replaces))
     goto fail;
 
-  /* add this cookie to the list */
-  myhash = cookiehash(co->domain);
-  Curl_llist_append(&ci->cookielist[myhash], co, &co->node);
+  /* add this cookie to the list, at its place in the send order */
+  cookie_insert(cd, co);
 
   if(ci->running)
     /* Only show this when NOT reading the cookies from a file */
@@ -1141,6 +1358,9 @@ Curl_cookie_add(struct Curl_easy *data,
   if(co->expires && (co->expires < ci->next_expiration))
     ci->next_expiration = co->expires;
 
+  if(ci->running)
+    cookie_journal(data, ci, co);
+
   return co;
 fail:
   freecookie(co);
@@ -1148,6 +1368,32 @@ fail:
 }
 
 
+/*
+ * Read all cookies from the file. Returns the number of lines read.
+ */
+static size_t cookie_load(struct Curl_easy *data, struct CookieInfo *ci,
+                          FILE *fp)
+{
+  struct dynbuf buf;
+  size_t lines = 0;
+  curlx_dyn_init(&buf, MAX_COOKIE_LINE);
+  while(Curl_get_line(&buf, fp)) {
+    const char *lineptr = curlx_dyn_ptr(&buf);
+    bool headerline = FALSE;
+    if(checkprefix("Set-Cookie:", lineptr)) {
+      /* This is a cookie line, get it! */
+      lineptr += 11;
+      headerline = TRUE;
+      curlx_str_passblanks(&lineptr);
+    }
+
+    Curl_cookie_add(data, ci, headerline, TRUE, lineptr, NULL, NULL, TRUE);
+    lines++;
+  }
+  curlx_dyn_free(&buf); /* free the line buffer */
+  return lines;
+}
+
 /*
  * Curl_cookie_init()
  *
@@ -1170,17 +1416,13 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
   FILE *handle = NULL;
 
   if(!ci) {
-    int i;
-
     /* we did not get a struct, create one */
     ci = calloc(1, sizeof(struct CookieInfo));
     if(!ci)
       return NULL; /* failed to get memory */
 
-    /* This does not use the destructor callback since we want to add
-       and remove to lists while keeping the cookie struct intact */
-    for(i = 0; i < COOKIE_HASH_SIZE; i++)
-      Curl_llist_init(&ci->cookielist[i], NULL);
+    Curl_hash_init(&ci->domains, COOKIE_HASH_SIZE, Curl_hash_str_nocase,
+                   Curl_hash_str_casecompare, cookie_domain_dtor);
     /*
      * Initialize the next_expiration time to signal that we do not have enough
      * information yet.
@@ -1191,6 +1433,7 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
 
   if(data) {
     FILE *fp = NULL;
+    bool loaded;
     if(file && *file) {
       if(!strcmp(file, "-"))
         fp = stdin;
@@ -1204,32 +1447,34 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
     }
 
     ci->running = FALSE; /* this is not running, this is init */
+    loaded = !!fp;
     if(fp) {
-      struct dynbuf buf;
-      curlx_dyn_init(&buf, MAX_COOKIE_LINE);
-      while(Curl_get_line(&buf, fp)) {
-        const char *lineptr = curlx_dyn_ptr(&buf);
-        bool headerline = FALSE;
-        if(checkprefix("Set-Cookie:", lineptr)) {
-          /* This is a cookie line, get it! */
-          lineptr += 11;
-          headerline = TRUE;
-          curlx_str_passblanks(&lineptr);
-        }
+      cookie_load(data, ci, fp);
+      if(handle)
+        fclose(handle);
+    }
 
-        Curl_cookie_add(data, ci, headerline, TRUE, lineptr, NULL, NULL, TRUE);
+    if(file && *file && strcmp(file, "-") && cookie_journal_jar(data)) {
+      /* replay the changes made after the file was written */
+      char *journal = aprintf("%s-journal", file);
+      FILE *jp = journal ? fopen(journal, "rb") : NULL;
+      if(jp) {
+        ci->journal_lines = cookie_load(data, ci, jp);
+        fclose(jp);
+        loaded = TRUE;
       }
-      curlx_dyn_free(&buf); /* free the line buffer */
+      free(journal);
+      if(loaded && strcmp(file, cookie_journal_jar(data)))
+        /* the jar needs to get the cookies from this file */
+        ci->compact = TRUE;
+    }
 
+    if(loaded)
       /*
        * Remove expired cookies from the hash. We must make sure to run this
        * after reading the file, and not on every cookie.
        */
       remove_expired(ci);
-
-      if(handle)
-        fclose(handle);
-    }
     data->state.cookie_engine = TRUE;
   }
   ci->running = TRUE;          /* now, we are running */
@@ -1237,45 +1482,6 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
   return ci;
 }
 
-/*
- * cookie_sort
- *
- * Helper function to sort cookies such that the longest path gets before the
- * shorter path. Path, domain and name lengths are considered in that order,
- * with the creationtime as the tiebreaker. The creationtime is guaranteed to
- * be unique per cookie, so we know we will get an ordering at that point.
- */
-static int cookie_sort(const void *p1, const void *p2)
-{
-  const struct Cookie *c1 = *(const struct Cookie * const *)p1;
-  const struct Cookie *c2 = *(const struct Cookie * const *)p2;
-  size_t l1, l2;
-
-  /* 1 - compare cookie path lengths */
-  l1 = c1->path ? strlen(c1->path) : 0;
-  l2 = c2->path ? strlen(c2->path) : 0;
-
-  if(l1 != l2)
-    return (l2 > l1) ? 1 : -1; /* avoid size_t <=> int conversions */
-
-  /* 2 - compare cookie domain lengths */
-  l1 = c1->domain ? strlen(c1->domain) : 0;
-  l2 = c2->domain ? strlen(c2->domain) : 0;
-
-  if(l1 != l2)
-    return (l2 > l1) ? 1 : -1; /* avoid size_t <=> int conversions */
-
-  /* 3 - compare cookie name lengths */
-  l1 = c1->name ? strlen(c1->name) : 0;
-  l2 = c2->name ? strlen(c2->name) : 0;
-
-  if(l1 != l2)
-    return (l2 > l1) ? 1 : -1;
-
-  /* 4 - compare cookie creation time */
-  return (c2->creationtime > c1->creationtime) ? 1 : -1;
-}
-
 /*
  * cookie_sort_ct
  *
@@ -1300,38 +1506,59 @@ bool Curl_secure_context(struct connectdata *conn, const char *host)
 /*
  * Curl_cookie_getlist
  *
- * For a given host and path, return a linked list of cookies that the client
- * should send to the server if used now. The secure boolean informs the cookie
- * if a secure connection is achieved or not.
+ * For a given host and path, store the cookies that the client should send
+ * to the server if used now in the 'list' array, which has room for
+ * MAX_COOKIE_SEND_AMOUNT entries. The secure boolean informs the cookie if a
+ * secure connection is achieved or not.
  *
- * It shall only return cookies that have not expired.
+ * It shall only return cookies that have not expired. Expired cookies are
+ * skipped but not removed, the jar is not modified so that this can be done
+ * with a shared lock.
  *
- * Returns 0 when there is a list returned. Otherwise non-zero.
+ * Returns the number of cookies stored.
  */
-int Curl_cookie_getlist(struct Curl_easy *data,
-                        struct connectdata *conn,
-                        const char *host,
-                        struct Curl_llist *list)
+size_t Curl_cookie_getlist(struct Curl_easy *data,
+                           struct connectdata *conn,
+                           const char *host,
+                           const struct Cookie **list)
 {
   size_t matches = 0;
   const bool is_ip = Curl_host_is_ipnum(host);
-  const size_t myhash = cookiehash(host);
-  struct Curl_llist_node *n;
+  struct CookieDomain *cd, *sd;
+  struct Curl_llist_node *n, *sn;
   const bool secure = Curl_secure_context(conn, host);
   struct CookieInfo *ci = data->cookies;
   const char *path = data->state.up.path;
+  curl_off_t now = (curl_off_t)time(NULL);
 
-  Curl_llist_init(list, NULL);
+  if(!ci || !ci->numcookies)
+    return 0; /* no cookie struct or no cookies in the struct */
 
-  if(!ci || !Curl_llist_count(&ci->cookielist[myhash]))
-    return 1; /* no cookie struct or no cookies in the struct */
+  /* only the group of the host's registrable domain and the one of its
+     public suffix can have matches */
+  cd = cookie_domain(ci, host, FALSE);
+  sd = cookie_suffix_domain(ci, host);
+  n = cd ? Curl_llist_head(&cd->list) : NULL;
+  sn = sd ? Curl_llist_head(&sd->list) : NULL;
 
-  /* at first, remove expired cookies */
-  remove_expired(ci);
+  /*
+   * The groups are kept ordered so that if there is a name appearing more
+   * than once, the longest specified path version comes first. Merge them
+   * to keep that order.
+   */
+  while(n || sn) {
+    struct Cookie *co;
+    if(n && (!sn || cookie_cmp(Curl_node_elem(n), Curl_node_elem(sn)) < 0)) {
+      co = Curl_node_elem(n);
+      n = Curl_node_next(n);
+    }
+    else {
+      co = Curl_node_elem(sn);
+      sn = Curl_node_next(sn);
+    }
 
-  for(n = Curl_llist_head(&ci->cookielist[myhash]);
-      n; n = Curl_node_next(n)) {
-    struct Cookie *co = Curl_node_elem(n);
+    if(co->expires && (co->expires < now))
+      continue;
 
     /* if the cookie requires we are secure we must only continue if we are! */
     if(co->secure ? secure : TRUE) {
@@ -1355,8 +1582,7 @@ int Curl_cookie_getlist(struct Curl_easy *data,
           /*
            * This is a match and we add it to the return-linked-list
            */
-          Curl_llist_append(list, co, &co->getnode);
-          matches++;
+          list[matches++] = co;
           if(matches >= MAX_COOKIE_SEND_AMOUNT) {
             infof(data, "Included max number of cookies (%zu) in request!",
                   matches);
@@ -1367,43 +1593,7 @@ int Curl_cookie_getlist(struct Curl_easy *data,
     }
   }
 
-  if(matches) {
-    /*
-     * Now we need to make sure that if there is a name appearing more than
-     * once, the longest specified path version comes first. To make this
-     * the swiftest way, we just sort them all based on path length.
-     */
-    struct Cookie **array;
-    size_t i;
-
-    /* alloc an array and store all cookie pointers */
-    array = malloc(sizeof(struct Cookie *) * matches);
-    if(!array)
-      goto fail;
-
-    n = Curl_llist_head(list);
-
-    for(i = 0; n; n = Curl_node_next(n))
-      array[i++] = Curl_node_elem(n);
-
-    /* now sort the cookie pointers in path length order */
-    qsort(array, matches, sizeof(struct Cookie *), cookie_sort);
-
-    /* remake the linked list order according to the new order */
-    Curl_llist_destroy(list, NULL);
-
-    for(i = 0; i < matches; i++)
-      Curl_llist_append(list, array[i], &array[i]->getnode);
-
-    free(array); /* remove the temporary data again */
-  }
-
-  return 0; /* success */
-
-fail:
-  /* failure, clear up the allocated chain and return NULL */
-  Curl_llist_destroy(list, NULL);
-  return 2; /* error */
+  return matches;
 }
 
 /*
@@ -1414,18 +1604,9 @@ fail:
 void Curl_cookie_clearall(struct CookieInfo *ci)
 {
   if(ci) {
-    unsigned int i;
-    for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-      struct Curl_llist_node *n;
-      for(n = Curl_llist_head(&ci->cookielist[i]); n;) {
-        struct Cookie *c = Curl_node_elem(n);
-        struct Curl_llist_node *e = Curl_node_next(n);
-        Curl_node_remove(n);
-        freecookie(c);
-        n = e;
-      }
-    }
+    Curl_hash_clean(&ci->domains);
     ci->numcookies = 0;
+    ci->compact = TRUE; /* the journal cannot express this */
   }
 }
 
@@ -1436,13 +1617,18 @@ void Curl_cookie_clearall(struct CookieInfo *ci)
  */
 void Curl_cookie_clearsess(struct CookieInfo *ci)
 {
-  unsigned int i;
+  struct Curl_hash_iterator iter;
+  struct Curl_hash_element *he;
 
   if(!ci)
     return;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    struct Curl_llist_node *n = Curl_llist_head(&ci->cookielist[i]);
+  ci->compact = TRUE; /* the journal cannot express this */
+  Curl_hash_start_iterate(&ci->domains, &iter);
+  for(he = Curl_hash_next_element(&iter); he;
+      he = Curl_hash_next_element(&iter)) {
+    struct CookieDomain *cd = he->ptr;
+    struct Curl_llist_node *n = Curl_llist_head(&cd->list);
     struct Curl_llist_node *e = NULL;
 
     for(; n; n = e) {
@@ -1455,6 +1641,7 @@ void Curl_cookie_clearsess(struct CookieInfo *ci)
       }
     }
   }
+  Curl_hash_clean_with_criterium(&ci->domains, NULL, cookie_domain_empty);
 }
 
 /*
@@ -1465,7 +1652,9 @@ void Curl_cookie_clearsess(struct CookieInfo *ci)
 void Curl_cookie_cleanup(struct CookieInfo *ci)
 {
   if(ci) {
-    Curl_cookie_clearall(ci);
+    Curl_hash_destroy(&ci->domains);
+    if(ci->journal)
+      fclose(ci->journal);
     free(ci); /* free the base struct as well */
   }
 }
@@ -1504,61 +1693,41 @@ static char *get_netscape_format(const struct Cookie *co)
 }
 
 /*
- * cookie_output()
+ * cookie_format()
  *
- * Writes all internally known cookies to the specified file. Specify
- * "-" as filename to write to stdout.
- *
- * The function returns non-zero on write failure.
+ * Formats all internally known cookies as a Netscape cookie file.
  */
-static CURLcode cookie_output(struct Curl_easy *data,
-                              struct CookieInfo *ci,
-                              const char *filename)
+static CURLcode cookie_format(struct CookieInfo *ci, struct dynbuf *out)
 {
-  FILE *out = NULL;
-  bool use_stdout = FALSE;
-  char *tempstore = NULL;
-  CURLcode error = CURLE_OK;
-
-  if(!ci)
-    /* no cookie engine alive */
-    return CURLE_OK;
+  CURLcode result;
 
   /* at first, remove expired cookies */
   remove_expired(ci);
 
-  if(!strcmp("-", filename)) {
-    /* use stdout */
-    out = stdout;
-    use_stdout = TRUE;
-  }
-  else {
-    error = Curl_fopen(data, filename, &out, &tempstore);
-    if(error)
-      goto error;
-  }
-
-  fputs("# Netscape HTTP Cookie File\n"
-        "# https://curl.se/docs/http-cookies.html\n"
-        "# This file was generated by libcurl! Edit at your own risk.\n\n",
-        out);
+  result = curlx_dyn_add(out,
+                         "# Netscape HTTP Cookie File\n"
+                         "# https://curl.se/docs/http-cookies.html\n"
+                         "# This file was generated by libcurl! Edit at your "
+                         "own risk.\n\n");
 
-  if(ci->numcookies) {
+  if(!result && ci->numcookies) {
     unsigned int i;
     size_t nvalid = 0;
     struct Cookie **array;
     struct Curl_llist_node *n;
+    struct Curl_hash_iterator iter;
+    struct Curl_hash_element *he;
 
     array = calloc(1, sizeof(struct Cookie *) * ci->numcookies);
-    if(!array) {
-      error = CURLE_OUT_OF_MEMORY;
-      goto error;
-    }
+    if(!array)
+      return CURLE_OUT_OF_MEMORY;
 
     /* only sort the cookies with a domain property */
-    for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-      for(n = Curl_llist_head(&ci->cookielist[i]); n;
-          n = Curl_node_next(n)) {
+    Curl_hash_start_iterate(&ci->domains, &iter);
+    for(he = Curl_hash_next_element(&iter); he;
+        he = Curl_hash_next_element(&iter)) {
+      struct CookieDomain *cd = he->ptr;
+      for(n = Curl_llist_head(&cd->list); n; n = Curl_node_next(n)) {
         struct Cookie *co = Curl_node_elem(n);
         if(!co->domain)
           continue;
@@ -1568,51 +1737,113 @@ static CURLcode cookie_output(struct Curl_easy *data,
 
     qsort(array, nvalid, sizeof(struct Cookie *), cookie_sort_ct);
 
-    for(i = 0; i < nvalid; i++) {
+    for(i = 0; !result && (i < nvalid); i++) {
       char *format_ptr = get_netscape_format(array[i]);
-      if(!format_ptr) {
-        free(array);
-        error = CURLE_OUT_OF_MEMORY;
-        goto error;
+      if(!format_ptr)
+        result = CURLE_OUT_OF_MEMORY;
+      else {
+        result = curlx_dyn_addf(out, "%s\n", format_ptr);
+        free(format_ptr);
       }
-      fprintf(out, "%s\n", format_ptr);
-      free(format_ptr);
     }
 
     free(array);
   }
+  return result;
+}
 
-  if(!use_stdout) {
-    fclose(out);
+/*
+ * cookie_write()
+ *
+ * Writes formatted cookies to the specified file, via a temporary file that
+ * is renamed into place. When 'tempp' is not NULL, the rename is left to the
+ * caller and the temporary filename is returned there, NULL if the file was
+ * written in place.
+ */
+static CURLcode cookie_write(struct Curl_easy *data, struct dynbuf *buf,
+                             const char *filename, char **tempp)
+{
+  FILE *out = NULL;
+  char *tempstore = NULL;
+  CURLcode error = Curl_fopen(data, filename, &out, &tempstore);
+  size_t len = curlx_dyn_len(buf);
+
+  if(error)
+    goto error;
+
+  if(len && (fwrite(curlx_dyn_ptr(buf), 1, len, out) != len)) {
+    error = CURLE_WRITE_ERROR;
+    goto error;
+  }
+  if(fclose(out)) {
     out = NULL;
-    if(tempstore && Curl_rename(tempstore, filename)) {
-      unlink(tempstore);
-      error = CURLE_WRITE_ERROR;
-      goto error;
-    }
+    error = CURLE_WRITE_ERROR;
+    goto error;
   }
+  out = NULL;
 
-  /*
-   * If we reach here we have successfully written a cookie file so there is
-   * no need to inspect the error, any error case should have jumped into the
-   * error block below.
-   */
+  if(tempp) {
+    *tempp = tempstore;
+    return CURLE_OK;
+  }
+  if(tempstore && Curl_rename(tempstore, filename)) {
+    error = CURLE_WRITE_ERROR;
+    goto error;
+  }
   free(tempstore);
   return CURLE_OK;
 
 error:
-  if(out && !use_stdout)
+  if(out)
     fclose(out);
+  if(tempstore)
+    unlink(tempstore);
   free(tempstore);
   return error;
 }
 
+/*
+ * cookie_output()
+ *
+ * Writes all internally known cookies to the specified file. Specify
+ * "-" as filename to write to stdout.
+ *
+ * The function returns non-zero on write failure.
+ */
+static CURLcode cookie_output(struct Curl_easy *data,
+                              struct CookieInfo *ci,
+                              const char *filename)
+{
+  struct dynbuf buf;
+  CURLcode error;
+
+  if(!ci)
+    /* no cookie engine alive */
+    return CURLE_OK;
+
+  curlx_dyn_init(&buf, DYN_COOKIE_JAR);
+  error = cookie_format(ci, &buf);
+  if(!error) {
+    if(!strcmp("-", filename)) {
+      /* use stdout */
+      size_t len = curlx_dyn_len(&buf);
+      if(fwrite(curlx_dyn_ptr(&buf), 1, len, stdout) != len)
+        error = CURLE_WRITE_ERROR;
+    }
+    else
+      error = cookie_write(data, &buf, filename, NULL);
+  }
+  curlx_dyn_free(&buf);
+  return error;
+}
+
 static struct curl_slist *cookie_list(struct Curl_easy *data)
 {
   struct curl_slist *list = NULL;
   struct curl_slist *beg;
-  unsigned int i;
   struct Curl_llist_node *n;
+  struct Curl_hash_iterator iter;
+  struct Curl_hash_element *he;
 
   if(!data->cookies || (data->cookies->numcookies == 0))
     return NULL;
@@ -1620,9 +1851,11 @@ static struct curl_slist *cookie_list(struct Curl_easy *data)
   /* at first, remove expired cookies */
   remove_expired(data->cookies);
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    for(n = Curl_llist_head(&data->cookies->cookielist[i]); n;
-        n = Curl_node_next(n)) {
+  Curl_hash_start_iterate(&data->cookies->domains, &iter);
+  for(he = Curl_hash_next_element(&iter); he;
+      he = Curl_hash_next_element(&iter)) {
+    struct CookieDomain *cd = he->ptr;
+    for(n = Curl_llist_head(&cd->list); n; n = Curl_node_next(n)) {
       struct Cookie *c = Curl_node_elem(n);
       char *line;
       if(!c->domain)
@@ -1654,6 +1887,71 @@ struct curl_slist *Curl_cookie_list(struct Curl_easy *data)
   return list;
 }
 
+/*
+ * Curl_cookie_journal_compact()
+ *
+ * Rewrite the cookie jar and remove the journal once the journal has grown
+ * too long. The jar is written without holding the cookie lock. It only
+ * replaces the old jar if no other change was made meanwhile, else the next
+ * call tries again. The caller must not hold the cookie lock.
+ */
+void Curl_cookie_journal_compact(struct Curl_easy *data)
+{
+  struct CookieInfo *ci = data->cookies;
+  const char *jar = cookie_journal_jar(data);
+  struct dynbuf buf;
+  unsigned int gen;
+  bool compact;
+  char *tempstore = NULL;
+  CURLcode result;
+
+  if(!ci || !jar)
+    return;
+
+  curlx_dyn_init(&buf, DYN_COOKIE_JAR);
+  Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SINGLE);
+  if(ci->compacting || (ci->journal_lines <= COOKIE_JOURNAL_COMPACT) ||
+     (ci->journal_lines <= ci->numcookies)) {
+    Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
+    return;
+  }
+  result = cookie_format(ci, &buf);
+  gen = ci->journal_gen;
+  compact = ci->compact;
+  ci->compact = FALSE;
+  ci->compacting = TRUE;
+  Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
+
+  if(!result)
+    result = cookie_write(data, &buf, jar, &tempstore);
+  curlx_dyn_free(&buf);
+
+  Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SINGLE);
+  ci->compacting = FALSE;
+  if(!result && (gen == ci->journal_gen) && !ci->compact) {
+    /* nothing changed while writing, the new jar replaces the journal */
+    if(tempstore && Curl_rename(tempstore, jar))
+      result = CURLE_WRITE_ERROR;
+    else {
+      Curl_safefree(tempstore);
+      result = cookie_journal_remove(ci, jar);
+      compact = FALSE;
+    }
+  }
+  if(tempstore) {
+    /* not used, the journal stays valid on top of the old jar */
+    unlink(tempstore);
+    free(tempstore);
+  }
+  if(compact)
+    ci->compact = TRUE;
+  Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
+
+  if(result)
+    infof(data, "WARNING: failed to compact cookies in %s: %s",
+          jar, curl_easy_strerror(result));
+}
+
 void Curl_flush_cookies(struct Curl_easy *data, bool cleanup)
 {
   CURLcode res;
@@ -1661,8 +1959,17 @@ void Curl_flush_cookies(struct Curl_easy *data, bool cleanup)
   if(data->set.str[STRING_COOKIEJAR]) {
     Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SINGLE);
 
-    /* if we have a destination file for all the cookies to get dumped to */
-    res = cookie_output(data, data->cookies, data->set.str[STRING_COOKIEJAR]);
+    if(!cookie_journal_jar(data))
+      /* if we have a destination file for all the cookies to get dumped to */
+      res = cookie_output(data, data->cookies,
+                          data->set.str[STRING_COOKIEJAR]);
+    else if(data->cookies && (!cleanup || data->cookies->compact))
+      /* the journal is not enough or an explicit flush was asked for */
+      res = cookie_compact(data, data->cookies,
+                           data->set.str[STRING_COOKIEJAR]);
+    else
+      /* the journal has all changes */
+      res = CURLE_OK;
     if(res)
       infof(data, "WARNING: failed to save cookies in %s: %s",
             data->set.str[STRING_COOKIEJAR], curl_easy_strerror(res));
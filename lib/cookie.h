@@ -28,10 +28,10 @@
 #include <curl/curl.h>
 
 #include "llist.h"
+#include "hash.h"
 
 struct Cookie {
   struct Curl_llist_node node; /* for the main cookie list */
-  struct Curl_llist_node getnode; /* for getlist */
   char *name;         /* <this> = value */
   char *value;        /* name = <this> */
   char *path;         /* path = <this> which is in Set-Cookie: */
@@ -54,16 +54,23 @@ struct Cookie {
 #define COOKIE_PREFIX__SECURE (1<<0)
 #define COOKIE_PREFIX__HOST (1<<1)
 
+/* initial number of hash slots, the table grows with the number of
+   domains */
 #define COOKIE_HASH_SIZE 63
 
 struct CookieInfo {
-  /* linked lists of cookies we know of */
-  struct Curl_llist cookielist[COOKIE_HASH_SIZE];
+  /* cookie lists (struct CookieDomain) keyed on the registrable domain */
+  struct Curl_hash domains;
   curl_off_t next_expiration; /* the next time at which expiration happens */
   unsigned int numcookies;  /* number of cookies in the "jar" */
   unsigned int lastct;      /* last creation-time used in the jar */
+  FILE *journal;            /* appended cookie changes, when journaling */
+  size_t journal_lines;     /* number of changes in the journal */
+  unsigned int journal_gen; /* bumped when the journal or the jar changes */
   BIT(running);    /* state info, for cookie adding information */
   BIT(newsession); /* new session, discard session cookies on load */
+  BIT(compact);    /* the jar must be rewritten as the journal is not enough */
+  BIT(compacting); /* the jar is being rewritten outside of the lock */
 };
 
 /* The maximum sizes we accept for cookies. RFC 6265 section 6.1 says
@@ -104,6 +111,12 @@ struct CookieInfo {
    keep the maximum HTTP request within the maximum allowed size. */
 #define MAX_COOKIE_SEND_AMOUNT 150
 
+/* Number of journal entries needed before the cookie jar is rewritten and
+   the journal truncated. The jar is also only compacted when the journal
+   has more entries than there are cookies. This is done after adding a
+   cookie from a header, see Curl_cookie_journal_compact(). */
+#define COOKIE_JOURNAL_COMPACT 1000
+
 struct Curl_easy;
 struct connectdata;
 
@@ -118,8 +131,8 @@ struct Cookie *Curl_cookie_add(struct Curl_easy *data,
                                bool noexpiry, const char *lineptr,
                                const char *domain, const char *path,
                                bool secure);
-int Curl_cookie_getlist(struct Curl_easy *data, struct connectdata *conn,
-                        const char *host, struct Curl_llist *list);
+size_t Curl_cookie_getlist(struct Curl_easy *data, struct connectdata *conn,
+                           const char *host, const struct Cookie **list);
 void Curl_cookie_clearall(struct CookieInfo *cookies);
 void Curl_cookie_clearsess(struct CookieInfo *cookies);
 
@@ -129,8 +142,10 @@ void Curl_cookie_clearsess(struct CookieInfo *cookies);
 #define Curl_cookie_init(x,y,z,w) NULL
 #define Curl_cookie_cleanup(x) Curl_nop_stmt
 #define Curl_flush_cookies(x,y) Curl_nop_stmt
+#define Curl_cookie_journal_compact(x) Curl_nop_stmt
 #else
 void Curl_flush_cookies(struct Curl_easy *data, bool cleanup);
+void Curl_cookie_journal_compact(struct Curl_easy *data);
 void Curl_cookie_cleanup(struct CookieInfo *c);
 struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
                                     const char *file, struct CookieInfo *inc,
@@ -462,6 +462,12 @@
 #define USE_EVENTFD
 #endif
 
+/* Whether to use sendfile() for uploads from files, the Linux flavor with
+   an offset pointer that leaves the file position alone */
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#define USE_SENDFILE
+#endif
+
 #include <stdio.h>
 #include <assert.h>
 
@@ -780,6 +786,15 @@
 #define USE_SSH
 #endif
 
+/* Single point where USE_COMPRESSION_DICT definition might be defined.
+   Dictionaries are identified by their SHA-256 hash. */
+#if !defined(CURL_DISABLE_HTTP) && \
+  (defined(HAVE_ZSTD) || defined(HAVE_BROTLI)) && \
+  (!defined(CURL_DISABLE_AWS) || !defined(CURL_DISABLE_DIGEST_AUTH) || \
+   defined(USE_LIBSSH2) || defined(USE_SSL))
+#define USE_COMPRESSION_DICT
+#endif
+
 /*
  * Provide a mechanism to silence picky compilers, such as gcc 4.6+.
  * Parameters should of course normally not be unused, but for example when
@@ -34,6 +34,13 @@
 #  define Curl_mutex_acquire(m)  pthread_mutex_lock(m)
 #  define Curl_mutex_release(m)  pthread_mutex_unlock(m)
 #  define Curl_mutex_destroy(m)  pthread_mutex_destroy(m)
+#  define curl_rwlock_t          pthread_rwlock_t
+#  define Curl_rwlock_init(l)    pthread_rwlock_init(l, NULL)
+#  define Curl_rwlock_rdlock(l)  pthread_rwlock_rdlock(l)
+#  define Curl_rwlock_wrlock(l)  pthread_rwlock_wrlock(l)
+#  define Curl_rwlock_rdunlock(l) pthread_rwlock_unlock(l)
+#  define Curl_rwlock_wrunlock(l) pthread_rwlock_unlock(l)
+#  define Curl_rwlock_destroy(l) pthread_rwlock_destroy(l)
 #elif defined(USE_THREADS_WIN32)
 #  define CURL_STDCALL           __stdcall
 #  define curl_mutex_t           CRITICAL_SECTION
@@ -47,6 +54,24 @@
 #  define Curl_mutex_acquire(m)  EnterCriticalSection(m)
 #  define Curl_mutex_release(m)  LeaveCriticalSection(m)
 #  define Curl_mutex_destroy(m)  DeleteCriticalSection(m)
+#  if !defined(_WIN32_WINNT) || (_WIN32_WINNT < _WIN32_WINNT_VISTA)
+/* no slim reader/writer locks, readers are serialized too */
+#    define curl_rwlock_t          CRITICAL_SECTION
+#    define Curl_rwlock_init(l)    InitializeCriticalSection(l)
+#    define Curl_rwlock_rdlock(l)  EnterCriticalSection(l)
+#    define Curl_rwlock_wrlock(l)  EnterCriticalSection(l)
+#    define Curl_rwlock_rdunlock(l) LeaveCriticalSection(l)
+#    define Curl_rwlock_wrunlock(l) LeaveCriticalSection(l)
+#    define Curl_rwlock_destroy(l) DeleteCriticalSection(l)
+#  else
+#    define curl_rwlock_t          SRWLOCK
+#    define Curl_rwlock_init(l)    InitializeSRWLock(l)
+#    define Curl_rwlock_rdlock(l)  AcquireSRWLockShared(l)
+#    define Curl_rwlock_wrlock(l)  AcquireSRWLockExclusive(l)
+#    define Curl_rwlock_rdunlock(l) ReleaseSRWLockShared(l)
+#    define Curl_rwlock_wrunlock(l) ReleaseSRWLockExclusive(l)
+#    define Curl_rwlock_destroy(l) Curl_nop_stmt
+#  endif
 #else
 #  define CURL_STDCALL
 #endif
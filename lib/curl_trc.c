@@ -289,6 +289,7 @@ static const char * const Curl_trc_timer_names[]={
   "FTP_ACCEPT",
   "ALPN_EYEBALLS",
   "SHUTDOWN",
+  "UPKEEP",
 };
 
 const char *Curl_trc_timer_name(int tid)
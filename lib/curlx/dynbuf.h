@@ -82,4 +82,5 @@ char *curlx_dyn_take(struct dynbuf *s, size_t *plen);
 #define DYN_CRLFILE_SIZE    (400*1024*1024) /* 400mb */
 #define DYN_CERTFILE_SIZE   (100*1024) /* 100KiB */
 #define DYN_KEYFILE_SIZE    (100*1024) /* 100KiB */
+#define DYN_COOKIE_JAR      (400*1024*1024) /* 400mb */
 #endif
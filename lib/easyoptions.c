@@ -49,6 +49,8 @@ const struct curl_easyoption Curl_easyopts[] = {
   {"CHUNK_END_FUNCTION", CURLOPT_CHUNK_END_FUNCTION, CURLOT_FUNCTION, 0},
   {"CLOSESOCKETDATA", CURLOPT_CLOSESOCKETDATA, CURLOT_CBPTR, 0},
   {"CLOSESOCKETFUNCTION", CURLOPT_CLOSESOCKETFUNCTION, CURLOT_FUNCTION, 0},
+  {"COMPRESSION_DICT_BLOB", CURLOPT_COMPRESSION_DICT_BLOB, CURLOT_BLOB, 0},
+  {"COMPRESSION_DICT_LEARN", CURLOPT_COMPRESSION_DICT_LEARN, CURLOT_LONG, 0},
   {"CONNECTTIMEOUT", CURLOPT_CONNECTTIMEOUT, CURLOT_LONG, 0},
   {"CONNECTTIMEOUT_MS", CURLOPT_CONNECTTIMEOUT_MS, CURLOT_LONG, 0},
   {"CONNECT_ONLY", CURLOPT_CONNECT_ONLY, CURLOT_LONG, 0},
@@ -62,6 +64,7 @@ const struct curl_easyoption Curl_easyopts[] = {
   {"COOKIE", CURLOPT_COOKIE, CURLOT_STRING, 0},
   {"COOKIEFILE", CURLOPT_COOKIEFILE, CURLOT_STRING, 0},
   {"COOKIEJAR", CURLOPT_COOKIEJAR, CURLOT_STRING, 0},
+  {"COOKIEJOURNAL", CURLOPT_COOKIEJOURNAL, CURLOT_LONG, 0},
   {"COOKIELIST", CURLOPT_COOKIELIST, CURLOT_STRING, 0},
   {"COOKIESESSION", CURLOPT_COOKIESESSION, CURLOT_LONG, 0},
   {"COPYPOSTFIELDS", CURLOPT_COPYPOSTFIELDS, CURLOT_OBJECT, 0},
@@ -355,6 +358,7 @@ const struct curl_easyoption Curl_easyopts[] = {
   {"UPKEEP_INTERVAL_MS", CURLOPT_UPKEEP_INTERVAL_MS, CURLOT_LONG, 0},
   {"UPLOAD", CURLOPT_UPLOAD, CURLOT_LONG, 0},
   {"UPLOAD_BUFFERSIZE", CURLOPT_UPLOAD_BUFFERSIZE, CURLOT_LONG, 0},
+  {"UPLOAD_ENCODING", CURLOPT_UPLOAD_ENCODING, CURLOT_STRING, 0},
   {"UPLOAD_FLAGS", CURLOPT_UPLOAD_FLAGS, CURLOT_LONG, 0},
   {"URL", CURLOPT_URL, CURLOT_STRING, 0},
   {"USERAGENT", CURLOPT_USERAGENT, CURLOT_STRING, 0},
@@ -380,6 +384,6 @@ const struct curl_easyoption Curl_easyopts[] = {
  */
 int Curl_easyopts_check(void)
 {
-  return (CURLOPT_LASTENTRY % 10000) != (328 + 1);
+  return (CURLOPT_LASTENTRY % 10000) != (332 + 1);
 }
 #endif
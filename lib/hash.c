@@ -28,6 +28,7 @@
 
 #include "hash.h"
 #include "llist.h"
+#include "strcase.h"
 #include "curl_memory.h"
 
 /* The last #include file should be: */
@@ -284,6 +285,53 @@ Curl_hash_destroy(struct Curl_hash *h)
   h->slots = 0;
 }
 
+/* Changes the number of slots, moving all entries over to a new table.
+ * Returns non-zero on failure, leaving the hash unchanged.
+ *
+ * @unittest: 1603
+ */
+int Curl_hash_resize(struct Curl_hash *h, size_t slots)
+{
+  struct Curl_hash_element **table;
+  size_t i;
+
+  DEBUGASSERT(h);
+  DEBUGASSERT(slots);
+  DEBUGASSERT(h->init == HASHINIT);
+  if(h->table) {
+    table = calloc(slots, sizeof(struct Curl_hash_element *));
+    if(!table)
+      return 1; /* OOM */
+    for(i = 0; i < h->slots; ++i) {
+      struct Curl_hash_element *he = h->table[i];
+      while(he) {
+        struct Curl_hash_element *next = he->next;
+        struct Curl_hash_element **slot =
+          &table[h->hash_func(he->key, he->key_len, slots)];
+        he->next = *slot;
+        *slot = he;
+        he = next;
+      }
+    }
+    free(h->table);
+    h->table = table;
+  }
+  h->slots = slots;
+  return 0;
+}
+
+/* Grows the table when the chains get long on average, for hashes that
+ * keep growing with use. A failure is harmless, the hash just stays slower.
+ *
+ * @unittest: 1603
+ */
+void Curl_hash_grow_if_needed(struct Curl_hash *h)
+{
+  DEBUGASSERT(h);
+  if(h->size > h->slots * 2)
+    (void)Curl_hash_resize(h, h->slots * 2 + 1);
+}
+
 /* Removes all the entries in the given hash.
  *
  * @unittest: 1602
@@ -361,6 +409,55 @@ size_t curlx_str_key_compare(void *k1, size_t key1_len,
   return 0;
 }
 
+/* Avoid C1001, an "internal error" with MSVC14 */
+#if defined(_MSC_VER) && (_MSC_VER == 1900)
+#pragma optimize("", off)
+#endif
+
+/* case-insensitive version of Curl_hash_str(), for hostname keys */
+size_t Curl_hash_str_nocase(void *key, size_t key_length, size_t slots_num)
+{
+  const char *key_str = (const char *) key;
+  const char *end = key_str + key_length;
+  size_t h = 5381;
+
+  while(key_str < end) {
+    size_t j = (size_t)Curl_raw_toupper(*key_str++);
+    h += h << 5;
+    h ^= j;
+  }
+
+  return (h % slots_num);
+}
+
+size_t Curl_hash_mix(size_t h, const void *mem, size_t len, bool nocase)
+{
+  const char *p = (const char *) mem;
+  const char *end = p + len;
+
+  while(p < end) {
+    size_t j = (size_t)(nocase ? Curl_raw_toupper(*p++) : *p++);
+    h += h << 5;
+    h ^= j;
+  }
+
+  return h;
+}
+
+#if defined(_MSC_VER) && (_MSC_VER == 1900)
+#pragma optimize("", on)
+#endif
+
+size_t Curl_hash_str_casecompare(void *k1, size_t key1_len,
+                                 void *k2, size_t key2_len)
+{
+  if((key1_len == key2_len) &&
+     (!key1_len || curl_strnequal(k1, k2, key1_len)))
+    return 1;
+
+  return 0;
+}
+
 void Curl_hash_start_iterate(struct Curl_hash *hash,
                              struct Curl_hash_iterator *iter)
 {
@@ -93,6 +93,8 @@ int Curl_hash_delete(struct Curl_hash *h, void *key, size_t key_len);
 void *Curl_hash_pick(struct Curl_hash *, void *key, size_t key_len);
 
 void Curl_hash_destroy(struct Curl_hash *h);
+int Curl_hash_resize(struct Curl_hash *h, size_t slots);
+void Curl_hash_grow_if_needed(struct Curl_hash *h);
 size_t Curl_hash_count(struct Curl_hash *h);
 void Curl_hash_clean(struct Curl_hash *h);
 void Curl_hash_clean_with_criterium(struct Curl_hash *h, void *user,
@@ -100,6 +102,13 @@ void Curl_hash_clean_with_criterium(struct Curl_hash *h, void *user,
 size_t Curl_hash_str(void *key, size_t key_length, size_t slots_num);
 size_t curlx_str_key_compare(void *k1, size_t key1_len, void *k2,
                              size_t key2_len);
+size_t Curl_hash_str_nocase(void *key, size_t key_length, size_t slots_num);
+size_t Curl_hash_str_casecompare(void *k1, size_t key1_len, void *k2,
+                                 size_t key2_len);
+/* add `len` bytes at `mem` to the running hash value `h`, for fingerprints.
+   Start with CURL_HASH_SEED. */
+#define CURL_HASH_SEED 5381
+size_t Curl_hash_mix(size_t h, const void *mem, size_t len, bool nocase);
 void Curl_hash_start_iterate(struct Curl_hash *hash,
                              struct Curl_hash_iterator *iter);
 struct Curl_hash_element *
@@ -233,43 +233,61 @@ dnscache_prune(struct Curl_hash *hostcache, timediff_t cache_timeout_ms,
   return user.oldest_ms;
 }
 
-static struct Curl_dnscache *dnscache_get(struct Curl_easy *data)
+static bool dnscache_shared(struct Curl_easy *data)
 {
-  if(data->share && data->share->specifier & (1 << CURL_LOCK_DATA_DNS))
-    return &data->share->dnscache;
-  if(data->multi)
-    return &data->multi->dnscache;
-  return NULL;
+  return data->share && (data->share->specifier & (1 << CURL_LOCK_DATA_DNS));
+}
+
+/*
+ * Get all parts of the DNS cache, returns the number of them. A shared cache
+ * is split into parts with a lock each, to let threads use it in parallel.
+ */
+static size_t dnscache_all(struct Curl_easy *data,
+                           struct Curl_dnscache **dnscachep)
+{
+  if(dnscache_shared(data)) {
+    *dnscachep = data->share->dnscache;
+    return CURL_SHARE_DNS_SHARDS;
+  }
+  if(data->multi) {
+    *dnscachep = &data->multi->dnscache;
+    return 1;
+  }
+  *dnscachep = NULL;
+  return 0;
+}
+
+/* the part of the DNS cache that holds the entry with this id */
+static struct Curl_dnscache *dnscache_get(struct Curl_easy *data,
+                                          const char *id, size_t idlen)
+{
+  struct Curl_dnscache *dnscache;
+  size_t n = dnscache_all(data, &dnscache);
+  if(n > 1)
+    dnscache += Curl_hash_str(CURL_UNCONST(id), idlen, n);
+  return dnscache;
 }
 
 static void dnscache_lock(struct Curl_easy *data,
                           struct Curl_dnscache *dnscache)
 {
-  if(data->share && dnscache == &data->share->dnscache)
-    Curl_share_lock(data, CURL_LOCK_DATA_DNS, CURL_LOCK_ACCESS_SINGLE);
+  if(dnscache_shared(data))
+    Curl_share_lock_dns(data, (size_t)(dnscache - data->share->dnscache));
 }
 
 static void dnscache_unlock(struct Curl_easy *data,
                             struct Curl_dnscache *dnscache)
 {
-  if(data->share && dnscache == &data->share->dnscache)
-    Curl_share_unlock(data, CURL_LOCK_DATA_DNS);
+  if(dnscache_shared(data))
+    Curl_share_unlock_dns(data, (size_t)(dnscache - data->share->dnscache));
 }
 
-/*
- * Library-wide function for pruning the DNS cache. This function takes and
- * returns the appropriate locks.
- */
-void Curl_dnscache_prune(struct Curl_easy *data)
+static void dnscache_prune_part(struct Curl_easy *data,
+                                struct Curl_dnscache *dnscache,
+                                timediff_t timeout_ms,
+                                size_t max_size)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
   struct curltime now;
-  /* the timeout may be set -1 (forever) */
-  timediff_t timeout_ms = data->set.dns_cache_timeout_ms;
-
-  if(!dnscache || (timeout_ms == -1))
-    /* NULL hostcache means we cannot do it */
-    return;
 
   dnscache_lock(data, dnscache);
 
@@ -279,7 +297,7 @@ void Curl_dnscache_prune(struct Curl_easy *data)
     /* Remove outdated and unused entries from the hostcache */
     timediff_t oldest_ms = dnscache_prune(&dnscache->entries, timeout_ms, now);
 
-    if(Curl_hash_count(&dnscache->entries) > MAX_DNS_CACHE_SIZE) {
+    if(Curl_hash_count(&dnscache->entries) > max_size) {
       if(oldest_ms < INT_MAX)
         /* prune the ones over half this age */
         timeout_ms = (int)oldest_ms / 2;
@@ -296,13 +314,36 @@ void Curl_dnscache_prune(struct Curl_easy *data)
   dnscache_unlock(data, dnscache);
 }
 
+/*
+ * Library-wide function for pruning the DNS cache. This function takes and
+ * returns the appropriate locks.
+ */
+void Curl_dnscache_prune(struct Curl_easy *data)
+{
+  struct Curl_dnscache *dnscache;
+  size_t n = dnscache_all(data, &dnscache);
+  /* the timeout may be set -1 (forever) */
+  timediff_t timeout_ms = data->set.dns_cache_timeout_ms;
+  size_t i;
+
+  if(!n || (timeout_ms == -1))
+    /* NULL hostcache means we cannot do it */
+    return;
+
+  for(i = 0; i < n; i++)
+    dnscache_prune_part(data, &dnscache[i], timeout_ms,
+                        MAX_DNS_CACHE_SIZE / n);
+}
+
 void Curl_dnscache_clear(struct Curl_easy *data)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
-  if(dnscache) {
-    dnscache_lock(data, dnscache);
-    Curl_hash_clean(&dnscache->entries);
-    dnscache_unlock(data, dnscache);
+  struct Curl_dnscache *dnscache;
+  size_t n = dnscache_all(data, &dnscache);
+  size_t i;
+  for(i = 0; i < n; i++) {
+    dnscache_lock(data, &dnscache[i]);
+    Curl_hash_clean(&dnscache[i].entries);
+    dnscache_unlock(data, &dnscache[i]);
   }
 }
 
@@ -314,34 +355,26 @@ static sigjmp_buf curl_jmpenv;
 static curl_simple_lock curl_jmpenv_lock;
 #endif
 
-/* lookup address, returns entry if found and not stale */
-static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
-                                         struct Curl_dnscache *dnscache,
-                                         const char *hostname,
-                                         int port,
-                                         int ip_version)
+/*
+ * Lookup the entry with this id, returns it with its reference count
+ * increased if found and not stale.
+ */
+static struct Curl_dns_entry *dnscache_pick(struct Curl_easy *data,
+                                            const char *entry_id,
+                                            size_t entry_len,
+                                            int ip_version)
 {
+  struct Curl_dnscache *dnscache = dnscache_get(data, entry_id, entry_len);
   struct Curl_dns_entry *dns = NULL;
-  char entry_id[MAX_HOSTCACHE_LEN];
-  size_t entry_len;
 
   if(!dnscache)
     return NULL;
 
-  /* Create an entry id, based upon the hostname and port */
-  entry_len = create_dnscache_id(hostname, 0, port,
-                                 entry_id, sizeof(entry_id));
+  dnscache_lock(data, dnscache);
 
   /* See if it is already in our dns cache */
-  dns = Curl_hash_pick(&dnscache->entries, entry_id, entry_len + 1);
-
-  /* No entry found in cache, check if we might have a wildcard entry */
-  if(!dns && data->state.wildcard_resolve) {
-    entry_len = create_dnscache_id("*", 1, port, entry_id, sizeof(entry_id));
-
-    /* See if it is already in our dns cache */
-    dns = Curl_hash_pick(&dnscache->entries, entry_id, entry_len + 1);
-  }
+  dns = Curl_hash_pick(&dnscache->entries, CURL_UNCONST(entry_id),
+                       entry_len + 1);
 
   if(dns && (data->set.dns_cache_timeout_ms != -1)) {
     /* See whether the returned entry is stale. Done before we release lock */
@@ -354,7 +387,8 @@ static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
     if(dnscache_entry_is_stale(&user, dns)) {
       infof(data, "Hostname in DNS cache was stale, zapped");
       dns = NULL; /* the memory deallocation is being handled by the hash */
-      Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
+      Curl_hash_delete(&dnscache->entries, CURL_UNCONST(entry_id),
+                       entry_len + 1);
     }
   }
 
@@ -380,9 +414,37 @@ static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
     if(!found) {
       infof(data, "Hostname in DNS cache does not have needed family, zapped");
       dns = NULL; /* the memory deallocation is being handled by the hash */
-      Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
+      Curl_hash_delete(&dnscache->entries, CURL_UNCONST(entry_id),
+                       entry_len + 1);
     }
   }
+  if(dns)
+    dns->refcount++; /* we use it! */
+
+  dnscache_unlock(data, dnscache);
+  return dns;
+}
+
+/* lookup address, returns a reference to the entry if found and not stale */
+static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
+                                         const char *hostname,
+                                         int port,
+                                         int ip_version)
+{
+  struct Curl_dns_entry *dns;
+  char entry_id[MAX_HOSTCACHE_LEN];
+  size_t entry_len;
+
+  /* Create an entry id, based upon the hostname and port */
+  entry_len = create_dnscache_id(hostname, 0, port,
+                                 entry_id, sizeof(entry_id));
+  dns = dnscache_pick(data, entry_id, entry_len, ip_version);
+
+  /* No entry found in cache, check if we might have a wildcard entry */
+  if(!dns && data->state.wildcard_resolve) {
+    entry_len = create_dnscache_id("*", 1, port, entry_id, sizeof(entry_id));
+    dns = dnscache_pick(data, entry_id, entry_len, ip_version);
+  }
   return dns;
 }
 
@@ -406,18 +468,7 @@ Curl_dnscache_get(struct Curl_easy *data,
                   int port,
                   int ip_version)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
-  struct Curl_dns_entry *dns = NULL;
-
-  dnscache_lock(data, dnscache);
-
-  dns = fetch_addr(data, dnscache, hostname, port, ip_version);
-  if(dns)
-    dns->refcount++; /* we use it! */
-
-  dnscache_unlock(data, dnscache);
-
-  return dns;
+  return fetch_addr(data, hostname, port, ip_version);
 }
 
 #ifndef CURL_DISABLE_SHUFFLE_DNS
@@ -588,15 +639,16 @@ dnscache_add_addr(struct Curl_easy *data,
 CURLcode Curl_dnscache_add(struct Curl_easy *data,
                            struct Curl_dns_entry *entry)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
+  struct Curl_dnscache *dnscache;
   char id[MAX_HOSTCACHE_LEN];
   size_t idlen;
 
-  if(!dnscache)
-    return CURLE_FAILED_INIT;
   /* Create an entry id, based upon the hostname and port */
   idlen = create_dnscache_id(entry->hostname, 0, entry->hostport,
                              id, sizeof(id));
+  dnscache = dnscache_get(data, id, idlen);
+  if(!dnscache)
+    return CURLE_FAILED_INIT;
 
   /* Store the resolved data in our DNS cache and up ref count */
   dnscache_lock(data, dnscache);
@@ -804,18 +856,26 @@ static CURLcode store_negative_resolve(struct Curl_easy *data,
                                        const char *host,
                                        int port)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
+  struct Curl_dnscache *dnscache;
   struct Curl_dns_entry *dns;
+  char entry_id[MAX_HOSTCACHE_LEN];
+  size_t entry_len;
+
+  entry_len = create_dnscache_id(host, 0, port, entry_id, sizeof(entry_id));
+  dnscache = dnscache_get(data, entry_id, entry_len);
   DEBUGASSERT(dnscache);
   if(!dnscache)
     return CURLE_FAILED_INIT;
 
   /* put this new host in the cache */
+  dnscache_lock(data, dnscache);
   dns = dnscache_add_addr(data, dnscache, NULL, host, 0, port, FALSE);
-  if(dns) {
+  if(dns)
     /* release the returned reference; the cache itself will keep the
      * entry alive: */
     dns->refcount--;
+  dnscache_unlock(data, dnscache);
+  if(dns) {
     infof(data, "Store negative name resolve for %s:%d", host, port);
     return CURLE_OK;
   }
@@ -845,7 +905,7 @@ CURLcode Curl_resolv(struct Curl_easy *data,
                      bool allowDOH,
                      struct Curl_dns_entry **entry)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
+  struct Curl_dnscache *dnscache;
   struct Curl_dns_entry *dns = NULL;
   struct Curl_addrinfo *addr = NULL;
   int respwait = 0;
@@ -857,7 +917,7 @@ CURLcode Curl_resolv(struct Curl_easy *data,
 #else
   (void)allowDOH;
 #endif
-  if(!dnscache)
+  if(!dnscache_all(data, &dnscache))
     goto error;
 
   /* We should intentionally error and not resolve .onion TLDs */
@@ -869,12 +929,8 @@ CURLcode Curl_resolv(struct Curl_easy *data,
     goto error;
   }
 
-  /* Let's check our DNS cache first */
-  dnscache_lock(data, dnscache);
-  dns = fetch_addr(data, dnscache, hostname, port, ip_version);
-  if(dns)
-    dns->refcount++; /* we pass out the reference. */
-  dnscache_unlock(data, dnscache);
+  /* Let's check our DNS cache first, we pass out the reference */
+  dns = fetch_addr(data, hostname, port, ip_version);
   if(dns) {
     infof(data, "Hostname %s was found in DNS cache", hostname);
     goto out;
@@ -1218,9 +1274,15 @@ static void dnscache_entry_free(struct Curl_dns_entry *dns)
 void Curl_resolv_unlink(struct Curl_easy *data, struct Curl_dns_entry **pdns)
 {
   if(*pdns) {
-    struct Curl_dnscache *dnscache = dnscache_get(data);
     struct Curl_dns_entry *dns = *pdns;
+    struct Curl_dnscache *dnscache;
+    char entry_id[MAX_HOSTCACHE_LEN];
+    size_t entry_len;
     *pdns = NULL;
+    /* the lock of the cache part the entry belongs to */
+    entry_len = create_dnscache_id(dns->hostname, 0, dns->hostport,
+                                   entry_id, sizeof(entry_id));
+    dnscache = dnscache_get(data, entry_id, entry_len);
     dnscache_lock(data, dnscache);
     dns->refcount--;
     if(dns->refcount == 0)
@@ -1254,10 +1316,10 @@ void Curl_dnscache_destroy(struct Curl_dnscache *dns)
 
 CURLcode Curl_loadhostpairs(struct Curl_easy *data)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
+  struct Curl_dnscache *dnscache;
   struct curl_slist *hostp;
 
-  if(!dnscache)
+  if(!dnscache_all(data, &dnscache))
     return CURLE_FAILED_INIT;
 
   /* Default is no wildcard found */
@@ -1291,6 +1353,7 @@ CURLcode Curl_loadhostpairs(struct Curl_easy *data)
         entry_len = create_dnscache_id(curlx_str(&source),
                                        curlx_strlen(&source), (int)num,
                                        entry_id, sizeof(entry_id));
+        dnscache = dnscache_get(data, entry_id, entry_len);
         dnscache_lock(data, dnscache);
         /* delete entry, ignore if it did not exist */
         Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
@@ -1399,6 +1462,7 @@ err:
                                      (int)port,
                                      entry_id, sizeof(entry_id));
 
+      dnscache = dnscache_get(data, entry_id, entry_len);
       dnscache_lock(data, dnscache);
 
       /* See if it is already in our dns cache */
@@ -39,8 +39,16 @@
 #include "rename.h"
 #include "share.h"
 #include "strdup.h"
+#include "strcase.h"
 #include "curlx/strparse.h"
 
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
@@ -50,6 +58,25 @@
 #define MAX_HSTS_HOSTLEN 2048
 #define MAX_HSTS_DATELEN 256
 #define UNLIMITED "unlimited"
+#define HSTS_HASH_SIZE 63
+
+/* The binary preload file format, see docs/HSTS.md */
+#define PRELOAD_MAGIC "curlHSTS"
+#define PRELOAD_VERSION 1
+#define PRELOAD_HEADER 16 /* magic, version and entry count */
+#define PRELOAD_HOST 9    /* expiry and flags precede the hostname */
+#define PRELOAD_SUBDOMAINS 0x01
+#define MAX_PRELOAD_SIZE 0x7fffffff
+
+/* A preload file, mapped or read into memory as a whole */
+struct hsts_preload {
+  struct hsts_preload *next;
+  char *filename;
+  const unsigned char *data;
+  size_t size;
+  size_t count;
+  BIT(mapped);
+};
 
 #if defined(DEBUGBUILD) || defined(UNITTESTS)
 /* to play well with debug builds, we can *set* a fixed time this will
@@ -71,38 +98,78 @@ static time_t hsts_debugtime(void *unused)
 #define time(x) hsts_debugtime(x)
 #endif
 
+static void hsts_free(struct stsentry *e)
+{
+  free(CURL_UNCONST(e->host));
+  free(e);
+}
+
+/* the hash owns the entries, removing one also unlinks it from the list */
+static void hsts_dtor(void *p)
+{
+  struct stsentry *sts = p;
+  Curl_node_remove(&sts->node);
+  hsts_free(sts);
+}
+
 struct hsts *Curl_hsts_init(void)
 {
   struct hsts *h = calloc(1, sizeof(struct hsts));
   if(h) {
     Curl_llist_init(&h->list, NULL);
+    Curl_hash_init(&h->hosts, HSTS_HASH_SIZE, Curl_hash_str_nocase,
+                   Curl_hash_str_casecompare, hsts_dtor);
   }
   return h;
 }
 
-static void hsts_free(struct stsentry *e)
+static void hsts_remove(struct hsts *h, struct stsentry *sts)
 {
-  free(CURL_UNCONST(e->host));
-  free(e);
+  Curl_hash_delete(&h->hosts, CURL_UNCONST(sts->host), strlen(sts->host));
+}
+
+static void hsts_preload_free(struct hsts *h)
+{
+  while(h->preload) {
+    struct hsts_preload *p = h->preload;
+    h->preload = p->next;
+#ifdef HAVE_MMAP
+    if(p->mapped)
+      munmap(CURL_UNCONST(p->data), p->size);
+    else
+#endif
+      free(CURL_UNCONST(p->data));
+    free(p->filename);
+    free(p);
+  }
 }
 
 void Curl_hsts_cleanup(struct hsts **hp)
 {
   struct hsts *h = *hp;
   if(h) {
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
-    for(e = Curl_llist_head(&h->list); e; e = n) {
-      struct stsentry *sts = Curl_node_elem(e);
-      n = Curl_node_next(e);
-      hsts_free(sts);
-    }
+    Curl_hash_destroy(&h->hosts);
+    hsts_preload_free(h);
     free(h->filename);
     free(h);
     *hp = NULL;
   }
 }
 
+/* remove the expired entries, lookups leave them in place */
+static void hsts_expire(struct hsts *h)
+{
+  time_t now = time(NULL);
+  struct Curl_llist_node *e;
+  struct Curl_llist_node *n;
+  for(e = Curl_llist_head(&h->list); e; e = n) {
+    struct stsentry *sts = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if(sts->expires <= now)
+      hsts_remove(h, sts);
+  }
+}
+
 static CURLcode hsts_create(struct hsts *h,
                             const char *hostname,
                             size_t hlen,
@@ -130,11 +197,183 @@ static CURLcode hsts_create(struct hsts *h,
     sts->host = duphost;
     sts->expires = expires;
     sts->includeSubDomains = subdomains;
+    /* prune each time the cache doubles, to keep the cost per entry low */
+    if(Curl_llist_count(&h->list) >= h->expire_at) {
+      hsts_expire(h);
+      h->expire_at = Curl_llist_count(&h->list) * 2 + HSTS_HASH_SIZE;
+    }
+    /* an existing entry for the same host is replaced */
+    if(!Curl_hash_add(&h->hosts, duphost, hlen, sts)) {
+      hsts_free(sts);
+      return CURLE_OUT_OF_MEMORY;
+    }
     Curl_llist_append(&h->list, sts, &sts->node);
+    Curl_hash_grow_if_needed(&h->hosts);
   }
   return CURLE_OK;
 }
 
+/*
+ * The cached entry for exactly this hostname. Expired entries are ignored but
+ * left in place, a lookup does not modify the cache so that it can be done
+ * with a shared lock. They are pruned as the cache grows and when it is
+ * saved.
+ */
+static struct stsentry *hsts_pick(struct hsts *h, const char *host,
+                                  size_t hlen, time_t now)
+{
+  struct stsentry *sts = Curl_hash_pick(&h->hosts, CURL_UNCONST(host), hlen);
+  if(sts && (sts->expires <= now))
+    sts = NULL;
+  return sts;
+}
+
+static size_t preload_uint32(const unsigned char *p)
+{
+  return ((size_t)p[0] << 24) | ((size_t)p[1] << 16) |
+    ((size_t)p[2] << 8) | (size_t)p[3];
+}
+
+/* the offset of entry 'i' in the file, or zero if it is out of bounds */
+static size_t preload_offset(const struct hsts_preload *p, size_t i)
+{
+  size_t offs = preload_uint32(&p->data[PRELOAD_HEADER + (i * 4)]);
+  if((offs < PRELOAD_HEADER + (p->count * 4)) ||
+     (offs >= p->size - PRELOAD_HOST))
+    return 0;
+  return offs;
+}
+
+/*
+ * Compare the hostname, case-insensitively, with the lowercase zero
+ * terminated name of an entry that has at most 'max' bytes left in the file.
+ */
+static int preload_cmp(const char *host, size_t hlen,
+                       const unsigned char *name, size_t max)
+{
+  size_t i;
+  for(i = 0; i < hlen; i++) {
+    unsigned char c = (unsigned char)Curl_raw_tolower(host[i]);
+    if(i == max)
+      return 1;
+    if(c != name[i])
+      return (c < name[i]) ? -1 : 1;
+  }
+  return ((i < max) && !name[i]) ? 0 : -1;
+}
+
+static curl_off_t preload_expires(const unsigned char *entry)
+{
+  curl_off_t expires = 0;
+  int i;
+  if(entry[0] & 0x80)
+    /* negative, expired long ago */
+    return 0;
+  for(i = 0; i < 8; i++)
+    expires = (expires << 8) | entry[i];
+  return (expires > TIME_T_MAX) ? TIME_T_MAX : expires;
+}
+
+/*
+ * Binary search the preload files for exactly this hostname. A match is
+ * returned in the 'pre' struct provided by the caller.
+ */
+static struct stsentry *hsts_preload_find(struct hsts *h, const char *host,
+                                          size_t hlen, time_t now,
+                                          struct stsentry *pre)
+{
+  struct hsts_preload *p;
+  for(p = h->preload; p; p = p->next) {
+    size_t lo = 0;
+    size_t hi = p->count;
+    while(lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      size_t offs = preload_offset(p, mid);
+      const unsigned char *entry = &p->data[offs];
+      int cmp;
+      if(!offs)
+        /* broken file */
+        break;
+      cmp = preload_cmp(host, hlen, &entry[PRELOAD_HOST],
+                        p->size - offs - PRELOAD_HOST);
+      if(!cmp) {
+        curl_off_t expires = preload_expires(entry);
+        bool subdomains = (entry[8] & PRELOAD_SUBDOMAINS) ? TRUE : FALSE;
+        if(expires <= now)
+          break;
+        pre->host = (const char *)&entry[PRELOAD_HOST];
+        pre->expires = expires;
+        pre->includeSubDomains = subdomains;
+        return pre;
+      }
+      if(cmp < 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Find the entry for the hostname, or with 'subdomain' set the closest
+ * parent domain entry that includes subdomains. With 'preload' set, the
+ * preload files are searched after the cache and a match is stored there.
+ */
+static struct stsentry *hsts_find(struct hsts *h, const char *hostname,
+                                  size_t hlen, bool subdomain,
+                                  struct stsentry *preload)
+{
+  time_t now = time(NULL);
+  struct stsentry *sts;
+  size_t i;
+
+  if((hlen > MAX_HSTS_HOSTLEN) || !hlen)
+    return NULL;
+  if(hostname[hlen-1] == '.')
+    /* remove the trailing dot */
+    --hlen;
+
+  sts = hsts_pick(h, hostname, hlen, now);
+  if(!sts && preload)
+    sts = hsts_preload_find(h, hostname, hlen, now, preload);
+  if(sts || !subdomain)
+    return sts;
+
+  /* the parent domains, the longest first */
+  for(i = 0; i + 1 < hlen; i++) {
+    if(hostname[i] == '.') {
+      const char *tail = &hostname[i + 1];
+      size_t tlen = hlen - i - 1;
+      sts = hsts_pick(h, tail, tlen, now);
+      if(sts && sts->includeSubDomains)
+        return sts;
+      if(preload) {
+        sts = hsts_preload_find(h, tail, tlen, now, preload);
+        if(sts && sts->includeSubDomains)
+          return sts;
+      }
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Return the HSTS entry if the given hostname is currently an HSTS one.
+ *
+ * The 'subdomain' argument tells the function if subdomain matching should be
+ * attempted. An entry from a preload file is returned in 'pre'. The cache is
+ * not modified.
+ */
+struct stsentry *Curl_hsts(struct hsts *h, const char *hostname,
+                           size_t hlen, bool subdomain,
+                           struct stsentry *pre)
+{
+  if(h)
+    return hsts_find(h, hostname, hlen, subdomain, pre);
+  return NULL;
+}
+
 CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
                          const char *header)
 {
@@ -208,11 +447,9 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
 
   if(!expires) {
     /* remove the entry if present verbatim (without subdomain match) */
-    sts = Curl_hsts(h, hostname, hlen, FALSE);
-    if(sts) {
-      Curl_node_remove(&sts->node);
-      hsts_free(sts);
-    }
+    sts = hsts_find(h, hostname, hlen, FALSE, NULL);
+    if(sts)
+      hsts_remove(h, sts);
     return CURLE_OK;
   }
 
@@ -223,7 +460,7 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
     expires += now;
 
   /* check if it already exists */
-  sts = Curl_hsts(h, hostname, hlen, FALSE);
+  sts = hsts_find(h, hostname, hlen, FALSE, NULL);
   if(sts) {
     /* just update these fields */
     sts->expires = expires;
@@ -235,55 +472,13 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
   return CURLE_OK;
 }
 
-/*
- * Return TRUE if the given hostname is currently an HSTS one.
- *
- * The 'subdomain' argument tells the function if subdomain matching should be
- * attempted.
- */
-struct stsentry *Curl_hsts(struct hsts *h, const char *hostname,
-                           size_t hlen, bool subdomain)
+static bool hsts_preloaded(struct hsts *h, const char *file)
 {
-  struct stsentry *bestsub = NULL;
-  if(h) {
-    time_t now = time(NULL);
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
-    size_t blen = 0;
-
-    if((hlen > MAX_HSTS_HOSTLEN) || !hlen)
-      return NULL;
-    if(hostname[hlen-1] == '.')
-      /* remove the trailing dot */
-      --hlen;
-
-    for(e = Curl_llist_head(&h->list); e; e = n) {
-      struct stsentry *sts = Curl_node_elem(e);
-      size_t ntail;
-      n = Curl_node_next(e);
-      if(sts->expires <= now) {
-        /* remove expired entries */
-        Curl_node_remove(&sts->node);
-        hsts_free(sts);
-        continue;
-      }
-      ntail = strlen(sts->host);
-      if((subdomain && sts->includeSubDomains) && (ntail < hlen)) {
-        size_t offs = hlen - ntail;
-        if((hostname[offs-1] == '.') &&
-           curl_strnequal(&hostname[offs], sts->host, ntail) &&
-           (ntail > blen)) {
-          /* save the tail match with the longest tail */
-          bestsub = sts;
-          blen = ntail;
-        }
-      }
-      /* avoid curl_strequal because the host name is not null-terminated */
-      if((hlen == ntail) && curl_strnequal(hostname, sts->host, hlen))
-        return sts;
-    }
-  }
-  return bestsub;
+  struct hsts_preload *p;
+  for(p = h->preload; p; p = p->next)
+    if(!strcmp(p->filename, file))
+      return TRUE;
+  return FALSE;
 }
 
 /*
@@ -359,12 +554,15 @@ CURLcode Curl_hsts_save(struct Curl_easy *data, struct hsts *h,
     /* no cache activated */
     return CURLE_OK;
 
+  hsts_expire(h);
+
   /* if no new name is given, use the one we stored from the load */
   if(!file && h->filename)
     file = h->filename;
 
-  if((h->flags & CURLHSTS_READONLYFILE) || !file || !file[0])
-    /* marked as read-only, no file or zero length filename */
+  if((h->flags & CURLHSTS_READONLYFILE) || !file || !file[0] ||
+     hsts_preloaded(h, file))
+    /* marked as read-only, no file, zero length filename or preload file */
     goto skipsave;
 
   result = Curl_fopen(data, file, &out, &tempstore);
@@ -439,12 +637,17 @@ static CURLcode hsts_add(struct hsts *h, const char *line)
     else
       Curl_getdate_capped(dbuf, &expires);
 
+    if(expires <= time(NULL))
+      /* already expired, lookups do not prune so do not load it */
+      return CURLE_OK;
+
     if(hp[0] == '.') {
       curlx_str_nudge(&host, 1);
       subdomain = TRUE;
     }
     /* only add it if not already present */
-    e = Curl_hsts(h, curlx_str(&host), curlx_strlen(&host), subdomain);
+    e = hsts_find(h, curlx_str(&host), curlx_strlen(&host), subdomain,
+                  NULL);
     if(!e)
       result = hsts_create(h, curlx_str(&host), curlx_strlen(&host),
                            subdomain, expires);
@@ -504,6 +707,92 @@ static CURLcode hsts_pull(struct Curl_easy *data, struct hsts *h)
   return CURLE_OK;
 }
 
+/*
+ * Use the file as a read-only preload list if it starts with the preload
+ * magic. It is mapped into memory where possible, otherwise read, and the
+ * entries are looked up in place.
+ */
+static CURLcode hsts_preload_load(struct hsts *h, const char *file,
+                                  bool *preload)
+{
+  CURLcode result = CURLE_OK;
+  unsigned char head[PRELOAD_HEADER];
+  struct hsts_preload *p;
+  unsigned char *data = NULL;
+  bool mapped = FALSE;
+  struct_stat sb;
+  size_t size;
+  size_t count;
+  FILE *fp;
+
+  *preload = FALSE;
+  fp = fopen(file, "rb");
+  if(!fp)
+    return CURLE_OK;
+  if((fread(head, 1, sizeof(head), fp) != sizeof(head)) ||
+     memcmp(head, PRELOAD_MAGIC, 8))
+    goto out;
+
+  *preload = TRUE;
+  if(hsts_preloaded(h, file))
+    /* already loaded */
+    goto out;
+
+  count = preload_uint32(&head[12]);
+  if((preload_uint32(&head[8]) != PRELOAD_VERSION) ||
+     fstat(fileno(fp), &sb) ||
+     ((curl_off_t)sb.st_size > MAX_PRELOAD_SIZE))
+    goto out;
+  size = (size_t)sb.st_size;
+  if((size < PRELOAD_HEADER + PRELOAD_HOST) ||
+     (count > (size - PRELOAD_HEADER) / 4))
+    /* it cannot hold that many entries */
+    goto out;
+
+#ifdef HAVE_MMAP
+  data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  if(data == MAP_FAILED)
+    data = NULL;
+  else
+    mapped = TRUE;
+#endif
+  if(!data) {
+    data = malloc(size);
+    if(!data) {
+      result = CURLE_OUT_OF_MEMORY;
+      goto out;
+    }
+    if(fseek(fp, 0, SEEK_SET) || (fread(data, 1, size, fp) != size)) {
+      free(data);
+      goto out;
+    }
+  }
+
+  p = calloc(1, sizeof(*p));
+  if(p)
+    p->filename = strdup(file);
+  if(!p || !p->filename) {
+#ifdef HAVE_MMAP
+    if(mapped)
+      munmap(data, size);
+    else
+#endif
+      free(data);
+    free(p);
+    result = CURLE_OUT_OF_MEMORY;
+    goto out;
+  }
+  p->data = data;
+  p->size = size;
+  p->count = count;
+  p->mapped = mapped;
+  p->next = h->preload;
+  h->preload = p;
+out:
+  fclose(fp);
+  return result;
+}
+
 /*
  * Load the HSTS cache from the given file. The text based line-oriented file
  * format is documented here: https://curl.se/docs/hsts.html
@@ -514,9 +803,15 @@ static CURLcode hsts_pull(struct Curl_easy *data, struct hsts *h)
  */
 static CURLcode hsts_load(struct hsts *h, const char *file)
 {
-  CURLcode result = CURLE_OK;
+  CURLcode result;
+  bool preload;
   FILE *fp;
 
+  result = hsts_preload_load(h, file, &preload);
+  if(result || preload)
+    /* a preload file is never saved to */
+    return result;
+
   /* we need a private copy of the filename so that the hsts cache file
      name survives an easy handle reset */
   free(h->filename);
@@ -28,6 +28,7 @@
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_HSTS)
 #include <curl/curl.h>
 #include "llist.h"
+#include "hash.h"
 
 #if defined(DEBUGBUILD) || defined(UNITTESTS)
 extern time_t deltatime;
@@ -40,10 +41,16 @@ struct stsentry {
   BIT(includeSubDomains);
 };
 
-/* The HSTS cache. Needs to be able to tailmatch hostnames. */
+struct hsts_preload;
+
+/* The HSTS cache. Entries are indexed on their hostname, a subdomain match
+   looks up each parent domain in turn. */
 struct hsts {
-  struct Curl_llist list;
+  struct Curl_llist list;       /* all entries, in the order they were added */
+  struct Curl_hash hosts;       /* the same entries, keyed on hostname */
+  struct hsts_preload *preload; /* read-only binary preload files */
   char *filename;
+  size_t expire_at;             /* prune expired entries at this count */
   unsigned int flags;
 };
 
@@ -52,7 +59,8 @@ void Curl_hsts_cleanup(struct hsts **hp);
 CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
                          const char *sts);
 struct stsentry *Curl_hsts(struct hsts *h, const char *hostname,
-                           size_t hlen, bool subdomain);
+                           size_t hlen, bool subdomain,
+                           struct stsentry *pre);
 CURLcode Curl_hsts_save(struct Curl_easy *data, struct hsts *h,
                         const char *file);
 CURLcode Curl_hsts_loadfile(struct Curl_easy *data,
@@ -82,6 +82,7 @@
 #include "connect.h"
 #include "strdup.h"
 #include "altsvc.h"
+#include "cdict.h"
 #include "hsts.h"
 #include "ws.h"
 #include "curl_ctype.h"
@@ -1547,6 +1548,7 @@ CURLcode Curl_http_done(struct Curl_easy *data,
                       entire operation is complete */
      !conn->bits.retry &&
      !data->set.connect_only &&
+     !data->state.prewarm &&
      (data->req.bytecount +
       data->req.headerbytecount -
       data->req.deductheadercount) <= 0) {
@@ -1559,7 +1561,7 @@ CURLcode Curl_http_done(struct Curl_easy *data,
     return CURLE_GOT_NOTHING;
   }
 
-  return CURLE_OK;
+  return Curl_cdict_done(data, premature);
 }
 
 /* Determine if we may use HTTP 1.1 for this request. */
@@ -2236,6 +2238,22 @@ static CURLcode http_resume(struct Curl_easy *data, Curl_HttpReq httpreq)
   return CURLE_OK;
 }
 
+static CURLcode http_upload_encoding(struct Curl_easy *data)
+{
+  const char *enc = data->set.str[STRING_UPLOAD_ENCODING];
+  CURLcode result;
+
+  /* Compress the request body, if there is one. The compressed length is
+   * not known in advance, making the upload chunked on HTTP/1.1 */
+  if(!enc || data->req.authneg || !Curl_creader_total_length(data))
+    return CURLE_OK;
+
+  result = Curl_upload_encoder_add(data, enc);
+  if(!result)
+    data->req.upload_encoded = TRUE;
+  return result;
+}
+
 static CURLcode http_req_set_TE(struct Curl_easy *data,
                                 struct dynbuf *req,
                                 int httpversion)
@@ -2408,43 +2426,43 @@ static CURLcode http_cookies(struct Curl_easy *data,
     addcookies = data->set.str[STRING_COOKIE];
 
   if(data->cookies || addcookies) {
-    struct Curl_llist list;
     int count = 0;
 
     if(data->cookies && data->state.cookie_engine) {
+      const struct Cookie *list[MAX_COOKIE_SEND_AMOUNT];
       const char *host = data->state.aptr.cookiehost ?
         data->state.aptr.cookiehost : data->conn->host.name;
-      Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SINGLE);
-      if(!Curl_cookie_getlist(data, data->conn, host, &list)) {
-        struct Curl_llist_node *n;
-        size_t clen = 8; /* hold the size of the generated Cookie: header */
-
-        /* loop through all cookies that matched */
-        for(n = Curl_llist_head(&list); n; n = Curl_node_next(n)) {
-          struct Cookie *co = Curl_node_elem(n);
-          if(co->value) {
-            size_t add;
-            if(!count) {
-              result = curlx_dyn_addn(r, STRCONST("Cookie: "));
-              if(result)
-                break;
-            }
-            add = strlen(co->name) + strlen(co->value) + 1;
-            if(clen + add >= MAX_COOKIE_HEADER_LEN) {
-              infof(data, "Restricted outgoing cookies due to header size, "
-                    "'%s' not sent", co->name);
-              linecap = TRUE;
-              break;
-            }
-            result = curlx_dyn_addf(r, "%s%s=%s", count ? "; " : "",
-                                    co->name, co->value);
+      size_t matches;
+      size_t i;
+      size_t clen = 8; /* hold the size of the generated Cookie: header */
+      /* reading the jar does not modify it */
+      Curl_share_lock(data, CURL_LOCK_DATA_COOKIE, CURL_LOCK_ACCESS_SHARED);
+      matches = Curl_cookie_getlist(data, data->conn, host, list);
+
+      /* loop through all cookies that matched */
+      for(i = 0; i < matches; i++) {
+        const struct Cookie *co = list[i];
+        if(co->value) {
+          size_t add;
+          if(!count) {
+            result = curlx_dyn_addn(r, STRCONST("Cookie: "));
             if(result)
               break;
-            clen += add + (count ? 2 : 0);
-            count++;
           }
+          add = strlen(co->name) + strlen(co->value) + 1;
+          if(clen + add >= MAX_COOKIE_HEADER_LEN) {
+            infof(data, "Restricted outgoing cookies due to header size, "
+                  "'%s' not sent", co->name);
+            linecap = TRUE;
+            break;
+          }
+          result = curlx_dyn_addf(r, "%s%s=%s", count ? "; " : "",
+                                  co->name, co->value);
+          if(result)
+            break;
+          clen += add + (count ? 2 : 0);
+          count++;
         }
-        Curl_llist_destroy(&list, NULL);
       }
       Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
     }
@@ -2681,6 +2699,7 @@ typedef enum {
 #ifndef CURL_DISABLE_PROXY
   H1_HD_PROXY_CONNECTION,
 #endif
+  H1_HD_CONTENT_ENCODING,
   H1_HD_TRANSFER_ENCODING,
 #ifndef CURL_DISABLE_ALTSVC
   H1_HD_ALT_USED,
@@ -2761,9 +2780,15 @@ static CURLcode http_add_hd(struct Curl_easy *data,
   case H1_HD_ACCEPT_ENCODING:
     Curl_safefree(data->state.aptr.accept_encoding);
     if(!Curl_checkheaders(data, STRCONST("Accept-Encoding")) &&
-       data->set.str[STRING_ENCODING])
-      result = curlx_dyn_addf(req, "Accept-Encoding: %s\r\n",
-                              data->set.str[STRING_ENCODING]);
+       data->set.str[STRING_ENCODING]) {
+      /* accept dictionary compression when a dictionary is offered */
+      const char *dcenc = Curl_cdict_accept(data);
+      result = curlx_dyn_addf(req, "Accept-Encoding: %s%s%s\r\n",
+                              data->set.str[STRING_ENCODING],
+                              dcenc ? ", " : "", dcenc ? dcenc : "");
+    }
+    if(!result)
+      result = Curl_cdict_add_headers(data, req);
     break;
 
   case H1_HD_REFERER:
@@ -2782,6 +2807,13 @@ static CURLcode http_add_hd(struct Curl_easy *data,
     break;
 #endif
 
+  case H1_HD_CONTENT_ENCODING:
+    if(data->req.upload_encoded &&
+       !Curl_checkheaders(data, STRCONST("Content-Encoding")))
+      result = curlx_dyn_addf(req, "Content-Encoding: %s\r\n",
+                              data->set.str[STRING_UPLOAD_ENCODING]);
+    break;
+
   case H1_HD_TRANSFER_ENCODING:
     result = http_req_set_TE(data, req, httpversion);
     break;
@@ -2843,6 +2875,22 @@ static CURLcode http_add_hd(struct Curl_easy *data,
  * request is to be performed. This creates and sends a properly constructed
  * HTTP request.
  */
+/*
+ * A pre-connect transfer stops when connected. Settle the HTTP version of
+ * the new connection like the first request does, so that transfers that
+ * may multiplex can reuse it from the pool.
+ */
+CURLcode Curl_http_prewarm(struct Curl_easy *data)
+{
+  struct connectdata *conn = data->conn;
+  CURLcode result = http_check_new_conn(data);
+  if(!result && !conn->httpversion_seen) {
+    unsigned char v = Curl_conn_http_version(data, conn);
+    conn->httpversion_seen = v ? v : 11;
+  }
+  return result;
+}
+
 CURLcode Curl_http(struct Curl_easy *data, bool *done)
 {
   CURLcode result = CURLE_OK;
@@ -2907,6 +2955,10 @@ CURLcode Curl_http(struct Curl_easy *data, bool *done)
   result = set_reader(data, httpreq);
   if(!result)
     result = http_resume(data, httpreq);
+  if(!result)
+    result = http_upload_encoding(data);
+  if(!result)
+    result = Curl_cdict_select(data);
   if(!result)
     result = http_range(data, httpreq);
   if(result)
@@ -3341,6 +3393,9 @@ static CURLcode http_header_s(struct Curl_easy *data,
 {
 #if !defined(CURL_DISABLE_COOKIES) || !defined(CURL_DISABLE_HSTS)
   struct connectdata *conn = data->conn;
+#endif
+#if !defined(CURL_DISABLE_COOKIES) || !defined(CURL_DISABLE_HSTS) || \
+  !defined(CURL_DISABLE_WEBSOCKETS)
   const char *v;
 #else
   (void)data;
@@ -3348,6 +3403,13 @@ static CURLcode http_header_s(struct Curl_easy *data,
   (void)hdlen;
 #endif
 
+#ifndef CURL_DISABLE_WEBSOCKETS
+  v = (data->req.upgr101 == UPGR101_WS) ?
+    HD_VAL(hd, hdlen, "Sec-WebSocket-Extensions:") : NULL;
+  if(v)
+    return Curl_ws_extensions(data, v);
+#endif
+
 #ifndef CURL_DISABLE_COOKIES
   v = (data->cookies && data->state.cookie_engine) ?
     HD_VAL(hd, hdlen, "Set-Cookie:") : NULL;
@@ -3361,6 +3423,7 @@ static CURLcode http_header_s(struct Curl_easy *data,
     Curl_cookie_add(data, data->cookies, TRUE, FALSE, v, host,
                     data->state.up.path, secure_context);
     Curl_share_unlock(data, CURL_LOCK_DATA_COOKIE);
+    Curl_cookie_journal_compact(data);
     return CURLE_OK;
   }
 #endif
@@ -3377,8 +3440,9 @@ static CURLcode http_header_s(struct Curl_easy *data,
          )
     ) ? HD_VAL(hd, hdlen, "Strict-Transport-Security:") : NULL;
   if(v) {
-    CURLcode check =
-      Curl_hsts_parse(data->hsts, conn->host.name, v);
+    CURLcode check;
+    Curl_share_lock(data, CURL_LOCK_DATA_HSTS, CURL_LOCK_ACCESS_SINGLE);
+    check = Curl_hsts_parse(data->hsts, conn->host.name, v);
     if(check)
       infof(data, "Illegal STS header skipped");
 #ifdef DEBUGBUILD
@@ -3386,6 +3450,7 @@ static CURLcode http_header_s(struct Curl_easy *data,
       infof(data, "Parsed STS header fine (%zu entries)",
             Curl_llist_count(&data->hsts->list));
 #endif
+    Curl_share_unlock(data, CURL_LOCK_DATA_HSTS);
   }
 #endif
 
@@ -3438,6 +3503,28 @@ static CURLcode http_header_t(struct Curl_easy *data,
   return CURLE_OK;
 }
 
+/*
+ * http_header_u() parses a single response header starting with U.
+ */
+static CURLcode http_header_u(struct Curl_easy *data,
+                              const char *hd, size_t hdlen)
+{
+#ifdef USE_COMPRESSION_DICT
+  struct SingleRequest *k = &data->req;
+  const char *v = (data->set.cdict_learn && !k->http_bodyless &&
+                   (k->httpcode / 100 == 2) &&
+                   (data->state.httpreq != HTTPREQ_HEAD)) ?
+    HD_VAL(hd, hdlen, "Use-As-Dictionary:") : NULL;
+  if(v)
+    return Curl_cdict_parse(data, v);
+#else
+  (void)data;
+  (void)hd;
+  (void)hdlen;
+#endif
+  return CURLE_OK;
+}
+
 /*
  * http_header_w() parses a single response header starting with W.
  */
@@ -3494,6 +3581,10 @@ static CURLcode http_header(struct Curl_easy *data,
   case 'T':
     result = http_header_t(data, hd, hdlen);
     break;
+  case 'u':
+  case 'U':
+    result = http_header_u(data, hd, hdlen);
+    break;
   case 'w':
   case 'W':
     result = http_header_w(data, hd, hdlen);
@@ -4844,6 +4935,24 @@ static void cr_exp100_done(struct Curl_easy *data,
   Curl_expire_done(data, EXPIRE_100_TIMEOUT);
 }
 
+static bool cr_exp100_file_region(struct Curl_easy *data,
+                                  struct Curl_creader *reader,
+                                  struct Curl_crfile *region)
+{
+  struct cr_exp100_ctx *ctx = reader->ctx;
+  /* only pass through once the server has been heard from */
+  if(ctx->state != EXP100_SEND_DATA)
+    return FALSE;
+  return reader->next->crt->file_region(data, reader->next, region);
+}
+
+static CURLcode cr_exp100_file_skip(struct Curl_easy *data,
+                                    struct Curl_creader *reader,
+                                    size_t nbytes)
+{
+  return reader->next->crt->file_skip(data, reader->next, nbytes);
+}
+
 static const struct Curl_crtype cr_exp100 = {
   "cr-exp100",
   Curl_creader_def_init,
@@ -4855,6 +4964,8 @@ static const struct Curl_crtype cr_exp100 = {
   Curl_creader_def_cntrl,
   Curl_creader_def_is_paused,
   cr_exp100_done,
+  cr_exp100_file_region,
+  cr_exp100_file_skip,
   sizeof(struct cr_exp100_ctx)
 };
 
@@ -114,6 +114,7 @@ CURLcode Curl_http_setup_conn(struct Curl_easy *data,
                               struct connectdata *conn);
 CURLcode Curl_http(struct Curl_easy *data, bool *done);
 CURLcode Curl_http_done(struct Curl_easy *data, CURLcode, bool premature);
+CURLcode Curl_http_prewarm(struct Curl_easy *data);
 CURLcode Curl_http_connect(struct Curl_easy *data, bool *done);
 CURLcode Curl_http_do_pollset(struct Curl_easy *data,
                               struct easy_pollset *ps);
@@ -1986,8 +1986,9 @@ out:
   }
   /* Defer flushing during the connect phase so that the SETTINGS and
    * other initial frames are sent together with the first request.
-   * Unless we are 'connect_only' where the request will never come. */
-  if(!cf->connected && !cf->conn->connect_only)
+   * Unless we are 'connect_only' or pre-connecting for the pool, where the
+   * request does not come now. */
+  if(!cf->connected && !cf->conn->connect_only && !data->state.prewarm)
     return CURLE_OK;
   return nw_out_flush(cf, data);
 }
@@ -112,6 +112,28 @@ bool Curl_httpchunk_is_done(struct Curl_easy *data, struct Curl_chunker *ch)
   return ch->state == CHUNK_DONE;
 }
 
+/* Length of the leading run of hex digits in `buf` */
+static size_t chunk_hexlen(const char *buf, size_t blen)
+{
+  size_t n = 0;
+  while((n < blen) && ISXDIGIT(buf[n]))
+    n++;
+  return n;
+}
+
+/* Length of `buf` up to the first CR or LF, or `blen` if there is none.
+ * memchr() is vectorized in every libc we care about, so two passes of it
+ * still beat a byte-by-byte loop on anything but the shortest input. */
+static size_t chunk_linelen(const char *buf, size_t blen)
+{
+  const char *lf = memchr(buf, 0x0a, blen);
+  const char *cr;
+  size_t len = lf ? (size_t)(lf - buf) : blen;
+
+  cr = memchr(buf, 0x0d, len);
+  return cr ? (size_t)(cr - buf) : len;
+}
+
 static CURLcode httpchunk_readwrite(struct Curl_easy *data,
                                     struct Curl_chunker *ch,
                                     struct Curl_cwriter *cw_next,
@@ -146,16 +168,18 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
     switch(ch->state) {
     case CHUNK_HEX:
       if(ISXDIGIT(*buf)) {
-        if(ch->hexindex >= CHUNK_MAXNUM_LEN) {
+        size_t hexlen = chunk_hexlen(buf, blen);
+        if(hexlen > (size_t)(CHUNK_MAXNUM_LEN - ch->hexindex)) {
           failf(data, "chunk hex-length longer than %d", CHUNK_MAXNUM_LEN);
           ch->state = CHUNK_FAILED;
           ch->last_code = CHUNKE_TOO_LONG_HEX; /* longer than we support */
           return CURLE_RECV_ERROR;
         }
-        ch->hexbuffer[ch->hexindex++] = *buf;
-        buf++;
-        blen--;
-        (*pconsumed)++;
+        memcpy(&ch->hexbuffer[ch->hexindex], buf, hexlen);
+        ch->hexindex = (unsigned char)(ch->hexindex + hexlen);
+        buf += hexlen;
+        blen -= hexlen;
+        *pconsumed += hexlen;
       }
       else {
         const char *p;
@@ -181,17 +205,23 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
       break;
 
     case CHUNK_LF:
-      /* waiting for the LF after a chunk size */
-      if(*buf == 0x0a) {
-        /* we are now expecting data to come, unless size was zero! */
-        if(ch->datasize == 0) {
-          ch->state = CHUNK_TRAILER; /* now check for trailers */
-        }
-        else {
-          ch->state = CHUNK_DATA;
-          CURL_TRC_WRITE(data, "http_chunked, chunk start of %"
-                         FMT_OFF_T " bytes", ch->datasize);
-        }
+      /* waiting for the LF after a chunk size, skip any chunk extension */
+      if(*buf != 0x0a) {
+        const char *lf = memchr(buf, 0x0a, blen);
+        size_t skip = lf ? (size_t)(lf - buf) : blen;
+        buf += skip;
+        blen -= skip;
+        *pconsumed += skip;
+        break;
+      }
+      /* we are now expecting data to come, unless size was zero! */
+      if(ch->datasize == 0) {
+        ch->state = CHUNK_TRAILER; /* now check for trailers */
+      }
+      else {
+        ch->state = CHUNK_DATA;
+        CURL_TRC_WRITE(data, "http_chunked, chunk start of %"
+                       FMT_OFF_T " bytes", ch->datasize);
       }
 
       buf++;
@@ -294,12 +324,18 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
         }
       }
       else {
-        result = curlx_dyn_addn(&ch->trailer, buf, 1);
+        /* add the trailer line up to its end at once */
+        size_t len = chunk_linelen(buf, blen);
+        result = curlx_dyn_addn(&ch->trailer, buf, len);
         if(result) {
           ch->state = CHUNK_FAILED;
           ch->last_code = CHUNKE_OUT_OF_MEMORY;
           return result;
         }
+        buf += len;
+        blen -= len;
+        *pconsumed += len;
+        break;
       }
       buf++;
       blen--;
@@ -659,6 +695,8 @@ const struct Curl_crtype Curl_httpchunk_encoder = {
   Curl_creader_def_cntrl,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
   sizeof(struct chunked_reader)
 };
 
@@ -2181,6 +2181,96 @@ static bool cr_mime_is_paused(struct Curl_easy *data,
   return ctx->part && ctx->part->lastreadstatus == CURL_READFUNC_PAUSE;
 }
 
+#ifdef USE_SENDFILE
+/* Get the part whose own content is being read back at the moment, going
+   down through the multiparts. Encoded parts change their content, so none
+   are accepted on the way. */
+static curl_mimepart *mime_content_part(curl_mimepart *part)
+{
+  while(part && !part->encoder &&
+        part->state.state == MIMESTATE_CONTENT) {
+    curl_mime *mime;
+
+    if(part->kind != MIMEKIND_MULTIPART)
+      return part;
+    mime = part->arg;
+    if(!mime || mime->state.state != MIMESTATE_CONTENT)
+      break;
+    part = mime->state.ptr;
+  }
+  return NULL;
+}
+
+/* The bytes ahead when the next content comes from a file part */
+static bool cr_mime_file_region(struct Curl_easy *data,
+                                struct Curl_creader *reader,
+                                struct Curl_crfile *region)
+{
+  struct cr_mime_ctx *ctx = reader->ctx;
+  curl_mimepart *part;
+  (void)data;
+
+  if(ctx->errored || ctx->seen_eos || !Curl_bufq_is_empty(&ctx->tmpbuf))
+    return FALSE;
+  part = mime_content_part(ctx->part);
+  if(!part || part->kind != MIMEKIND_FILE ||
+     (part->datasize < 0) || (part->state.offset >= part->datasize))
+    return FALSE;
+  switch(part->lastreadstatus) {
+  case 0:
+  case CURL_READFUNC_ABORT:
+  case CURL_READFUNC_PAUSE:
+  case READ_ERROR:
+    return FALSE;
+  default:
+    break;
+  }
+  if(mime_open_file(part) || feof(part->fp))
+    return FALSE;
+  region->fd = fileno(part->fp);
+  region->offset = part->state.offset;
+  region->len = part->datasize - part->state.offset;
+  return TRUE;
+}
+
+static CURLcode cr_mime_file_skip(struct Curl_easy *data,
+                                  struct Curl_creader *reader,
+                                  size_t nbytes)
+{
+  struct cr_mime_ctx *ctx = reader->ctx;
+  curl_mimepart *part = ctx->part;
+
+  /* every part on the way to the file counts the content bytes */
+  for(;;) {
+    curl_mime *mime;
+
+    part->state.offset += (curl_off_t)nbytes;
+    if(part->kind != MIMEKIND_MULTIPART)
+      break;
+    mime = part->arg;
+    part = mime->state.ptr;
+  }
+  DEBUGASSERT(part->kind == MIMEKIND_FILE);
+  part->lastreadstatus = nbytes;
+  if(fseeko(part->fp, part->state.offset, SEEK_SET)) {
+    failf(data, "could not seek in mime file part");
+    ctx->errored = TRUE;
+    ctx->error_result = CURLE_READ_ERROR;
+    return CURLE_READ_ERROR;
+  }
+  ctx->read_len += (curl_off_t)nbytes;
+  if(ctx->total_len >= 0)
+    ctx->seen_eos = (ctx->read_len >= ctx->total_len);
+  CURL_TRC_READ(data, "cr_mime_file_skip(%zu, total=%" FMT_OFF_T
+                ", read=%" FMT_OFF_T "), eos=%d", nbytes, ctx->total_len,
+                ctx->read_len, ctx->seen_eos);
+  return CURLE_OK;
+}
+#else
+#define cr_mime_file_region Curl_creader_def_file_region
+#define cr_mime_file_skip   Curl_creader_def_file_skip
+#endif /* USE_SENDFILE */
+
 static const struct Curl_crtype cr_mime = {
   "cr-mime",
   cr_mime_init,
@@ -2192,6 +2282,8 @@ static const struct Curl_crtype cr_mime = {
   cr_mime_cntrl,
   cr_mime_is_paused,
   Curl_creader_def_done,
+  cr_mime_file_region,
+  cr_mime_file_skip,
   sizeof(struct cr_mime_ctx)
 };
 
@@ -54,6 +54,7 @@
 #include "socketpair.h"
 #include "socks.h"
 #include "urlapi-int.h"
+#include "curlx/strparse.h"
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
@@ -781,8 +782,11 @@ CURLMcode curl_multi_remove_handle(CURLM *m, CURL *d)
   removed_timer = Curl_expire_clear(data);
 
   /* If in `msgsent`, it was deducted from `multi->xfers_alive` already. */
-  if(!Curl_uint_bset_contains(&multi->msgsent, data->mid))
+  if(!Curl_uint_bset_contains(&multi->msgsent, data->mid)) {
     --multi->xfers_alive;
+    if(data->state.prewarm)
+      --multi->prewarms_alive;
+  }
 
   Curl_wildcard_dtor(&data->wildcard);
 
@@ -2088,6 +2092,21 @@ static CURLMcode state_do(struct Curl_easy *data,
     multistate(data, MSTATE_DONE);
     rc = CURLM_CALL_MULTI_PERFORM;
   }
+  else if(data->state.prewarm) {
+    /* pre-connect, the connection goes to the pool as idle when done */
+#ifndef CURL_DISABLE_HTTP
+    if(data->conn->handler->protocol & PROTO_FAMILY_HTTP)
+      result = Curl_http_prewarm(data);
+#endif
+    if(result) {
+      multi_posttransfer(data);
+      multi_done(data, result, FALSE);
+      *stream_errorp = TRUE;
+    }
+    else
+      multistate(data, MSTATE_DONE);
+    rc = CURLM_CALL_MULTI_PERFORM;
+  }
   else {
     bool dophase_done = FALSE;
     /* Perform the protocol's DO action */
@@ -2692,7 +2711,14 @@ statemachine_end:
     }
 
     if(MSTATE_COMPLETED == data->mstate) {
-      if(data->master_mid != UINT_MAX) {
+      if(data->state.prewarm) {
+        /* nothing to report, removed at the end of this multi call */
+        if(result)
+          infof(data, "Pre-connect failed: %s", curl_easy_strerror(result));
+        multi->prewarms_done++;
+        multi->prewarms_alive--;
+      }
+      else if(data->master_mid != UINT_MAX) {
         /* A sub transfer, not for msgsent to application */
         struct Curl_easy *mdata;
 
@@ -2737,6 +2763,25 @@ statemachine_end:
 }
 
 
+/* Remove and close the pre-connect transfers that are done */
+static void multi_prewarm_reap(struct Curl_multi *multi)
+{
+  unsigned int mid;
+
+  if(!multi->prewarms_done || !Curl_uint_bset_first(&multi->msgsent, &mid))
+    return;
+  do {
+    struct Curl_easy *data = Curl_multi_get_easy(multi, mid);
+    if(data && data->state.prewarm) {
+      multi->prewarms_done--;
+      (void)curl_multi_remove_handle(multi, data);
+      Curl_close(&data);
+    }
+  }
+  while(multi->prewarms_done &&
+        Curl_uint_bset_next(&multi->msgsent, mid, &mid));
+}
+
 CURLMcode curl_multi_perform(CURLM *m, int *running_handles)
 {
   CURLMcode returncode = CURLM_OK;
@@ -2778,6 +2823,7 @@ CURLMcode curl_multi_perform(CURLM *m, int *running_handles)
 
   sigpipe_apply(multi->admin, &pipe_st);
   Curl_cshutdn_perform(&multi->cshutdn, multi->admin, CURL_SOCKET_TIMEOUT);
+  Curl_cpool_upkeep_timer(multi->admin);
   sigpipe_restore(&pipe_st);
 
   if(multi_ischanged(m, TRUE))
@@ -2810,8 +2856,12 @@ CURLMcode curl_multi_perform(CURLM *m, int *running_handles)
     }
   } while(t);
 
+  multi_prewarm_reap(multi);
+
   if(running_handles) {
-    unsigned int running = Curl_multi_xfers_running(multi);
+    /* internal pre-connect transfers are not the application's */
+    unsigned int running = Curl_multi_xfers_running(multi) -
+      multi->prewarms_alive;
     *running_handles = (running < INT_MAX) ? (int)running : INT_MAX;
   }
 
@@ -3164,14 +3214,19 @@ out:
   if(mrc.run_cpool) {
     sigpipe_apply(multi->admin, &mrc.pipe_st);
     Curl_cshutdn_perform(&multi->cshutdn, multi->admin, s);
+    Curl_cpool_upkeep_timer(multi->admin);
   }
   sigpipe_restore(&mrc.pipe_st);
 
   if(multi_ischanged(multi, TRUE))
     process_pending_handles(multi);
 
+  multi_prewarm_reap(multi);
+
   if(running_handles) {
-    unsigned int running = Curl_multi_xfers_running(multi);
+    /* internal pre-connect transfers are not the application's */
+    unsigned int running = Curl_multi_xfers_running(multi) -
+      multi->prewarms_alive;
     *running_handles = (running < INT_MAX) ? (int)running : INT_MAX;
   }
 
@@ -3259,6 +3314,14 @@ CURLMcode curl_multi_setopt(CURLM *m,
     }
     break;
   }
+  case CURLMOPT_UPKEEP_INTERVAL: {
+    long ms = va_arg(param, long);
+    if(ms < 0)
+      res = CURLM_BAD_FUNCTION_ARGUMENT;
+    else
+      Curl_cpool_upkeep_auto(multi->admin, ms);
+    break;
+  }
   default:
     res = CURLM_UNKNOWN_OPTION;
     break;
@@ -3751,6 +3814,129 @@ CURL **curl_multi_get_handles(CURLM *m)
   return a;
 }
 
+CURLMcode curl_multi_preconnect(CURLM *m, CURL *d,
+                                struct curl_slist *urls,
+                                unsigned int count)
+{
+  struct Curl_multi *multi = m;
+  struct Curl_easy *template = d;
+  struct curl_slist *item;
+
+  if(!GOOD_MULTI_HANDLE(multi))
+    return CURLM_BAD_HANDLE;
+
+  if(template && !GOOD_EASY_HANDLE(template))
+    return CURLM_BAD_EASY_HANDLE;
+
+  if(multi->in_callback)
+    return CURLM_RECURSIVE_API_CALL;
+
+  for(item = urls; item; item = item->next) {
+    unsigned int i;
+    for(i = 0; i < count; i++) {
+      CURLMcode mresult;
+      struct Curl_easy *data = template ?
+        curl_easy_duphandle(template) : curl_easy_init();
+      if(!data)
+        return CURLM_OUT_OF_MEMORY;
+      if(curl_easy_setopt(data, CURLOPT_URL, item->data)) {
+        Curl_close(&data);
+        return CURLM_OUT_OF_MEMORY;
+      }
+      /* a connection of its own that is not held by the transfer */
+      data->set.reuse_fresh = TRUE;
+      data->set.reuse_forbid = FALSE;
+      data->set.connect_only = FALSE;
+      data->set.connect_only_ws = FALSE;
+      data->set.pipewait = FALSE;
+      data->set.fprereq = NULL; /* no request is made */
+      data->state.internal = TRUE;
+      data->state.prewarm = TRUE;
+
+      mresult = curl_multi_add_handle(multi, data);
+      if(mresult) {
+        Curl_close(&data);
+        return mresult;
+      }
+      multi->prewarms_alive++;
+    }
+  }
+  return CURLM_OK;
+}
+
+/* Get the scheme, host and port of the origin in `url` for matching with
+   connections. */
+static CURLMcode multi_url_origin(const char *url, char **pscheme,
+                                  char **phost, int *pport)
+{
+  CURLU *u = curl_url();
+  char *port = NULL;
+  const char *p;
+  curl_off_t num;
+  CURLMcode mresult = CURLM_BAD_FUNCTION_ARGUMENT;
+
+  if(!u)
+    return CURLM_OUT_OF_MEMORY;
+  if(curl_url_set(u, CURLUPART_URL, url, 0) ||
+     curl_url_get(u, CURLUPART_SCHEME, pscheme, 0) ||
+     curl_url_get(u, CURLUPART_HOST, phost, CURLU_PUNYCODE) ||
+     curl_url_get(u, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT))
+    goto out;
+  p = port;
+  if(curlx_str_number(&p, &num, 0xffff))
+    goto out;
+  *pport = (int)num;
+  if(**phost == '[') {
+    /* connections have IPv6 addresses without the brackets */
+    size_t len = strlen(*phost);
+    memmove(*phost, *phost + 1, len - 2);
+    (*phost)[len - 2] = 0;
+  }
+  mresult = CURLM_OK;
+out:
+  curl_free(port);
+  curl_url_cleanup(u);
+  return mresult;
+}
+
+CURLMcode curl_multi_handoff(CURLM *from, CURLM *to, const char *url,
+                             unsigned int max, unsigned int *moved)
+{
+  struct Curl_multi *src = from;
+  struct Curl_multi *dst = to;
+  char *scheme = NULL;
+  char *host = NULL;
+  int port = 0;
+  unsigned int n = 0;
+  CURLMcode mresult = CURLM_OK;
+
+  if(moved)
+    *moved = 0;
+  if(!GOOD_MULTI_HANDLE(src) || !GOOD_MULTI_HANDLE(dst))
+    return CURLM_BAD_HANDLE;
+
+  if(src->in_callback || dst->in_callback)
+    return CURLM_RECURSIVE_API_CALL;
+
+  if(url) {
+    mresult = multi_url_origin(url, &scheme, &host, &port);
+    if(mresult)
+      goto out;
+  }
+
+  if(Curl_cpool_handoff(src->admin, dst->admin, scheme, host, port, max, &n))
+    mresult = CURLM_OUT_OF_MEMORY;
+  if(n && !mresult)
+    mresult = Curl_update_timer(dst);
+  if(moved)
+    *moved = n;
+
+out:
+  curl_free(scheme);
+  curl_free(host);
+  return mresult;
+}
+
 CURLMcode curl_multi_get_offt(CURLM *m,
                               CURLMinfo_offt info,
                               curl_off_t *pvalue)
@@ -575,6 +575,38 @@ CURLMcode Curl_multi_ev_assign(struct Curl_multi *multi,
   return CURLM_OK;
 }
 
+bool Curl_multi_ev_watch_idle(struct Curl_multi *multi,
+                              struct Curl_easy *data,
+                              struct connectdata *conn,
+                              bool watch)
+{
+  struct easy_pollset ps, *last_ps;
+  CURLMcode mresult = CURLM_OK;
+
+  if(!watch && !conn->bits.idle_watched)
+    return FALSE;
+  conn->bits.idle_watched = FALSE;
+  if(!multi || !multi->socket_cb ||
+     (conn->sock[FIRSTSOCKET] == CURL_SOCKET_BAD))
+    return FALSE;
+
+  Curl_pollset_init(&ps);
+  if(watch &&
+     Curl_pollset_add_in(data, &ps, conn->sock[FIRSTSOCKET])) {
+    Curl_pollset_cleanup(&ps);
+    return FALSE;
+  }
+  last_ps = mev_get_last_pollset(data, conn);
+  if(!last_ps && ps.n)
+    last_ps = mev_add_new_conn_pollset(conn);
+  if(last_ps)
+    mresult = mev_pollset_diff(multi, data, conn, &ps, last_ps);
+  Curl_pollset_cleanup(&ps);
+
+  conn->bits.idle_watched = (watch && last_ps && !mresult);
+  return conn->bits.idle_watched;
+}
+
 void Curl_multi_ev_dirty_xfers(struct Curl_multi *multi,
                                curl_socket_t s,
                                bool *run_cpool)
@@ -607,8 +639,17 @@ void Curl_multi_ev_dirty_xfers(struct Curl_multi *multi,
       while(Curl_uint_spbset_next(&entry->xfers, mid, &mid));
     }
 
-    if(entry->conn)
+    if(entry->conn) {
+      struct connectdata *conn = entry->conn;
       *run_cpool = TRUE;
+      if(conn->bits.idle_watched) {
+        /* the idle connection needs a liveness check before reuse. Stop
+         * watching it, we know all there is to know. */
+        CURL_TRC_M(multi->admin, "idle connection #%" FMT_OFF_T " signalled",
+                   conn->connection_id);
+        (void)Curl_multi_ev_watch_idle(multi, multi->admin, conn, FALSE);
+      }
+    }
   }
 }
 
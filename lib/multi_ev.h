@@ -61,6 +61,14 @@ CURLMcode Curl_multi_ev_assess_conn(struct Curl_multi *multi,
                                     struct Curl_easy *data,
                                     struct connectdata *conn);
 
+/* Have the socket of an idle connection watched for input, or no longer.
+ * While watched and no event is seen, the connection is known to be alive.
+ * Returns TRUE when the socket is watched. */
+bool Curl_multi_ev_watch_idle(struct Curl_multi *multi,
+                              struct Curl_easy *data,
+                              struct connectdata *conn,
+                              bool watch);
+
 /* Mark all transfers tied to the given socket as dirty */
 void Curl_multi_ev_dirty_xfers(struct Curl_multi *multi,
                                curl_socket_t s,
@@ -90,6 +90,8 @@ struct Curl_multi {
   unsigned int xfers_alive; /* amount of added transfers that have
                                not yet reached COMPLETE state */
   curl_off_t xfers_total_ever; /* total of added transfers, ever. */
+  unsigned int prewarms_alive; /* pre-connect transfers in xfers_alive */
+  unsigned int prewarms_done; /* completed pre-connect transfers to remove */
   struct uint_tbl xfers; /* transfers added to this multi */
   /* Each transfer's mid may be present in at most one of these */
   struct uint_bset process; /* transfer being processed */
@@ -58,6 +58,7 @@ CURLcode Curl_req_soft_reset(struct SingleRequest *req,
   req->eos_written = FALSE;
   req->eos_read = FALSE;
   req->eos_sent = FALSE;
+  req->no_sendfile = FALSE;
   req->ignorebody = FALSE;
   req->shutdown = FALSE;
   req->bytecount = 0;
@@ -144,6 +145,9 @@ void Curl_req_hard_reset(struct SingleRequest *req, struct Curl_easy *data)
   req->timeofdoc = 0;
   req->location = NULL;
   req->newurl = NULL;
+#ifdef USE_COMPRESSION_DICT
+  req->cdict = NULL;
+#endif
 #ifndef CURL_DISABLE_COOKIES
   req->setcookies = 0;
 #endif
@@ -161,6 +165,7 @@ void Curl_req_hard_reset(struct SingleRequest *req, struct Curl_easy *data)
   req->chunk = FALSE;
   req->ignore_cl = FALSE;
   req->upload_chunky = FALSE;
+  req->upload_encoded = FALSE;
   req->no_body = data->set.opt_no_body;
   req->authneg = FALSE;
   req->shutdown = FALSE;
@@ -431,12 +436,66 @@ bool Curl_req_done_sending(struct Curl_easy *data)
   return data->req.upload_done && !Curl_req_want_send(data);
 }
 
+/* Send request body bytes that come unchanged from a file directly from
+ * there, without reading them into the send buffer. Sets `*pblocked` when
+ * the connection did not take all of them. */
+static CURLcode req_send_file(struct Curl_easy *data, bool *pblocked)
+{
+  struct Curl_crfile region;
+  size_t len, nwritten;
+  CURLcode result;
+
+  *pblocked = FALSE;
+  /* Verbose output shows the body bytes sent, which we do not have */
+  if(data->req.no_sendfile || data->set.verbose ||
+     !Curl_bufq_is_empty(&data->req.sendbuf) ||
+     Curl_xfer_needs_flush(data) ||
+     !Curl_creader_file_region(data, &region))
+    return CURLE_OK;
+
+  len = (region.len > (curl_off_t)SSIZE_MAX) ?
+    (size_t)SSIZE_MAX : (size_t)region.len;
+  if(data->set.max_send_speed && (data->set.max_send_speed < region.len))
+    len = (size_t)data->set.max_send_speed;
+
+  result = Curl_conn_sendfile(data, data->conn->send_idx, region.fd,
+                              region.offset, len, &nwritten);
+  if(result == CURLE_NOT_BUILT_IN) {
+    /* read the body for the rest of this request */
+    data->req.no_sendfile = TRUE;
+    return CURLE_OK;
+  }
+  if(result)
+    return result;
+
+  if(nwritten) {
+    result = Curl_creader_file_skip(data, nwritten);
+    if(result)
+      return result;
+    data->info.request_size += nwritten;
+    data->req.writebytecount += nwritten;
+    Curl_pgrsSetUploadCounter(data, data->req.writebytecount);
+  }
+  *pblocked = (nwritten < (size_t)region.len);
+  return CURLE_OK;
+}
+
 CURLcode Curl_req_send_more(struct Curl_easy *data)
 {
   CURLcode result;
+  bool blocked = FALSE;
 
-  /* Fill our send buffer if more from client can be read. */
   if(!data->req.upload_aborted &&
+     !data->req.eos_read &&
+     !Curl_xfer_send_is_paused(data)) {
+    result = req_send_file(data, &blocked);
+    if(result)
+      return result;
+  }
+
+  /* Fill our send buffer if more from client can be read. */
+  if(!blocked &&
+     !data->req.upload_aborted &&
      !data->req.eos_read &&
      !Curl_xfer_send_is_paused(data) &&
      !Curl_bufq_is_full(&data->req.sendbuf)) {
@@ -32,6 +32,9 @@
 
 /* forward declarations */
 struct UserDefined;
+#ifdef USE_COMPRESSION_DICT
+struct cdict;
+#endif
 
 enum expect100 {
   EXP100_SEND_DATA,           /* enough waiting, just send the body now */
@@ -93,6 +96,9 @@ struct SingleRequest {
   struct Curl_creader *reader_stack;
   struct bufq sendbuf; /* data which needs to be send to the server */
   size_t sendbuf_hds_len; /* amount of header bytes in sendbuf */
+#ifdef USE_COMPRESSION_DICT
+  const struct cdict *cdict; /* compression dictionary offered */
+#endif
   time_t timeofdoc;
   char *location;   /* This points to an allocated version of the Location:
                        header data */
@@ -123,6 +129,8 @@ struct SingleRequest {
   BIT(ignore_cl);     /* ignore content-length */
   BIT(upload_chunky); /* set TRUE if we are doing chunked transfer-encoding
                          on upload */
+  BIT(upload_encoded); /* set TRUE if the request body is compressed with
+                          CURLOPT_UPLOAD_ENCODING */
   BIT(no_body);      /* the response has no body */
   BIT(authneg);      /* TRUE when the auth phase has started, which means
                         that we are creating a request with an auth header,
@@ -131,6 +139,7 @@ struct SingleRequest {
   BIT(sendbuf_init); /* sendbuf is initialized */
   BIT(shutdown);     /* request end will shutdown connection */
   BIT(shutdown_err_ignore); /* errors in shutdown will not fail request */
+  BIT(no_sendfile);  /* do not send request body bytes directly from files */
 };
 
 /**
@@ -633,6 +633,26 @@ void Curl_creader_def_done(struct Curl_easy *data,
   (void)premature;
 }
 
+bool Curl_creader_def_file_region(struct Curl_easy *data,
+                                  struct Curl_creader *reader,
+                                  struct Curl_crfile *region)
+{
+  (void)data;
+  (void)reader;
+  (void)region;
+  return FALSE;
+}
+
+CURLcode Curl_creader_def_file_skip(struct Curl_easy *data,
+                                    struct Curl_creader *reader,
+                                    size_t nbytes)
+{
+  (void)data;
+  (void)reader;
+  (void)nbytes;
+  return CURLE_READ_ERROR;
+}
+
 struct cr_in_ctx {
   struct Curl_creader super;
   curl_read_callback read_cb;
@@ -644,6 +664,8 @@ struct cr_in_ctx {
   BIT(errored);
   BIT(has_used_cb);
   BIT(is_paused);
+  BIT(file_checked); /* did check if reading from a regular file */
+  BIT(file_regular); /* reading via fread() from a regular file */
 };
 
 static CURLcode cr_in_init(struct Curl_easy *data, struct Curl_creader *reader)
@@ -923,6 +945,64 @@ static bool cr_in_is_paused(struct Curl_easy *data,
   return ctx->is_paused;
 }
 
+#ifdef USE_SENDFILE
+/* The bytes ahead when the default fread() reads from a regular file */
+static bool cr_in_file_region(struct Curl_easy *data,
+                              struct Curl_creader *reader,
+                              struct Curl_crfile *region)
+{
+  struct cr_in_ctx *ctx = reader->ctx;
+  FILE *fp = ctx->cb_user_data;
+  curl_off_t pos;
+  (void)data;
+
+  if(!ctx->file_checked) {
+    ctx->file_checked = TRUE;
+    if(ctx->read_cb == (curl_read_callback)fread && fp) {
+      struct_stat st;
+      ctx->file_regular = !fstat(fileno(fp), &st) && S_ISREG(st.st_mode);
+    }
+  }
+  if(!ctx->file_regular || ctx->errored || ctx->seen_eos ||
+     (ctx->total_len < 0) || (ctx->read_len >= ctx->total_len))
+    return FALSE;
+
+  pos = ftello(fp);
+  if(pos < 0)
+    return FALSE;
+  region->fd = fileno(fp);
+  region->offset = pos;
+  region->len = ctx->total_len - ctx->read_len;
+  return TRUE;
+}
+
+static CURLcode cr_in_file_skip(struct Curl_easy *data,
+                                struct Curl_creader *reader,
+                                size_t nbytes)
+{
+  struct cr_in_ctx *ctx = reader->ctx;
+  FILE *fp = ctx->cb_user_data;
+  curl_off_t pos = ftello(fp);
+
+  if((pos < 0) || fseeko(fp, pos + (curl_off_t)nbytes, SEEK_SET)) {
+    failf(data, "could not seek in upload file");
+    ctx->errored = TRUE;
+    ctx->error_result = CURLE_READ_ERROR;
+    return CURLE_READ_ERROR;
+  }
+  ctx->has_used_cb = TRUE;
+  ctx->read_len += nbytes;
+  ctx->seen_eos = (ctx->read_len >= ctx->total_len);
+  CURL_TRC_READ(data, "cr_in_file_skip(%zu, total=%" FMT_OFF_T
+                ", read=%" FMT_OFF_T "), eos=%d", nbytes, ctx->total_len,
+                ctx->read_len, ctx->seen_eos);
+  return CURLE_OK;
+}
+#else
+#define cr_in_file_region Curl_creader_def_file_region
+#define cr_in_file_skip   Curl_creader_def_file_skip
+#endif /* USE_SENDFILE */
+
 static const struct Curl_crtype cr_in = {
   "cr-in",
   cr_in_init,
@@ -934,6 +1014,8 @@ static const struct Curl_crtype cr_in = {
   cr_in_cntrl,
   cr_in_is_paused,
   Curl_creader_def_done,
+  cr_in_file_region,
+  cr_in_file_skip,
   sizeof(struct cr_in_ctx)
 };
 
@@ -1094,6 +1176,8 @@ static const struct Curl_crtype cr_lc = {
   Curl_creader_def_cntrl,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
   sizeof(struct cr_lc_ctx)
 };
 
@@ -1267,6 +1351,8 @@ static const struct Curl_crtype cr_null = {
   Curl_creader_def_cntrl,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
   sizeof(struct Curl_creader)
 };
 
@@ -1382,6 +1468,8 @@ static const struct Curl_crtype cr_buf = {
   cr_buf_cntrl,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
   sizeof(struct cr_buf_ctx)
 };
 
@@ -1464,6 +1552,22 @@ void Curl_creader_done(struct Curl_easy *data, int premature)
   }
 }
 
+bool Curl_creader_file_region(struct Curl_easy *data,
+                              struct Curl_crfile *region)
+{
+  struct Curl_creader *r = data->req.reader_stack;
+  if(!r || !r->crt->file_region(data, r, region))
+    return FALSE;
+  DEBUGASSERT(region->len > 0);
+  return TRUE;
+}
+
+CURLcode Curl_creader_file_skip(struct Curl_easy *data, size_t nbytes)
+{
+  struct Curl_creader *r = data->req.reader_stack;
+  return r ? r->crt->file_skip(data, r, nbytes) : CURLE_READ_ERROR;
+}
+
 struct Curl_creader *Curl_creader_get_by_type(struct Curl_easy *data,
                                               const struct Curl_crtype *crt)
 {
@@ -209,6 +209,14 @@ typedef enum {
   CURL_CRCNTRL_CLEAR_EOS
 } Curl_creader_cntrl;
 
+/* A region of a regular file that a reader delivers next, unchanged.
+ * Such bytes may be sent directly from the file instead of being read. */
+struct Curl_crfile {
+  int fd;             /* file descriptor to read the bytes from */
+  curl_off_t offset;  /* file offset of the first byte */
+  curl_off_t len;     /* number of bytes in the region, > 0 */
+};
+
 /* Client Reader Type, provides the implementation */
 struct Curl_crtype {
   const char *name;        /* writer name. */
@@ -226,6 +234,10 @@ struct Curl_crtype {
   bool (*is_paused)(struct Curl_easy *data, struct Curl_creader *reader);
   void (*done)(struct Curl_easy *data,
                struct Curl_creader *reader, int premature);
+  bool (*file_region)(struct Curl_easy *data, struct Curl_creader *reader,
+                      struct Curl_crfile *region);
+  CURLcode (*file_skip)(struct Curl_easy *data, struct Curl_creader *reader,
+                        size_t nbytes);
   size_t creader_size;  /* sizeof() allocated struct Curl_creader */
 };
 
@@ -277,6 +289,12 @@ bool Curl_creader_def_is_paused(struct Curl_easy *data,
                                 struct Curl_creader *reader);
 void Curl_creader_def_done(struct Curl_easy *data,
                            struct Curl_creader *reader, int premature);
+bool Curl_creader_def_file_region(struct Curl_easy *data,
+                                  struct Curl_creader *reader,
+                                  struct Curl_crfile *region);
+CURLcode Curl_creader_def_file_skip(struct Curl_easy *data,
+                                    struct Curl_creader *reader,
+                                    size_t nbytes);
 
 /**
  * Convenience method for calling `reader->do_read()` that
@@ -396,6 +414,22 @@ bool Curl_creader_is_paused(struct Curl_easy *data);
  */
 void Curl_creader_done(struct Curl_easy *data, int premature);
 
+/**
+ * Get the region of a regular file that the installed readers deliver
+ * next. This works only when all readers pass the client bytes through
+ * unchanged and the client reader is backed by a file.
+ * @return TRUE iff `region` has been filled in
+ */
+bool Curl_creader_file_region(struct Curl_easy *data,
+                              struct Curl_crfile *region);
+
+/**
+ * Tell the installed readers that the first `nbytes` of the region from
+ * `Curl_creader_file_region()` have been sent by other means and are not
+ * to be read again.
+ */
+CURLcode Curl_creader_file_skip(struct Curl_easy *data, size_t nbytes);
+
 /**
  * Look up an installed client reader on `data` by its type.
  * @return first reader with that type or NULL
@@ -50,6 +50,7 @@
 #include "setopt.h"
 #include "multiif.h"
 #include "altsvc.h"
+#include "cdict.h"
 #include "hsts.h"
 #include "tftp.h"
 #include "strdup.h"
@@ -539,6 +540,13 @@ static CURLcode setopt_bool(struct Curl_easy *data, CURLoption option,
      */
     s->cookiesession = enabled;
     break;
+  case CURLOPT_COOKIEJOURNAL:
+    /*
+     * Append cookie changes to a journal as they happen and only rewrite
+     * the cookie jar when the journal has grown large.
+     */
+    s->cookiejournal = enabled;
+    break;
 #endif
   case CURLOPT_AUTOREFERER:
     /*
@@ -572,6 +580,18 @@ static CURLcode setopt_bool(struct Curl_easy *data, CURLoption option,
     s->http_ce_skip = !enabled; /* reversed */
     break;
 
+  case CURLOPT_COMPRESSION_DICT_LEARN:
+    /*
+     * store response bodies announced as compression dictionaries
+     */
+#ifdef USE_COMPRESSION_DICT
+    if(Curl_dict_encodings()) {
+      s->cdict_learn = enabled;
+      break;
+    }
+#endif
+    return CURLE_NOT_BUILT_IN;
+
   case CURLOPT_HTTPGET:
     /*
      * Set to force us do HTTP GET
@@ -1275,6 +1295,9 @@ static CURLcode setopt_long(struct Curl_easy *data, CURLoption option,
   case CURLOPT_WS_OPTIONS:
     s->ws_raw_mode = (bool)(arg & CURLWS_RAW_MODE);
     s->ws_no_auto_pong = (bool)(arg & CURLWS_NOAUTOPONG);
+    s->ws_deflate = (bool)(arg & (CURLWS_DEFLATE |
+                                  CURLWS_DEFLATE_NOTAKEOVER));
+    s->ws_deflate_notakeover = (bool)(arg & CURLWS_DEFLATE_NOTAKEOVER);
     break;
 #endif
   case CURLOPT_DNS_USE_GLOBAL_CACHE:
@@ -1739,6 +1762,14 @@ static CURLcode setopt_cptr(struct Curl_easy *data, CURLoption option,
     }
     return Curl_setstropt(&s->str[STRING_ENCODING], ptr);
 
+  case CURLOPT_UPLOAD_ENCODING:
+    /*
+     * Content-Encoding to compress the request body with.
+     */
+    if(ptr && !Curl_upload_encoding_supported(ptr))
+      return CURLE_NOT_BUILT_IN;
+    return Curl_setstropt(&s->str[STRING_UPLOAD_ENCODING], ptr);
+
 #ifndef CURL_DISABLE_AWS
   case CURLOPT_AWS_SIGV4:
     /*
@@ -2902,6 +2933,18 @@ static CURLcode setopt_blob(struct Curl_easy *data, CURLoption option,
      * Blob that holds Issuer certificate to check certificates issuer
      */
     return Curl_setblobopt(&s->blobs[BLOB_SSL_ISSUERCERT], blob);
+  case CURLOPT_COMPRESSION_DICT_BLOB:
+    /*
+     * Blob that holds a compression dictionary to offer.
+     */
+#ifdef USE_COMPRESSION_DICT
+    if(Curl_dict_encodings()) {
+      if(data->cdicts)
+        Curl_cdict_app_reset(data->cdicts);
+      return Curl_setblobopt(&s->blobs[BLOB_COMPRESSION_DICT], blob);
+    }
+#endif
+    return CURLE_NOT_BUILT_IN;
 
   default:
     return CURLE_UNKNOWN_OPTION;
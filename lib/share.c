@@ -33,20 +33,59 @@
 #include "vtls/vtls_scache.h"
 #include "hsts.h"
 #include "url.h"
+#include "curl_threads.h"
 
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
 #include "memdebug.h"
 
+#ifdef USE_SHARE_LOCKS
+/* The built-in locks. Each kind of data has a reader-writer lock and the
+   DNS cache a mutex per part. */
+struct share_locks {
+  curl_rwlock_t data[CURL_LOCK_DATA_LAST];
+  curl_mutex_t dns[CURL_SHARE_DNS_SHARDS];
+};
+
+static struct share_locks *share_locks_create(void)
+{
+  struct share_locks *locks = malloc(sizeof(struct share_locks));
+  if(locks) {
+    size_t i;
+    for(i = 0; i < CURL_LOCK_DATA_LAST; i++)
+      Curl_rwlock_init(&locks->data[i]);
+    for(i = 0; i < CURL_SHARE_DNS_SHARDS; i++)
+      Curl_mutex_init(&locks->dns[i]);
+  }
+  return locks;
+}
+
+static void share_locks_destroy(struct share_locks **locksp)
+{
+  struct share_locks *locks = *locksp;
+  if(locks) {
+    size_t i;
+    for(i = 0; i < CURL_LOCK_DATA_LAST; i++)
+      Curl_rwlock_destroy(&locks->data[i]);
+    for(i = 0; i < CURL_SHARE_DNS_SHARDS; i++)
+      Curl_mutex_destroy(&locks->dns[i]);
+    free(locks);
+    *locksp = NULL;
+  }
+}
+#endif
+
 CURLSH *
 curl_share_init(void)
 {
   struct Curl_share *share = calloc(1, sizeof(struct Curl_share));
   if(share) {
+    size_t i;
     share->magic = CURL_GOOD_SHARE;
     share->specifier |= (1 << CURL_LOCK_DATA_SHARE);
-    Curl_dnscache_init(&share->dnscache, 23);
+    for(i = 0; i < CURL_SHARE_DNS_SHARDS; i++)
+      Curl_dnscache_init(&share->dnscache[i], 7);
     share->admin = curl_easy_init();
     if(!share->admin) {
       free(share);
@@ -219,6 +258,22 @@ curl_share_setopt(CURLSH *sh, CURLSHoption option, ...)
     share->clientdata = ptr;
     break;
 
+  case CURLSHOPT_BUILTIN_LOCKS:
+#ifdef USE_SHARE_LOCKS
+    if(va_arg(param, long)) {
+      if(!share->locks) {
+        share->locks = share_locks_create();
+        if(!share->locks)
+          res = CURLSHE_NOMEM;
+      }
+    }
+    else
+      share_locks_destroy(&share->locks);
+#else
+    res = CURLSHE_NOT_BUILT_IN;
+#endif
+    break;
+
   default:
     res = CURLSHE_BAD_OPTION;
     break;
@@ -233,9 +288,20 @@ CURLSHcode
 curl_share_cleanup(CURLSH *sh)
 {
   struct Curl_share *share = sh;
+  size_t i;
   if(!GOOD_SHARE_HANDLE(share))
     return CURLSHE_INVALID;
 
+#ifdef USE_SHARE_LOCKS
+  if(share->locks) {
+    Curl_rwlock_wrlock(&share->locks->data[CURL_LOCK_DATA_SHARE]);
+    if(share->dirty) {
+      Curl_rwlock_wrunlock(&share->locks->data[CURL_LOCK_DATA_SHARE]);
+      return CURLSHE_IN_USE;
+    }
+  }
+  else
+#endif
   if(share->lockfunc)
     share->lockfunc(NULL, CURL_LOCK_DATA_SHARE, CURL_LOCK_ACCESS_SINGLE,
                     share->clientdata);
@@ -250,7 +316,8 @@ curl_share_cleanup(CURLSH *sh)
     Curl_cpool_destroy(&share->cpool);
   }
 
-  Curl_dnscache_destroy(&share->dnscache);
+  for(i = 0; i < CURL_SHARE_DNS_SHARDS; i++)
+    Curl_dnscache_destroy(&share->dnscache[i]);
 
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_COOKIES)
   Curl_cookie_cleanup(share->cookies);
@@ -270,6 +337,13 @@ curl_share_cleanup(CURLSH *sh)
   Curl_psl_destroy(&share->psl);
   Curl_close(&share->admin);
 
+#ifdef USE_SHARE_LOCKS
+  if(share->locks) {
+    Curl_rwlock_wrunlock(&share->locks->data[CURL_LOCK_DATA_SHARE]);
+    share_locks_destroy(&share->locks);
+  }
+  else
+#endif
   if(share->unlockfunc)
     share->unlockfunc(NULL, CURL_LOCK_DATA_SHARE, share->clientdata);
   share->magic = 0;
@@ -289,6 +363,18 @@ Curl_share_lock(struct Curl_easy *data, curl_lock_data type,
     return CURLSHE_INVALID;
 
   if(share->specifier & (unsigned int)(1 << type)) {
+#ifdef USE_SHARE_LOCKS
+    if(share->locks) {
+      /* readers only share the lock with other readers */
+      if(accesstype == CURL_LOCK_ACCESS_SHARED) {
+        Curl_rwlock_rdlock(&share->locks->data[type]);
+        data->state.share_rdlocks |= (1U << type);
+      }
+      else
+        Curl_rwlock_wrlock(&share->locks->data[type]);
+    }
+    else
+#endif
     if(share->lockfunc) /* only call this if set! */
       share->lockfunc(data, type, accesstype, share->clientdata);
   }
@@ -306,9 +392,50 @@ Curl_share_unlock(struct Curl_easy *data, curl_lock_data type)
     return CURLSHE_INVALID;
 
   if(share->specifier & (unsigned int)(1 << type)) {
+#ifdef USE_SHARE_LOCKS
+    if(share->locks) {
+      if(data->state.share_rdlocks & (1U << type)) {
+        data->state.share_rdlocks &= ~(1U << type);
+        Curl_rwlock_rdunlock(&share->locks->data[type]);
+      }
+      else
+        Curl_rwlock_wrunlock(&share->locks->data[type]);
+    }
+    else
+#endif
     if(share->unlockfunc) /* only call this if set! */
       share->unlockfunc (data, type, share->clientdata);
   }
 
   return CURLSHE_OK;
 }
+
+/*
+ * With the built-in locks, each part of the DNS cache has a lock of its own.
+ * The lock callbacks have no notion of the parts, they lock the whole cache.
+ */
+void Curl_share_lock_dns(struct Curl_easy *data, size_t shard)
+{
+  DEBUGASSERT(shard < CURL_SHARE_DNS_SHARDS);
+#ifdef USE_SHARE_LOCKS
+  if(data->share->locks) {
+    Curl_mutex_acquire(&data->share->locks->dns[shard]);
+    return;
+  }
+#endif
+  (void)shard;
+  Curl_share_lock(data, CURL_LOCK_DATA_DNS, CURL_LOCK_ACCESS_SINGLE);
+}
+
+void Curl_share_unlock_dns(struct Curl_easy *data, size_t shard)
+{
+  DEBUGASSERT(shard < CURL_SHARE_DNS_SHARDS);
+#ifdef USE_SHARE_LOCKS
+  if(data->share->locks) {
+    Curl_mutex_release(&data->share->locks->dns[shard]);
+    return;
+  }
+#endif
+  (void)shard;
+  Curl_share_unlock(data, CURL_LOCK_DATA_DNS);
+}
@@ -33,6 +33,14 @@
 
 struct Curl_easy;
 struct Curl_ssl_scache;
+struct share_locks;
+
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+#define USE_SHARE_LOCKS /* CURLSHOPT_BUILTIN_LOCKS is supported */
+#endif
+
+/* The shared DNS cache is striped, each part has its own lock */
+#define CURL_SHARE_DNS_SHARDS 16
 
 #define CURL_GOOD_SHARE 0x7e117a1e
 #define GOOD_SHARE_HANDLE(x) ((x) && (x)->magic == CURL_GOOD_SHARE)
@@ -49,9 +57,11 @@ struct Curl_share {
   curl_lock_function lockfunc;
   curl_unlock_function unlockfunc;
   void *clientdata;
+  struct share_locks *locks; /* CURLSHOPT_BUILTIN_LOCKS */
   struct Curl_easy *admin;
   struct cpool cpool;
-  struct Curl_dnscache dnscache; /* DNS cache */
+  /* DNS cache, the entry id picks the part */
+  struct Curl_dnscache dnscache[CURL_SHARE_DNS_SHARDS];
 #if !defined(CURL_DISABLE_HTTP) && !defined(CURL_DISABLE_COOKIES)
   struct CookieInfo *cookies;
 #endif
@@ -69,6 +79,9 @@ struct Curl_share {
 CURLSHcode Curl_share_lock(struct Curl_easy *, curl_lock_data,
                            curl_lock_access);
 CURLSHcode Curl_share_unlock(struct Curl_easy *, curl_lock_data);
+/* lock a part of the shared DNS cache */
+void Curl_share_lock_dns(struct Curl_easy *data, size_t shard);
+void Curl_share_unlock_dns(struct Curl_easy *data, size_t shard);
 
 /* convenience macro to check if this handle is using a shared SSL spool */
 #define CURL_SHARE_ssl_scache(data) (data->share &&                      \
@@ -75,6 +75,7 @@
 #include "mime.h"
 #include "vtls/vtls.h"
 #include "hostip.h"
+#include "hash.h"
 #include "transfer.h"
 #include "sendf.h"
 #include "progress.h"
@@ -88,6 +89,7 @@
 #include "http_negotiate.h"
 #include "select.h"
 #include "multiif.h"
+#include "multi_ev.h"
 #include "easyif.h"
 #include "speedcheck.h"
 #include "curlx/warnless.h"
@@ -124,6 +126,7 @@
 #include "strdup.h"
 #include "setopt.h"
 #include "altsvc.h"
+#include "cdict.h"
 #include "curlx/dynbuf.h"
 #include "headers.h"
 #include "curlx/strparse.h"
@@ -293,8 +296,13 @@ CURLcode Curl_close(struct Curl_easy **datap)
   Curl_altsvc_save(data, data->asi, data->set.str[STRING_ALTSVC]);
   Curl_altsvc_cleanup(&data->asi);
 #endif
+#ifdef USE_COMPRESSION_DICT
+  Curl_cdict_cleanup(&data->cdicts);
+#endif
 #ifndef CURL_DISABLE_HSTS
+  Curl_share_lock(data, CURL_LOCK_DATA_HSTS, CURL_LOCK_ACCESS_SINGLE);
   Curl_hsts_save(data, data->hsts, data->set.str[STRING_HSTS]);
+  Curl_share_unlock(data, CURL_LOCK_DATA_HSTS);
   if(!data->share || !data->share->hsts)
     Curl_hsts_cleanup(&data->hsts);
   curl_slist_free_all(data->state.hstslist); /* clean up list */
@@ -499,6 +507,8 @@ CURLcode Curl_init_userdefined(struct Curl_easy *data)
 #ifndef CURL_DISABLE_WEBSOCKETS
   set->ws_raw_mode = FALSE;
   set->ws_no_auto_pong = FALSE;
+  set->ws_deflate = FALSE;
+  set->ws_deflate_notakeover = FALSE;
 #endif
 
   return result;
@@ -740,6 +750,12 @@ bool Curl_conn_seems_dead(struct connectdata *conn,
       /* avoid check if already too old */
       dead = TRUE;
     }
+    else if(conn->bits.idle_watched) {
+      /* its socket is watched by the event API and has not signalled
+       * anything since it became idle. The connection is as alive as it
+       * was back then. */
+      dead = FALSE;
+    }
     else if(conn->handler->connection_check) {
       /* The protocol has a special method for checking the state of the
          connection. Use it to check if the connection is dead. */
@@ -793,6 +809,7 @@ CURLcode Curl_conn_upkeep(struct Curl_easy *data,
   if(curlx_timediff(*now, conn->keepalive) <= data->set.upkeep_interval_ms)
     return result;
 
+  CURL_TRC_M(data, "upkeep of connection #%" FMT_OFF_T, conn->connection_id);
   /* briefly attach for action */
   Curl_attach_connection(data, conn);
   if(conn->handler->connection_check) {
@@ -825,6 +842,66 @@ static bool ssh_config_matches(struct connectdata *one,
 }
 #endif
 
+static size_t url_hash_str(size_t h, const char *s, bool nocase)
+{
+  return s ? Curl_hash_mix(h, s, strlen(s) + 1, nocase) : h;
+}
+
+#ifndef CURL_DISABLE_PROXY
+static size_t url_hash_proxy(size_t h, const struct proxy_info *p)
+{
+  h = Curl_hash_mix(h, &p->proxytype, sizeof(p->proxytype), FALSE);
+  h = Curl_hash_mix(h, &p->port, sizeof(p->port), FALSE);
+  return url_hash_str(h, p->host.name, TRUE);
+}
+#endif
+
+/*
+ * Compute the fingerprints of the config in `data` and `conn` that a
+ * connection needs to have exactly the same to get reused. Any difference
+ * in them makes the url_match_*() checks fail, so that a connection with
+ * a different fingerprint can be skipped without looking closer.
+ */
+static void url_match_hash(struct Curl_easy *data, struct connectdata *conn)
+{
+  size_t h = CURL_HASH_SEED;
+  unsigned char flags[6];
+
+  flags[0] = (unsigned char)conn->bits.conn_to_host;
+  flags[1] = (unsigned char)conn->bits.conn_to_port;
+  flags[2] = (unsigned char)conn->bits.httpproxy;
+  flags[3] = (unsigned char)conn->bits.socksproxy;
+  flags[4] = (unsigned char)(conn->bits.httpproxy && conn->bits.tunnel_proxy);
+  flags[5] = 0;
+#ifdef USE_UNIX_SOCKETS
+  if(conn->unix_domain_socket) {
+    flags[5] = (unsigned char)conn->bits.abstract_unix_socket;
+    h = url_hash_str(h, conn->unix_domain_socket, FALSE);
+  }
+#endif
+  h = Curl_hash_mix(h, flags, sizeof(flags), FALSE);
+#ifndef CURL_DISABLE_PROXY
+  if(conn->bits.socksproxy) {
+    h = url_hash_proxy(h, &conn->socks_proxy);
+    h = url_hash_str(h, conn->socks_proxy.user, FALSE);
+    h = url_hash_str(h, conn->socks_proxy.passwd, FALSE);
+  }
+  if(conn->bits.httpproxy) {
+    h = url_hash_proxy(h, &conn->http_proxy);
+    if(IS_HTTPS_PROXY(conn->http_proxy.proxytype)) {
+      size_t ph = Curl_ssl_config_hash(data, TRUE);
+      h = Curl_hash_mix(h, &ph, sizeof(ph), FALSE);
+    }
+  }
+#endif
+#ifdef HAVE_GSSAPI
+  h = Curl_hash_mix(h, &conn->gssapi_delegation,
+                    sizeof(conn->gssapi_delegation), FALSE);
+#endif
+  conn->match_hash = h;
+  conn->ssl_hash = Curl_ssl_config_hash(data, FALSE);
+}
+
 struct url_conn_match {
   struct connectdata *found;
   struct Curl_easy *data;
@@ -1176,7 +1253,8 @@ static bool url_match_ssl_config(struct connectdata *conn,
 {
   /* If talking TLS, conn needs to use the same SSL options. */
   if((m->needle->handler->flags & PROTOPT_SSL) &&
-     !Curl_ssl_conn_config_match(m->data, conn, FALSE)) {
+     ((m->needle->ssl_hash != conn->ssl_hash) ||
+      !Curl_ssl_conn_config_match(m->data, conn, FALSE))) {
     DEBUGF(infof(m->data,
                  "Connection #%" FMT_OFF_T
                  " has different SSL parameters, cannot reuse",
@@ -1259,6 +1337,10 @@ static bool url_match_conn(struct connectdata *conn, void *userdata)
   struct url_conn_match *m = userdata;
   /* Check if `conn` can be used for transfer `m->data` */
 
+  /* a cheap first check that rejects most connections that do not match */
+  if(m->needle->match_hash != conn->match_hash)
+    return FALSE;
+
   /* general connect config setting match? */
   if(!url_match_connect_config(conn, m))
     return FALSE;
@@ -1318,6 +1400,9 @@ static bool url_match_result(bool result, void *userdata)
     /* Attach it now while still under lock, so the connection does
      * no longer appear idle and can be reaped. */
     Curl_attach_connection(match->data, match->found);
+    /* the transfer watches the socket from now on */
+    (void)Curl_multi_ev_watch_idle(match->data->multi, match->data,
+                                   match->found, FALSE);
     return TRUE;
   }
   else if(match->seen_single_use_conn && !match->seen_multiplex_conn) {
@@ -1905,8 +1990,14 @@ static CURLcode parseurlandfillconn(struct Curl_easy *data,
 #ifndef CURL_DISABLE_HSTS
   /* HSTS upgrade */
   if(data->hsts && curl_strequal("http", data->state.up.scheme)) {
+    struct stsentry pre;
+    bool upgrade;
     /* This MUST use the IDN decoded name */
-    if(Curl_hsts(data->hsts, conn->host.name, strlen(conn->host.name), TRUE)) {
+    Curl_share_lock(data, CURL_LOCK_DATA_HSTS, CURL_LOCK_ACCESS_SHARED);
+    upgrade = !!Curl_hsts(data->hsts, conn->host.name,
+                          strlen(conn->host.name), TRUE, &pre);
+    Curl_share_unlock(data, CURL_LOCK_DATA_HSTS);
+    if(upgrade) {
       char *url;
       Curl_safefree(data->state.up.scheme);
       uc = curl_url_set(uh, CURLUPART_SCHEME, "https", 0);
@@ -3646,6 +3737,7 @@ static CURLcode create_conn(struct Curl_easy *data,
   result = Curl_ssl_easy_config_complete(data);
   if(result)
     goto out;
+  url_match_hash(data, conn);
 
   Curl_cpool_prune_dead(data);
 
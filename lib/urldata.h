@@ -427,6 +427,8 @@ struct ConnectBits {
   BIT(shutdown_handler); /* connection shutdown: handler shut down */
   BIT(shutdown_filters); /* connection shutdown: filters shut down */
   BIT(in_cpool);     /* connection is kept in a connection pool */
+  BIT(idle_watched); /* idle in the pool with its socket watched for events
+                        and none seen, so it needs no liveness check */
 };
 
 struct hostname {
@@ -633,6 +635,8 @@ struct proxy_info {
  */
 struct connectdata {
   struct Curl_llist_node cpool_node; /* conncache lists */
+  struct Curl_llist_node idle_node; /* the pool's idle list */
+  struct Curl_llist_node bundle_idle_node; /* the bundle's idle list */
   struct Curl_llist_node cshutdn_node; /* cshutdn list */
 
   curl_closesocket_callback fclosesocket; /* function closing the socket(s) */
@@ -693,6 +697,8 @@ struct connectdata {
 #ifndef CURL_DISABLE_PROXY
   struct ssl_primary_config proxy_ssl_config;
 #endif
+  size_t match_hash; /* fingerprint of the config reuse needs to match */
+  size_t ssl_hash;   /* fingerprint of ssl_config */
   struct ConnectBits bits;    /* various state-flags for this connection */
 
   const struct Curl_handler *handler; /* Connection's protocol handler */
@@ -954,6 +960,7 @@ typedef enum {
   EXPIRE_FTP_ACCEPT,
   EXPIRE_ALPN_EYEBALLS,
   EXPIRE_SHUTDOWN,
+  EXPIRE_UPKEEP,
   EXPIRE_LAST /* not an actual timer, used as a marker only */
 } expire_id;
 
@@ -1017,6 +1024,8 @@ struct UrlState {
   int os_errno;  /* filled in with errno whenever an error occurs */
   long followlocation; /* redirect counter */
   int requests; /* request counter: redirects + authentication retakes */
+  unsigned int share_rdlocks; /* share data types this handle has read
+                                 locked with the built-in locks */
 #ifdef HAVE_SIGNAL
   /* storage for the previous bag^H^H^HSIGPIPE signal handler :-) */
   void (*prev_signal)(int sig);
@@ -1177,6 +1186,7 @@ struct UrlState {
                     internal use and the user does not have ownership of the
                     handle. */
   BIT(http_ignorecustom); /* ignore custom method from now */
+  BIT(prewarm); /* internal transfer that only connects, for the pool */
 #ifndef CURL_DISABLE_HTTP
   BIT(http_hd_te); /* Added HTTP header TE: */
   BIT(http_hd_upgrade); /* Added HTTP header Upgrade: */
@@ -1319,6 +1329,7 @@ enum dupstring {
   STRING_ECH_CONFIG,            /* CURLOPT_ECH_CONFIG */
   STRING_ECH_PUBLIC,            /* CURLOPT_ECH_PUBLIC */
   STRING_SSL_SIGNATURE_ALGORITHMS, /* CURLOPT_SSL_SIGNATURE_ALGORITHMS */
+  STRING_UPLOAD_ENCODING,       /* CURLOPT_UPLOAD_ENCODING */
 
   /* -- end of null-terminated strings -- */
 
@@ -1342,6 +1353,7 @@ enum dupblob {
   BLOB_SSL_ISSUERCERT_PROXY,
   BLOB_CAINFO_PROXY,
 #endif
+  BLOB_COMPRESSION_DICT,
   BLOB_LAST
 };
 
@@ -1563,6 +1575,7 @@ struct UserDefined {
   BIT(sep_headers);     /* handle host and proxy headers separately */
 #ifndef CURL_DISABLE_COOKIES
   BIT(cookiesession);   /* new cookie session? */
+  BIT(cookiejournal);   /* journal cookie changes next to the jar */
 #endif
   BIT(crlf);            /* convert crlf on ftp upload(?) */
 #ifdef USE_SSH
@@ -1616,6 +1629,9 @@ struct UserDefined {
                           transfer-encoded (chunked, compressed) */
   BIT(http_ce_skip);   /* pass the raw body data to the user, even when
                           content-encoded (chunked, compressed) */
+#ifdef USE_COMPRESSION_DICT
+  BIT(cdict_learn);    /* store dictionaries from Use-As-Dictionary: */
+#endif
   BIT(proxy_transfer_mode); /* set transfer mode (;type=<a|i>) when doing
                                FTP via an HTTP proxy */
 #if defined(HAVE_GSSAPI) || defined(USE_WINDOWS_SSPI)
@@ -1649,6 +1665,8 @@ struct UserDefined {
 #ifndef CURL_DISABLE_WEBSOCKETS
   BIT(ws_raw_mode);
   BIT(ws_no_auto_pong);
+  BIT(ws_deflate);           /* offer permessage-deflate */
+  BIT(ws_deflate_notakeover); /* ask for no compression context takeover */
 #endif
 };
 
@@ -1729,6 +1747,9 @@ struct Curl_easy {
 #endif
 #ifndef CURL_DISABLE_ALTSVC
   struct altsvcinfo *asi;      /* the alt-svc cache */
+#endif
+#ifdef USE_COMPRESSION_DICT
+  struct cdictinfo *cdicts;    /* compression dictionaries */
 #endif
   struct Progress progress;    /* for all the progress meter data */
   struct UrlState state;       /* struct for fields used for state info and
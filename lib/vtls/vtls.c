@@ -79,6 +79,7 @@
 #include "../select.h"
 #include "../strdup.h"
 #include "../rand.h"
+#include "../hash.h"
 
 /* The last #include files should be: */
 #include "../curl_memory.h"
@@ -237,6 +238,56 @@ bool Curl_ssl_conn_config_match(struct Curl_easy *data,
                                   &candidate->ssl_config);
 }
 
+static size_t hash_ssl_str(size_t h, const char *s, bool nocase)
+{
+  return s ? Curl_hash_mix(h, s, strlen(s) + 1, nocase) : h;
+}
+
+static size_t hash_ssl_blob(size_t h, const struct curl_blob *blob)
+{
+  if(blob) {
+    h = Curl_hash_mix(h, &blob->len, sizeof(blob->len), FALSE);
+    h = Curl_hash_mix(h, blob->data, blob->len, FALSE);
+  }
+  return h;
+}
+
+size_t Curl_ssl_config_hash(struct Curl_easy *data, bool proxy)
+{
+  struct ssl_primary_config *c = &data->set.ssl.primary;
+  size_t h = CURL_HASH_SEED;
+#ifndef CURL_DISABLE_PROXY
+  if(proxy)
+    c = &data->set.proxy_ssl.primary;
+#else
+  (void)proxy;
+#endif
+
+  /* the verify* bits are left out, they may get updated on the connection
+     by Curl_ssl_conn_config_update() */
+  h = Curl_hash_mix(h, &c->version, sizeof(c->version), FALSE);
+  h = Curl_hash_mix(h, &c->version_max, sizeof(c->version_max), FALSE);
+  h = Curl_hash_mix(h, &c->ssl_options, sizeof(c->ssl_options), FALSE);
+  h = hash_ssl_blob(h, c->cert_blob);
+  h = hash_ssl_blob(h, c->ca_info_blob);
+  h = hash_ssl_blob(h, c->issuercert_blob);
+  h = hash_ssl_str(h, c->CApath, FALSE);
+  h = hash_ssl_str(h, c->CAfile, FALSE);
+  h = hash_ssl_str(h, c->issuercert, FALSE);
+  h = hash_ssl_str(h, c->clientcert, FALSE);
+#ifdef USE_TLS_SRP
+  h = hash_ssl_str(h, c->username, FALSE);
+  h = hash_ssl_str(h, c->password, FALSE);
+#endif
+  h = hash_ssl_str(h, c->cipher_list, TRUE);
+  h = hash_ssl_str(h, c->cipher_list13, TRUE);
+  h = hash_ssl_str(h, c->curves, TRUE);
+  h = hash_ssl_str(h, c->signature_algorithms, TRUE);
+  h = hash_ssl_str(h, c->CRLfile, TRUE);
+  h = hash_ssl_str(h, c->pinned_key, TRUE);
+  return h;
+}
+
 static bool clone_ssl_primary_config(struct ssl_primary_config *source,
                                      struct ssl_primary_config *dest)
 {
@@ -137,6 +137,14 @@ bool Curl_ssl_conn_config_match(struct Curl_easy *data,
                                 struct connectdata *candidate,
                                 bool proxy);
 
+/**
+ * Return a fingerprint of the SSL configuration in `data`. Configurations
+ * that Curl_ssl_conn_config_match() finds the same have the same
+ * fingerprint.
+ * @param proxy   use the proxy SSL config or the main one
+ */
+size_t Curl_ssl_config_hash(struct Curl_easy *data, bool proxy);
+
 /* Update certain connection SSL config flags after they have
  * been changed on the easy handle. Will work for `verifypeer`,
  * `verifyhost` and `verifystatus`. */
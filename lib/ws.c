@@ -41,6 +41,21 @@
 #include "select.h"
 #include "curlx/nonblock.h"
 #include "curlx/strparse.h"
+#include "content_encoding.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define USE_WS_MASK_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#define USE_WS_MASK_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define USE_WS_MASK_NEON
+#include <arm_neon.h>
+#endif
 
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
@@ -76,6 +91,37 @@
 /* buffer dimensioning */
 #define WS_CHUNK_SIZE 65535
 #define WS_CHUNK_COUNT 2
+/* 2 bytes, 8 bytes extended length and a 4 byte mask */
+#define WS_MAX_FRAME_HEAD_LEN 14
+
+#ifdef HAVE_LIBZ
+#define WS_DEFLATE_BUFSIZE 16384
+
+/* permessage-deflate state, RFC 7692 */
+struct ws_deflate {
+  z_stream zin;            /* inflating received messages */
+  z_stream zout;           /* deflating sent messages */
+  struct dynbuf zbuf;      /* deflated message being sent */
+  unsigned char ibuf[WS_DEFLATE_BUFSIZE]; /* inflated, not passed on yet */
+  unsigned char obuf[WS_DEFLATE_BUFSIZE]; /* deflate output */
+  size_t ilen;             /* amount of inflated bytes in `ibuf` */
+  size_t ioff;             /* amount of `ibuf` bytes passed on */
+  size_t in_fed;           /* frame bytes inflated, but not acknowledged */
+  size_t tail_fed;         /* bytes of the message tail inflated */
+  curl_off_t out_offset;   /* inflated bytes of current frame passed on */
+  int client_max_window_bits; /* window size we may use for deflating */
+  BIT(server_no_takeover); /* reset inflate after each message */
+  BIT(client_no_takeover); /* reset deflate after each message */
+  BIT(zin_init);           /* `zin` is initialized */
+  BIT(zout_init);          /* `zout` is initialized */
+  BIT(zin_ended);          /* message had a final deflate block */
+  BIT(in_pending);         /* inflate may have output without more input */
+  BIT(end_passed);         /* the end of the current frame was passed on */
+  BIT(out_msg);            /* in the middle of sending a deflated message */
+};
+
+static const unsigned char ws_deflate_tail[4] = { 0x00, 0x00, 0xff, 0xff };
+#endif
 
 
 /* a client-side WS frame decoder, parsing frame headers and
@@ -95,6 +141,10 @@ struct ws_decoder {
   int head_len, head_total;
   enum ws_dec_state state;
   int cont_flags;
+#ifdef HAVE_LIBZ
+  struct ws_deflate *pmd; /* permessage-deflate, when negotiated */
+  BIT(compressed);        /* current data message is compressed */
+#endif
 };
 
 /* a client-side WS frame encoder, generating frame headers and
@@ -128,6 +178,12 @@ struct websocket {
   struct curl_ws_frame recvframe;  /* the current WS FRAME received */
   struct ws_cntrl_frame pending; /* a control frame pending to be sent */
   size_t sendbuf_payload; /* number of payload bytes in sendbuf */
+  size_t lent_len;        /* payload bytes lent by curl_ws_recv_view() */
+#ifdef HAVE_LIBZ
+  struct ws_deflate *pmd; /* permessage-deflate, when negotiated */
+#endif
+  BIT(sendbuf_deflated); /* sendbuf payload is deflated */
+  BIT(sendbuf_frames);   /* sendbuf only holds complete, accepted frames */
 };
 
 
@@ -325,6 +381,9 @@ static void ws_dec_info(struct ws_decoder *dec, struct Curl_easy *data,
 static CURLcode ws_send_raw_blocking(struct Curl_easy *data,
                                      struct websocket *ws,
                                      const char *buffer, size_t buflen);
+#ifdef HAVE_LIBZ
+static void ws_deflate_free(struct websocket *ws);
+#endif
 
 typedef CURLcode ws_write_payload(const unsigned char *buf, size_t buflen,
                                   int frame_age, int frame_flags,
@@ -353,6 +412,9 @@ static void ws_dec_reset(struct ws_decoder *dec)
   dec->head_len = dec->head_total = 0;
   dec->state = WS_DEC_INIT;
   dec->cont_flags = 0;
+#ifdef HAVE_LIBZ
+  dec->compressed = FALSE;
+#endif
 }
 
 static void ws_dec_init(struct ws_decoder *dec)
@@ -369,10 +431,23 @@ static CURLcode ws_dec_read_head(struct ws_decoder *dec,
 
   while(Curl_bufq_peek(inraw, &inbuf, &inlen)) {
     if(dec->head_len == 0) {
+      unsigned char firstbyte = *inbuf;
+      bool compressed = FALSE;
+
       dec->head[0] = *inbuf;
       Curl_bufq_skip(inraw, 1);
 
-      dec->frame_flags = ws_frame_firstbyte2flags(data, dec->head[0],
+#ifdef HAVE_LIBZ
+      /* With permessage-deflate, RSV1 marks the first frame of a
+       * compressed TEXT or BINARY message. */
+      if(dec->pmd && (firstbyte & WSBIT_RSV1) &&
+         (((firstbyte & WSBIT_OPCODE_MASK) == WSBIT_OPCODE_TEXT) ||
+          ((firstbyte & WSBIT_OPCODE_MASK) == WSBIT_OPCODE_BIN))) {
+        firstbyte &= (unsigned char)~WSBIT_RSV1;
+        compressed = TRUE;
+      }
+#endif
+      dec->frame_flags = ws_frame_firstbyte2flags(data, firstbyte,
                                                   dec->cont_flags);
       if(!dec->frame_flags) {
         ws_dec_reset(dec);
@@ -383,7 +458,13 @@ static CURLcode ws_dec_read_head(struct ws_decoder *dec,
        * control frames (close/ping/pong) do not affect the CONT status */
       if(dec->frame_flags & (CURLWS_TEXT | CURLWS_BINARY)) {
         dec->cont_flags = dec->frame_flags;
+#ifdef HAVE_LIBZ
+        /* continuation frames belong to the message they continue */
+        if(firstbyte & WSBIT_OPCODE_MASK)
+          dec->compressed = compressed;
+#endif
       }
+      (void)compressed;
 
       dec->head_len = 1;
       /* ws_dec_info(dec, data, "seeing opcode"); */
@@ -511,12 +592,175 @@ static CURLcode ws_dec_pass_payload(struct ws_decoder *dec,
   return remain ? CURLE_AGAIN : CURLE_OK;
 }
 
+#ifdef HAVE_LIBZ
+static bool ws_dec_inflating(struct ws_decoder *dec)
+{
+  return dec->pmd && dec->compressed &&
+    (dec->frame_flags & (CURLWS_TEXT | CURLWS_BINARY));
+}
+
+struct ws_inflate_ctx {
+  struct Curl_easy *data;
+  struct ws_decoder *dec;
+  ws_write_payload *write_cb;
+  void *write_ctx;
+};
+
+static void ws_inflate_frame_start(struct ws_deflate *pmd)
+{
+  DEBUGASSERT(pmd->ioff == pmd->ilen);
+  pmd->ilen = pmd->ioff = 0;
+  pmd->in_fed = 0;
+  pmd->tail_fed = 0;
+  pmd->out_offset = 0;
+  pmd->in_pending = FALSE;
+  pmd->end_passed = FALSE;
+}
+
+/* Inflate from `in` into the, empty, `ibuf`. */
+static CURLcode ws_inflate_some(struct Curl_easy *data,
+                                struct ws_deflate *pmd,
+                                const unsigned char *in, size_t inlen,
+                                size_t *pconsumed)
+{
+  z_stream *z = &pmd->zin;
+  int status;
+
+  DEBUGASSERT(pmd->ioff == pmd->ilen);
+  pmd->ilen = pmd->ioff = 0;
+  pmd->in_pending = FALSE;
+  if(pmd->zin_ended) {
+    /* anything after a final deflate block is not for us */
+    *pconsumed = inlen;
+    return CURLE_OK;
+  }
+  if(inlen > UINT_MAX)
+    inlen = UINT_MAX;
+  z->next_in = (z_const Bytef *)in;
+  z->avail_in = (uInt)inlen;
+  z->next_out = (Bytef *)pmd->ibuf;
+  z->avail_out = (uInt)sizeof(pmd->ibuf);
+  status = inflate(z, Z_SYNC_FLUSH);
+  if(status == Z_STREAM_END) {
+    pmd->zin_ended = TRUE;
+    z->avail_in = 0;
+  }
+  else if((status != Z_OK) && (status != Z_BUF_ERROR)) {
+    failf(data, "[WS] inflate error: %s", z->msg ? z->msg : "unknown");
+    return CURLE_RECV_ERROR;
+  }
+  *pconsumed = inlen - z->avail_in;
+  pmd->ilen = sizeof(pmd->ibuf) - z->avail_out;
+  pmd->in_pending = !z->avail_out;
+  return CURLE_OK;
+}
+
+/* A ws_write_payload that inflates the payload of a compressed frame
+ * and passes the result on. Since the inflated size is only known at the
+ * end, the `payload_len` passed on is the inflated amount so far plus
+ * an estimate, that is only 0 once the end of the frame has been reached.
+ * If the receiver does not take everything, the last byte of the frame
+ * is not acknowledged so that the decoder calls again. */
+static CURLcode ws_inflate_pass(const unsigned char *buf, size_t buflen,
+                                int frame_age, int frame_flags,
+                                curl_off_t payload_offset,
+                                curl_off_t payload_len,
+                                void *userp,
+                                size_t *pnwritten)
+{
+  struct ws_inflate_ctx *ctx = userp;
+  struct ws_decoder *dec = ctx->dec;
+  struct ws_deflate *pmd = dec->pmd;
+  bool fin = !!(dec->head[0] & WSBIT_FIN);
+  bool frame_end = ((payload_offset + (curl_off_t)buflen) == payload_len);
+  bool pending;
+  size_t n, acked;
+  CURLcode result;
+
+  *pnwritten = 0;
+  DEBUGASSERT(pmd->in_fed <= buflen);
+  while(1) {
+    if(pmd->ioff < pmd->ilen) {
+      size_t ilen = pmd->ilen - pmd->ioff;
+      curl_off_t more = payload_len - payload_offset - (curl_off_t)pmd->in_fed;
+      if(pmd->in_pending || (fin && (pmd->tail_fed < 4)))
+        more++;
+      result = ctx->write_cb(pmd->ibuf + pmd->ioff, ilen, frame_age,
+                             frame_flags, pmd->out_offset,
+                             pmd->out_offset + (curl_off_t)ilen + more,
+                             ctx->write_ctx, &n);
+      if(result && (result != CURLE_AGAIN))
+        return result;
+      if(result)
+        n = 0;
+      pmd->ioff += n;
+      pmd->out_offset += n;
+      if(pmd->ioff < pmd->ilen)
+        break; /* receiver is full */
+      pmd->end_passed = !more;
+    }
+    else if((pmd->in_fed < buflen) || pmd->in_pending) {
+      result = ws_inflate_some(ctx->data, pmd, buf + pmd->in_fed,
+                               buflen - pmd->in_fed, &n);
+      if(result)
+        return result;
+      if(!n && !pmd->ilen && !pmd->in_pending) {
+        failf(ctx->data, "[WS] inflate makes no progress");
+        return CURLE_RECV_ERROR;
+      }
+      pmd->in_fed += n;
+    }
+    else if(frame_end && fin && (pmd->tail_fed < 4)) {
+      /* the message ends, add the tail removed by the sender */
+      result = ws_inflate_some(ctx->data, pmd,
+                               ws_deflate_tail + pmd->tail_fed,
+                               4 - pmd->tail_fed, &n);
+      if(result)
+        return result;
+      pmd->tail_fed += n;
+      if(!n && !pmd->ilen)
+        pmd->tail_fed = 4; /* nothing more to get out of it */
+    }
+    else
+      break;
+  }
+
+  pending = (pmd->ioff < pmd->ilen) || pmd->in_pending;
+  if(!pending && frame_end && (pmd->in_fed == buflen) &&
+     (!fin || (pmd->tail_fed == 4))) {
+    if(!pmd->end_passed) {
+      /* let the receiver know that the frame is complete */
+      result = ctx->write_cb(pmd->ibuf, 0, frame_age, frame_flags,
+                             pmd->out_offset, pmd->out_offset,
+                             ctx->write_ctx, &n);
+      if(result && (result != CURLE_AGAIN))
+        return result;
+      pmd->end_passed = TRUE;
+    }
+    if(fin && (pmd->server_no_takeover || pmd->zin_ended)) {
+      (void)inflateReset(&pmd->zin);
+      pmd->zin_ended = FALSE;
+    }
+  }
+
+  acked = pmd->in_fed;
+  if(pending && acked)
+    --acked; /* keep input around until all output has been passed on */
+  pmd->in_fed -= acked;
+  *pnwritten = acked;
+  return (!acked && buflen) ? CURLE_AGAIN : CURLE_OK;
+}
+#endif /* HAVE_LIBZ */
+
 static CURLcode ws_dec_pass(struct ws_decoder *dec,
                             struct Curl_easy *data,
                             struct bufq *inraw,
                             ws_write_payload *write_cb,
                             void *write_ctx)
 {
+#ifdef HAVE_LIBZ
+  struct ws_inflate_ctx ictx;
+#endif
   CURLcode result;
 
   if(Curl_bufq_is_empty(inraw))
@@ -540,6 +784,23 @@ static CURLcode ws_dec_pass(struct ws_decoder *dec,
     }
     /* head parsing done */
     dec->state = WS_DEC_PAYLOAD;
+#ifdef HAVE_LIBZ
+    if(ws_dec_inflating(dec))
+      ws_inflate_frame_start(dec->pmd);
+#endif
+    FALLTHROUGH();
+  case WS_DEC_PAYLOAD:
+#ifdef HAVE_LIBZ
+    if(ws_dec_inflating(dec)) {
+      /* pass the payload through inflate on its way to `write_cb` */
+      ictx.data = data;
+      ictx.dec = dec;
+      ictx.write_cb = write_cb;
+      ictx.write_ctx = write_ctx;
+      write_cb = ws_inflate_pass;
+      write_ctx = &ictx;
+    }
+#endif
     if(dec->payload_len == 0) {
       size_t nwritten;
       const unsigned char tmp = '\0';
@@ -551,8 +812,6 @@ static CURLcode ws_dec_pass(struct ws_decoder *dec,
       dec->state = WS_DEC_INIT;
       break;
     }
-    FALLTHROUGH();
-  case WS_DEC_PAYLOAD:
     result = ws_dec_pass_payload(dec, data, inraw, write_cb, write_ctx);
     ws_dec_info(dec, data, "passing");
     if(result)
@@ -804,6 +1063,7 @@ static void ws_enc_init(struct ws_encoder *enc)
 static CURLcode ws_enc_add_frame(struct Curl_easy *data,
                                  struct ws_encoder *enc,
                                  unsigned int flags,
+                                 unsigned char rsv,
                                  curl_off_t payload_len,
                                  struct bufq *out)
 {
@@ -848,7 +1108,7 @@ static CURLcode ws_enc_add_frame(struct Curl_easy *data,
     return CURLE_TOO_LARGE;
   }
 
-  head[0] = enc->firstbyte = firstb;
+  head[0] = enc->firstbyte = (firstb | rsv);
   if(payload_len > 65535) {
     head[1] = 127 | WSBIT_MASK;
     head[2] = (unsigned char)((payload_len >> 56) & 0xff);
@@ -918,7 +1178,111 @@ static CURLcode ws_enc_write_head(struct Curl_easy *data,
     if(result)
       return result;
   }
-  return ws_enc_add_frame(data, enc, flags, payload_len, out);
+#ifdef HAVE_LIBZ
+  if(ws->pmd && ws->pmd->out_msg && enc->contfragment &&
+     !(flags & (CURLWS_CLOSE | CURLWS_PING | CURLWS_PONG))) {
+    failf(data, "[WS] cannot continue a deflated message with a frame "
+          "of fixed size");
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+#endif
+  return ws_enc_add_frame(data, enc, flags, 0, payload_len, out);
+}
+
+/* XOR `len` bytes from `src` with the 4 byte `mask`, starting at mask
+ * index `xori`, and store them in `dst`. `dst` and `src` may be the same.
+ * Returns the mask index for the byte following the last one. */
+UNITTEST unsigned int ws_mask_scalar(unsigned char *dst,
+                                     const unsigned char *src, size_t len,
+                                     const unsigned char *mask,
+                                     unsigned int xori)
+{
+  size_t i;
+  for(i = 0; i < len; ++i) {
+    dst[i] = src[i] ^ mask[xori];
+    xori = (xori + 1) & 3;
+  }
+  return xori;
+}
+
+/* Same as ws_mask_scalar(), but processes as many bytes at once as the
+ * CPU allows. Since the mask repeats every 4 bytes, any block that is a
+ * multiple of 4 can be XORed with the mask pattern rotated to `xori`. */
+UNITTEST unsigned int ws_mask(unsigned char *dst,
+                              const unsigned char *src, size_t len,
+                              const unsigned char *mask,
+                              unsigned int xori)
+{
+  unsigned char pat[32];
+  curl_uint64_t w, m64;
+  unsigned int k;
+  size_t i = 0;
+
+  if(len < 8)
+    return ws_mask_scalar(dst, src, len, mask, xori);
+
+  for(k = 0; k < sizeof(pat); ++k)
+    pat[k] = mask[(xori + k) & 3];
+
+#ifdef USE_WS_MASK_AVX2
+  if(len >= 32) {
+    __m256i m256 = _mm256_loadu_si256((const __m256i *)(void *)pat);
+    for(; (len - i) >= 32; i += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)
+                                     &src[i]);
+      _mm256_storeu_si256((__m256i *)(void *)&dst[i],
+                          _mm256_xor_si256(v, m256));
+    }
+  }
+#endif
+#ifdef USE_WS_MASK_SSE2
+  if((len - i) >= 16) {
+    __m128i m128 = _mm_loadu_si128((const __m128i *)(void *)pat);
+    for(; (len - i) >= 16; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(const void *)&src[i]);
+      _mm_storeu_si128((__m128i *)(void *)&dst[i], _mm_xor_si128(v, m128));
+    }
+  }
+#elif defined(USE_WS_MASK_NEON)
+  if((len - i) >= 16) {
+    uint8x16_t m128 = vld1q_u8(pat);
+    for(; (len - i) >= 16; i += 16)
+      vst1q_u8(&dst[i], veorq_u8(vld1q_u8(&src[i]), m128));
+  }
+#endif
+
+  /* word-wise for what remains, memcpy() copes with any alignment */
+  memcpy(&m64, pat, sizeof(m64));
+  for(; (len - i) >= 8; i += 8) {
+    memcpy(&w, &src[i], sizeof(w));
+    w ^= m64;
+    memcpy(&dst[i], &w, sizeof(w));
+  }
+  /* all blocks were multiples of 4, `xori` is still valid for the tail */
+  return ws_mask_scalar(&dst[i], &src[i], len - i, mask, xori);
+}
+
+struct ws_mask_ctx {
+  struct ws_encoder *enc;
+  const unsigned char *buf;
+  size_t len;
+};
+
+/* bufq reader that masks the payload straight into the buffer chunks */
+static CURLcode ws_mask_read(void *reader_ctx,
+                             unsigned char *buf, size_t len,
+                             size_t *pnread)
+{
+  struct ws_mask_ctx *ctx = reader_ctx;
+
+  if(len > ctx->len)
+    len = ctx->len;
+  ctx->enc->xori = ws_mask(buf, ctx->buf, len, ctx->enc->mask,
+                           ctx->enc->xori);
+  ctx->buf += len;
+  ctx->len -= len;
+  *pnread = len;
+  return CURLE_OK;
 }
 
 static CURLcode ws_enc_write_payload(struct ws_encoder *enc,
@@ -926,33 +1290,36 @@ static CURLcode ws_enc_write_payload(struct ws_encoder *enc,
                                      const unsigned char *buf, size_t buflen,
                                      struct bufq *out, size_t *pnwritten)
 {
-  CURLcode result;
-  size_t i, len, n;
+  struct ws_mask_ctx ctx;
+  CURLcode result = CURLE_OK;
+  size_t len, n;
 
   *pnwritten = 0;
   if(Curl_bufq_is_full(out))
     return CURLE_AGAIN;
 
-  /* not the most performant way to do this */
   len = buflen;
   if((curl_off_t)len > enc->payload_remain)
     len = (size_t)enc->payload_remain;
 
-  for(i = 0; i < len; ++i) {
-    unsigned char c = buf[i] ^ enc->mask[enc->xori];
-    result = Curl_bufq_write(out, &c, 1, &n);
-    if(result) {
-      if((result != CURLE_AGAIN) || !i)
-        return result;
+  ctx.enc = enc;
+  ctx.buf = buf;
+  ctx.len = len;
+  while(ctx.len) {
+    result = Curl_bufq_sipn(out, ctx.len, ws_mask_read, &ctx, &n);
+    if(result || !n)
       break;
-    }
-    enc->xori++;
-    enc->xori &= 3;
   }
-  *pnwritten = i;
-  enc->payload_remain -= (curl_off_t)i;
+  len -= ctx.len;
+  if(result) {
+    if((result != CURLE_AGAIN) || !len)
+      return result;
+    result = CURLE_OK;
+  }
+  *pnwritten = len;
+  enc->payload_remain -= (curl_off_t)len;
   ws_enc_info(enc, data, "buffered");
-  return CURLE_OK;
+  return result;
 }
 
 static CURLcode ws_enc_add_pending(struct Curl_easy *data,
@@ -966,7 +1333,7 @@ static CURLcode ws_enc_add_pending(struct Curl_easy *data,
   if(ws->enc.payload_remain) /* in the middle of another frame */
     return CURLE_AGAIN;
 
-  result = ws_enc_add_frame(data, &ws->enc, ws->pending.type,
+  result = ws_enc_add_frame(data, &ws->enc, ws->pending.type, 0,
                             (curl_off_t)ws->pending.payload_len,
                             &ws->sendbuf);
   if(result) {
@@ -991,6 +1358,89 @@ out:
   return result;
 }
 
+#ifdef HAVE_LIBZ
+static bool ws_enc_deflating(struct websocket *ws, unsigned int flags,
+                             size_t buflen)
+{
+  if(!ws->pmd || !ws->pmd->zout_init || (flags & CURLWS_OFFSET) ||
+     (buflen >= UINT_MAX))
+    return FALSE;
+  if(flags & (CURLWS_CLOSE | CURLWS_PING | CURLWS_PONG))
+    return FALSE;
+  if(ws->enc.contfragment) /* continue the message as it started */
+    return ws->pmd->out_msg;
+  return !!(flags & (CURLWS_TEXT | CURLWS_BINARY));
+}
+
+/* Deflate `buf` and add it as a complete frame to the sendbuf */
+static CURLcode ws_enc_deflate(struct Curl_easy *data,
+                               struct websocket *ws,
+                               const unsigned char *buf, size_t buflen,
+                               unsigned int flags)
+{
+  struct ws_deflate *pmd = ws->pmd;
+  z_stream *z = &pmd->zout;
+  bool first = !ws->enc.contfragment;
+  bool final = !(flags & CURLWS_CONT);
+  const unsigned char *zdata;
+  size_t zlen, n;
+  CURLcode result;
+  int status;
+
+  curlx_dyn_reset(&pmd->zbuf);
+  z->next_in = (z_const Bytef *)buf;
+  z->avail_in = (uInt)buflen;
+  do {
+    z->next_out = (Bytef *)pmd->obuf;
+    z->avail_out = (uInt)sizeof(pmd->obuf);
+    status = deflate(z, Z_SYNC_FLUSH);
+    if((status != Z_OK) && (status != Z_BUF_ERROR)) {
+      failf(data, "[WS] deflate error: %s", z->msg ? z->msg : "unknown");
+      return CURLE_SEND_ERROR;
+    }
+    result = curlx_dyn_addn(&pmd->zbuf, pmd->obuf,
+                            sizeof(pmd->obuf) - z->avail_out);
+    if(result)
+      return result;
+  } while(!z->avail_out);
+  DEBUGASSERT(!z->avail_in);
+
+  zdata = curlx_dyn_uptr(&pmd->zbuf);
+  zlen = curlx_dyn_len(&pmd->zbuf);
+  if(final) {
+    /* the message ends, remove the tail of the sync flush */
+    if((zlen >= 4) &&
+       !memcmp(zdata + zlen - 4, ws_deflate_tail, sizeof(ws_deflate_tail)))
+      zlen -= 4;
+    if(pmd->client_no_takeover)
+      (void)deflateReset(z);
+  }
+
+  /* any pending control frame goes first */
+  result = ws_enc_add_pending(data, ws);
+  if(result)
+    return result;
+  /* RSV1 is only set on the first frame of a message */
+  result = ws_enc_add_frame(data, &ws->enc, flags,
+                            first ? WSBIT_RSV1 : 0, (curl_off_t)zlen,
+                            &ws->sendbuf);
+  if(result)
+    return result;
+  if(zlen) {
+    result = ws_enc_write_payload(&ws->enc, data, zdata, zlen,
+                                  &ws->sendbuf, &n);
+    if(result)
+      return result;
+    DEBUGASSERT(n == zlen);
+  }
+  pmd->out_msg = !final;
+  ws->sendbuf_payload = buflen;
+  ws->sendbuf_deflated = TRUE;
+  CURL_TRC_WS(data, "deflated %zu payload bytes to %zu", buflen, zlen);
+  return CURLE_OK;
+}
+#endif /* HAVE_LIBZ */
+
 static CURLcode ws_enc_send(struct Curl_easy *data,
                             struct websocket *ws,
                             const unsigned char *buffer,
@@ -1005,7 +1455,8 @@ static CURLcode ws_enc_send(struct Curl_easy *data,
   DEBUGASSERT(!data->set.ws_raw_mode);
   *pnsent = 0;
 
-  if(ws->enc.payload_remain || !Curl_bufq_is_empty(&ws->sendbuf)) {
+  if(ws->enc.payload_remain ||
+     (!Curl_bufq_is_empty(&ws->sendbuf) && !ws->sendbuf_frames)) {
     /* a frame is ongoing with payload buffered or more payload
      * that needs to be encoded into the buffer */
     if(buflen < ws->sendbuf_payload) {
@@ -1030,13 +1481,26 @@ static CURLcode ws_enc_send(struct Curl_easy *data,
     if(result)
       return result;
 
-    result = ws_enc_write_head(data, ws, &ws->enc, flags,
-                               (flags & CURLWS_OFFSET) ?
-                               fragsize : (curl_off_t)buflen,
-                               &ws->sendbuf);
-    if(result) {
-      CURL_TRC_WS(data, "curl_ws_send(), error writing frame head %d", result);
-      return result;
+    ws->sendbuf_deflated = FALSE;
+#ifdef HAVE_LIBZ
+    if(ws_enc_deflating(ws, flags, buflen)) {
+      /* the complete message is now in sendbuf */
+      result = ws_enc_deflate(data, ws, buffer, buflen, flags);
+      if(result)
+        return result;
+    }
+    else
+#endif
+    {
+      result = ws_enc_write_head(data, ws, &ws->enc, flags,
+                                 (flags & CURLWS_OFFSET) ?
+                                 fragsize : (curl_off_t)buflen,
+                                 &ws->sendbuf);
+      if(result) {
+        CURL_TRC_WS(data, "curl_ws_send(), error writing frame head %d",
+                    result);
+        return result;
+      }
     }
   }
 
@@ -1064,9 +1528,12 @@ static CURLcode ws_enc_send(struct Curl_easy *data,
       buffer += ws->sendbuf_payload;
       buflen -= ws->sendbuf_payload;
       ws->sendbuf_payload = 0;
+      ws->sendbuf_deflated = FALSE;
     }
     else if(result == CURLE_AGAIN) {
-      if(ws->sendbuf_payload > Curl_bufq_len(&ws->sendbuf)) {
+      /* deflated payload only counts as sent once all of it is */
+      if(!ws->sendbuf_deflated &&
+         (ws->sendbuf_payload > Curl_bufq_len(&ws->sendbuf))) {
         /* blocked, part of payload bytes remain, report length
          * that we managed to send. */
         size_t flushed = (ws->sendbuf_payload - Curl_bufq_len(&ws->sendbuf));
@@ -1205,6 +1672,8 @@ static const struct Curl_crtype ws_cr_encode = {
   Curl_creader_def_cntrl,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_file_region,
+  Curl_creader_def_file_skip,
   sizeof(struct cr_ws_ctx)
 };
 
@@ -1242,9 +1711,29 @@ CURLcode Curl_ws_request(struct Curl_easy *data, struct dynbuf *req)
          base64-encoded (see Section 4 of [RFC4648]). The nonce MUST be
          selected randomly for each connection. */
       "Sec-WebSocket-Key", NULL,
+    },
+    {
+      /* The request MAY include a header field with the name
+         |Sec-WebSocket-Extensions|, listing the extensions the client
+         wishes to use. */
+      "Sec-WebSocket-Extensions", NULL,
     }
   };
   heads[2].val = &keyval[0];
+#ifdef HAVE_LIBZ
+  if(data->set.ws_deflate && !data->set.ws_raw_mode)
+    heads[3].val = data->set.ws_deflate_notakeover ?
+      "permessage-deflate; client_max_window_bits; "
+      "client_no_context_takeover; server_no_context_takeover" :
+      "permessage-deflate; client_max_window_bits";
+  if(data->conn) {
+    /* forget anything negotiated on this connection before */
+    struct websocket *ws = Curl_conn_meta_get(data->conn,
+                                              CURL_META_PROTO_WS_CONN);
+    if(ws)
+      ws_deflate_free(ws);
+  }
+#endif
 
   /* 16 bytes random */
   result = Curl_rand(data, (unsigned char *)rand, sizeof(rand));
@@ -1261,7 +1750,8 @@ CURLcode Curl_ws_request(struct Curl_easy *data, struct dynbuf *req)
   strcpy(keyval, randstr);
   free(randstr);
   for(i = 0; !result && (i < CURL_ARRAYSIZE(heads)); i++) {
-    if(!Curl_checkheaders(data, heads[i].name, strlen(heads[i].name))) {
+    if(heads[i].val &&
+       !Curl_checkheaders(data, heads[i].name, strlen(heads[i].name))) {
       result = curlx_dyn_addf(req, "%s: %s\r\n", heads[i].name,
                               heads[i].val);
     }
@@ -1278,9 +1768,200 @@ static void ws_conn_dtor(void *key, size_t klen, void *entry)
   (void)klen;
   Curl_bufq_free(&ws->recvbuf);
   Curl_bufq_free(&ws->sendbuf);
+#ifdef HAVE_LIBZ
+  ws_deflate_free(ws);
+#endif
   free(ws);
 }
 
+/* Get the websocket meta of the transfer's connection, create it when
+ * not there yet. */
+static CURLcode ws_conn_get(struct Curl_easy *data, struct websocket **pws,
+                            bool *pcreated)
+{
+  struct websocket *ws;
+  size_t chunk_size = WS_CHUNK_SIZE;
+  CURLcode result;
+
+  DEBUGASSERT(data->conn);
+  *pcreated = FALSE;
+  *pws = ws = Curl_conn_meta_get(data->conn, CURL_META_PROTO_WS_CONN);
+  if(ws)
+    return CURLE_OK;
+
+  ws = calloc(1, sizeof(*ws));
+  if(!ws)
+    return CURLE_OUT_OF_MEMORY;
+#ifdef DEBUGBUILD
+  {
+    const char *p = getenv("CURL_WS_CHUNK_SIZE");
+    if(p) {
+      curl_off_t l;
+      if(!curlx_str_number(&p, &l, 1*1024*1024))
+        chunk_size = (size_t)l;
+    }
+  }
+#endif
+  CURL_TRC_WS(data, "WS, using chunk size %zu", chunk_size);
+  Curl_bufq_init2(&ws->recvbuf, chunk_size, WS_CHUNK_COUNT,
+                  BUFQ_OPT_SOFT_LIMIT);
+  Curl_bufq_init2(&ws->sendbuf, chunk_size, WS_CHUNK_COUNT,
+                  BUFQ_OPT_SOFT_LIMIT);
+  ws_dec_init(&ws->dec);
+  ws_enc_init(&ws->enc);
+  result = Curl_conn_meta_set(data->conn, CURL_META_PROTO_WS_CONN,
+                              ws, ws_conn_dtor);
+  if(result)
+    return result;
+  *pws = ws;
+  *pcreated = TRUE;
+  return CURLE_OK;
+}
+
+#ifdef HAVE_LIBZ
+static void ws_deflate_free(struct websocket *ws)
+{
+  struct ws_deflate *pmd = ws->pmd;
+  if(pmd) {
+    if(pmd->zin_init)
+      (void)inflateEnd(&pmd->zin);
+    if(pmd->zout_init)
+      (void)deflateEnd(&pmd->zout);
+    curlx_dyn_free(&pmd->zbuf);
+    free(pmd);
+    ws->pmd = NULL;
+    ws->dec.pmd = NULL;
+  }
+}
+
+/* Parse the permessage-deflate parameters the server agreed to */
+static CURLcode ws_deflate_parse(struct Curl_easy *data,
+                                 struct ws_deflate *pmd, const char *p)
+{
+  struct Curl_str name;
+  curl_off_t bits;
+
+  curlx_str_passblanks(&p);
+  if(curlx_str_cspn(&p, &name, "; \t\r\n") ||
+     !curlx_str_casecompare(&name, "permessage-deflate"))
+    goto bad;
+
+  while(1) {
+    bool has_bits = FALSE;
+
+    curlx_str_passblanks(&p);
+    if(!*p || (*p == '\r') || (*p == '\n'))
+      break;
+    if(curlx_str_single(&p, ';'))
+      goto bad; /* more than one extension, or garbage */
+    curlx_str_passblanks(&p);
+    if(curlx_str_cspn(&p, &name, ";= \t\r\n"))
+      goto bad;
+    curlx_str_passblanks(&p);
+    if(!curlx_str_single(&p, '=')) {
+      bool quoted;
+      curlx_str_passblanks(&p);
+      quoted = !curlx_str_single(&p, '\"');
+      if(curlx_str_number(&p, &bits, 15) || (bits < 8) ||
+         (quoted && curlx_str_single(&p, '\"')))
+        goto bad;
+      has_bits = TRUE;
+    }
+
+    if(curlx_str_casecompare(&name, "server_no_context_takeover") &&
+       !has_bits)
+      pmd->server_no_takeover = TRUE;
+    else if(curlx_str_casecompare(&name, "client_no_context_takeover") &&
+            !has_bits)
+      pmd->client_no_takeover = TRUE;
+    else if(curlx_str_casecompare(&name, "server_max_window_bits") &&
+            has_bits)
+      ; /* we always inflate with the largest window */
+    else if(curlx_str_casecompare(&name, "client_max_window_bits") &&
+            has_bits)
+      pmd->client_max_window_bits = (int)bits;
+    else
+      goto bad;
+  }
+  return CURLE_OK;
+
+bad:
+  failf(data, "[WS] invalid Sec-WebSocket-Extensions: response");
+  return CURLE_WEIRD_SERVER_REPLY;
+}
+
+/* Setup the zlib streams for the negotiated permessage-deflate */
+static CURLcode ws_deflate_init(struct Curl_easy *data,
+                                struct ws_deflate *pmd)
+{
+  pmd->zin.zalloc = (alloc_func)Curl_zalloc_cb;
+  pmd->zin.zfree = (free_func)Curl_zfree_cb;
+  if(inflateInit2(&pmd->zin, -MAX_WBITS) != Z_OK) {
+    failf(data, "[WS] failed to init inflate");
+    return CURLE_FAILED_INIT;
+  }
+  pmd->zin_init = TRUE;
+
+  /* zlib does not do 256 byte windows for raw deflate, which means we
+   * can only send uncompressed messages then. */
+  if(pmd->client_max_window_bits > 8) {
+    pmd->zout.zalloc = (alloc_func)Curl_zalloc_cb;
+    pmd->zout.zfree = (free_func)Curl_zfree_cb;
+    if(deflateInit2(&pmd->zout, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                    -pmd->client_max_window_bits, 8,
+                    Z_DEFAULT_STRATEGY) != Z_OK) {
+      failf(data, "[WS] failed to init deflate");
+      return CURLE_FAILED_INIT;
+    }
+    pmd->zout_init = TRUE;
+  }
+  infof(data, "[WS] using permessage-deflate%s%s",
+        pmd->server_no_takeover ? ", server_no_context_takeover" : "",
+        pmd->client_no_takeover ? ", client_no_context_takeover" : "");
+  return CURLE_OK;
+}
+#endif /* HAVE_LIBZ */
+
+/*
+ * The server's Sec-WebSocket-Extensions: response header. It may only
+ * name an extension that was offered in the request.
+ */
+CURLcode Curl_ws_extensions(struct Curl_easy *data, const char *value)
+{
+#ifdef HAVE_LIBZ
+  struct websocket *ws;
+  struct ws_deflate *pmd;
+  bool created;
+  CURLcode result;
+#endif
+
+  if(Curl_checkheaders(data, STRCONST("Sec-WebSocket-Extensions")))
+    /* the application negotiates on its own */
+    return CURLE_OK;
+
+#ifdef HAVE_LIBZ
+  if(data->set.ws_deflate && !data->set.ws_raw_mode) {
+    result = ws_conn_get(data, &ws, &created);
+    if(result)
+      return result;
+    if(ws->pmd) {
+      failf(data, "[WS] more than one Sec-WebSocket-Extensions: response");
+      return CURLE_WEIRD_SERVER_REPLY;
+    }
+    pmd = calloc(1, sizeof(*pmd));
+    if(!pmd)
+      return CURLE_OUT_OF_MEMORY;
+    curlx_dyn_init(&pmd->zbuf, CURL_MAX_INPUT_LENGTH);
+    pmd->client_max_window_bits = MAX_WBITS;
+    ws->pmd = pmd;
+    return ws_deflate_parse(data, pmd, value);
+  }
+#endif
+  failf(data, "[WS] server selected an extension that was not offered: %s",
+        value);
+  return CURLE_WEIRD_SERVER_REPLY;
+}
+
 /*
  * 'nread' is number of bytes of websocket data already in the buffer at
  * 'mem'.
@@ -1292,42 +1973,26 @@ CURLcode Curl_ws_accept(struct Curl_easy *data,
   struct websocket *ws;
   struct Curl_cwriter *ws_dec_writer = NULL;
   struct Curl_creader *ws_enc_reader = NULL;
+  bool created;
   CURLcode result;
 
   DEBUGASSERT(data->conn);
-  ws = Curl_conn_meta_get(data->conn, CURL_META_PROTO_WS_CONN);
-  if(!ws) {
-    size_t chunk_size = WS_CHUNK_SIZE;
-    ws = calloc(1, sizeof(*ws));
-    if(!ws)
-      return CURLE_OUT_OF_MEMORY;
-#ifdef DEBUGBUILD
-    {
-      const char *p = getenv("CURL_WS_CHUNK_SIZE");
-      if(p) {
-        curl_off_t l;
-        if(!curlx_str_number(&p, &l, 1*1024*1024))
-          chunk_size = (size_t)l;
-      }
-    }
-#endif
-    CURL_TRC_WS(data, "WS, using chunk size %zu", chunk_size);
-    Curl_bufq_init2(&ws->recvbuf, chunk_size, WS_CHUNK_COUNT,
-                    BUFQ_OPT_SOFT_LIMIT);
-    Curl_bufq_init2(&ws->sendbuf, chunk_size, WS_CHUNK_COUNT,
-                    BUFQ_OPT_SOFT_LIMIT);
-    ws_dec_init(&ws->dec);
-    ws_enc_init(&ws->enc);
-    result = Curl_conn_meta_set(data->conn, CURL_META_PROTO_WS_CONN,
-                                ws, ws_conn_dtor);
-    if(result)
-      return result;
-  }
-  else {
+  result = ws_conn_get(data, &ws, &created);
+  if(result)
+    return result;
+  if(!created) {
     Curl_bufq_reset(&ws->recvbuf);
     ws_dec_reset(&ws->dec);
     ws_enc_reset(&ws->enc);
   }
+#ifdef HAVE_LIBZ
+  if(ws->pmd && !ws->pmd->zin_init) {
+    result = ws_deflate_init(data, ws->pmd);
+    if(result)
+      return result;
+    ws->dec.pmd = ws->pmd;
+  }
+#endif
   /* Verify the Sec-WebSocket-Accept response.
 
      The sent value is the base64 encoded version of a SHA-1 hash done on the
@@ -1339,6 +2004,7 @@ CURLcode Curl_ws_accept(struct Curl_easy *data,
      this header field indicates the use of an extension that was not present
      in the client's handshake (the server has indicated an extension not
      requested by the client), the client MUST Fail the WebSocket Connection.
+     This is checked in Curl_ws_extensions().
   */
 
   /* If the response includes a |Sec-WebSocket-Protocol| header field
@@ -1426,10 +2092,12 @@ struct ws_collect {
   unsigned char *buffer;
   size_t buflen;
   size_t bufidx;
+  const unsigned char *lent; /* payload lent, not copied to `buffer` */
   int frame_age;
   int frame_flags;
   curl_off_t payload_offset;
   curl_off_t payload_len;
+  bool lend;  /* lend the payload instead of copying it */
   bool written;
 };
 
@@ -1452,8 +2120,9 @@ static CURLcode ws_client_collect(const unsigned char *buf, size_t buflen,
     ctx->frame_age = frame_age;
     ctx->frame_flags = frame_flags;
     ctx->payload_offset = payload_offset;
-    ctx->payload_len = payload_len;
   }
+  /* the length of an inflated frame is not known up front */
+  ctx->payload_len = payload_len;
 
   if(auto_pong && (frame_flags & CURLWS_PING) && !remain) {
     /* auto-respond to PINGs, only works for single-frame payloads atm */
@@ -1465,6 +2134,15 @@ static CURLcode ws_client_collect(const unsigned char *buf, size_t buflen,
       return result;
     *pnwritten = buflen;
   }
+  else if(ctx->lend) {
+    /* Do not consume anything, remember where the payload is and stop.
+     * curl_ws_recv_release() consumes what the caller is done with. */
+    ctx->written = TRUE;
+    ctx->lent = buf;
+    ctx->bufidx = buflen;
+    if(buflen)
+      return CURLE_AGAIN;
+  }
   else {
     size_t write_len;
 
@@ -1491,21 +2169,12 @@ static CURLcode nw_in_recv(void *reader_ctx,
   return curl_easy_recv(data, buf, buflen, pnread);
 }
 
-CURLcode curl_ws_recv(CURL *d, void *buffer,
-                      size_t buflen, size_t *nread,
-                      const struct curl_ws_frame **metap)
+/* Get the websocket of a CONNECT_ONLY transfer for receiving */
+static CURLcode ws_recv_get(struct Curl_easy *data, struct websocket **pws)
 {
-  struct Curl_easy *data = d;
-  struct connectdata *conn;
-  struct websocket *ws;
-  struct ws_collect ctx;
-
-  *nread = 0;
-  *metap = NULL;
-  if(!GOOD_EASY_HANDLE(data))
-    return CURLE_BAD_FUNCTION_ARGUMENT;
+  struct connectdata *conn = data->conn;
 
-  conn = data->conn;
+  *pws = NULL;
   if(!conn) {
     /* Unhappy hack with lifetimes of transfers and connection */
     if(!data->set.connect_only) {
@@ -1519,19 +2188,18 @@ CURLcode curl_ws_recv(CURL *d, void *buffer,
       return CURLE_BAD_FUNCTION_ARGUMENT;
     }
   }
-  ws = Curl_conn_meta_get(conn, CURL_META_PROTO_WS_CONN);
-  if(!ws) {
+  *pws = Curl_conn_meta_get(conn, CURL_META_PROTO_WS_CONN);
+  if(!*pws) {
     failf(data, "[WS] connection is not setup for websocket");
     return CURLE_BAD_FUNCTION_ARGUMENT;
   }
+  return CURLE_OK;
+}
 
-
-  memset(&ctx, 0, sizeof(ctx));
-  ctx.data = data;
-  ctx.ws = ws;
-  ctx.buffer = buffer;
-  ctx.buflen = buflen;
-
+/* Decode received frames into `ctx` until something is written to it */
+static CURLcode ws_recv_pass(struct Curl_easy *data, struct websocket *ws,
+                             struct ws_collect *ctx)
+{
   while(1) {
     CURLcode result;
 
@@ -1551,9 +2219,9 @@ CURLcode curl_ws_recv(CURL *d, void *buffer,
     }
 
     result = ws_dec_pass(&ws->dec, data, &ws->recvbuf,
-                         ws_client_collect, &ctx);
+                         ws_client_collect, ctx);
     if(result == CURLE_AGAIN) {
-      if(!ctx.written) {
+      if(!ctx->written) {
         ws_dec_info(&ws->dec, data, "need more input");
         continue;  /* nothing written, try more input */
       }
@@ -1562,7 +2230,7 @@ CURLcode curl_ws_recv(CURL *d, void *buffer,
     else if(result) {
       return result;
     }
-    else if(ctx.written) {
+    else if(ctx->written) {
       /* The decoded frame is passed back to our caller.
        * There are frames like PING were we auto-respond to and
        * that we do not return. For these `ctx.written` is not set. */
@@ -1571,14 +2239,8 @@ CURLcode curl_ws_recv(CURL *d, void *buffer,
   }
 
   /* update frame information to be passed back */
-  update_meta(ws, ctx.frame_age, ctx.frame_flags, ctx.payload_offset,
-              ctx.payload_len, ctx.bufidx);
-  *metap = &ws->recvframe;
-  *nread = ws->recvframe.len;
-  CURL_TRC_WS(data, "curl_ws_recv(len=%zu) -> %zu bytes (frame at %"
-               FMT_OFF_T ", %" FMT_OFF_T " left)",
-               buflen, *nread, ws->recvframe.offset,
-               ws->recvframe.bytesleft);
+  update_meta(ws, ctx->frame_age, ctx->frame_flags, ctx->payload_offset,
+              ctx->payload_len, ctx->bufidx);
   /* all's well, try to send any pending control. we do not know
    * when the application will call `curl_ws_send()` again. */
   if(!data->set.ws_raw_mode && ws->pending.type) {
@@ -1589,6 +2251,125 @@ CURLcode curl_ws_recv(CURL *d, void *buffer,
   return CURLE_OK;
 }
 
+CURLcode curl_ws_recv(CURL *d, void *buffer,
+                      size_t buflen, size_t *nread,
+                      const struct curl_ws_frame **metap)
+{
+  struct Curl_easy *data = d;
+  struct websocket *ws;
+  struct ws_collect ctx;
+  CURLcode result;
+
+  *nread = 0;
+  *metap = NULL;
+  if(!GOOD_EASY_HANDLE(data))
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+
+  result = ws_recv_get(data, &ws);
+  if(result)
+    return result;
+
+  /* an unreleased view is given up, its payload is copied now */
+  ws->lent_len = 0;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.data = data;
+  ctx.ws = ws;
+  ctx.buffer = buffer;
+  ctx.buflen = buflen;
+
+  result = ws_recv_pass(data, ws, &ctx);
+  if(result)
+    return result;
+
+  *metap = &ws->recvframe;
+  *nread = ws->recvframe.len;
+  CURL_TRC_WS(data, "curl_ws_recv(len=%zu) -> %zu bytes (frame at %"
+               FMT_OFF_T ", %" FMT_OFF_T " left)",
+               buflen, *nread, ws->recvframe.offset,
+               ws->recvframe.bytesleft);
+  return CURLE_OK;
+}
+
+CURLcode curl_ws_recv_view(CURL *d, const void **bufp, size_t *lenp,
+                           const struct curl_ws_frame **metap)
+{
+  struct Curl_easy *data = d;
+  struct websocket *ws;
+  struct ws_collect ctx;
+  CURLcode result;
+
+  if(!bufp || !lenp || !metap)
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  *bufp = NULL;
+  *lenp = 0;
+  *metap = NULL;
+  if(!GOOD_EASY_HANDLE(data))
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+
+  result = ws_recv_get(data, &ws);
+  if(result)
+    return result;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.data = data;
+  ctx.ws = ws;
+  ctx.lend = TRUE;
+
+  result = ws_recv_pass(data, ws, &ctx);
+  if(result)
+    return result;
+
+  ws->lent_len = ctx.bufidx;
+  *bufp = ctx.lent;
+  *lenp = ctx.bufidx;
+  *metap = &ws->recvframe;
+  CURL_TRC_WS(data, "curl_ws_recv_view() -> %zu bytes (frame at %"
+               FMT_OFF_T ", %" FMT_OFF_T " left)",
+               *lenp, ws->recvframe.offset, ws->recvframe.bytesleft);
+  return CURLE_OK;
+}
+
+CURLcode curl_ws_recv_release(CURL *d, size_t len)
+{
+  struct Curl_easy *data = d;
+  struct websocket *ws;
+  struct ws_decoder *dec;
+  CURLcode result;
+
+  if(!GOOD_EASY_HANDLE(data))
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+
+  result = ws_recv_get(data, &ws);
+  if(result)
+    return result;
+
+  if(len > ws->lent_len) {
+    failf(data, "[WS] releasing %zu bytes, but only %zu were lent",
+          len, ws->lent_len);
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+  ws->lent_len = 0;
+  if(!len)
+    return CURLE_OK;
+
+  dec = &ws->dec;
+  DEBUGASSERT(dec->state == WS_DEC_PAYLOAD);
+#ifdef HAVE_LIBZ
+  if(ws_dec_inflating(dec)) {
+    /* the view was into the inflated data */
+    dec->pmd->ioff += len;
+    dec->pmd->out_offset += (curl_off_t)len;
+    return CURLE_OK;
+  }
+#endif
+  Curl_bufq_skip(&ws->recvbuf, len);
+  dec->payload_offset += (curl_off_t)len;
+  if(dec->payload_offset == dec->payload_len)
+    dec->state = WS_DEC_INIT;  /* frame done */
+  return CURLE_OK;
+}
+
 static CURLcode ws_flush(struct Curl_easy *data, struct websocket *ws,
                          bool blocking)
 {
@@ -1644,6 +2425,7 @@ static CURLcode ws_flush(struct Curl_easy *data, struct websocket *ws,
       }
     }
   }
+  ws->sendbuf_frames = FALSE;
   return CURLE_OK;
 }
 
@@ -1803,6 +2585,124 @@ out:
   return result;
 }
 
+/* Add a complete frame with the payload of `v` to the sendbuf */
+static CURLcode ws_enc_add_vec(struct Curl_easy *data,
+                               struct websocket *ws,
+                               const struct curl_ws_vec *v)
+{
+  size_t n;
+  CURLcode result;
+
+#ifdef HAVE_LIBZ
+  if(ws_enc_deflating(ws, v->flags, v->buflen)) {
+    result = ws_enc_deflate(data, ws, v->buffer, v->buflen, v->flags);
+    /* not a partial curl_ws_send(), the frame is accepted as a whole */
+    ws->sendbuf_payload = 0;
+    ws->sendbuf_deflated = FALSE;
+    return result;
+  }
+#endif
+  result = ws_enc_write_head(data, ws, &ws->enc, v->flags,
+                             (curl_off_t)v->buflen, &ws->sendbuf);
+  if(!result && v->buflen) {
+    result = ws_enc_write_payload(&ws->enc, data, v->buffer, v->buflen,
+                                  &ws->sendbuf, &n);
+    DEBUGASSERT(result || (n == v->buflen));
+  }
+  return result;
+}
+
+CURLcode curl_ws_sendv(CURL *d, const struct curl_ws_vec *frames,
+                       size_t nframes, size_t *nsent)
+{
+  struct Curl_easy *data = d;
+  struct websocket *ws;
+  size_t ndummy;
+  size_t *pnsent = nsent ? nsent : &ndummy;
+  size_t max_queued;
+  CURLcode result = CURLE_OK;
+
+  *pnsent = 0;
+  if(!GOOD_EASY_HANDLE(data))
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  if(!frames && nframes)
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  CURL_TRC_WS(data, "curl_ws_sendv(nframes=%zu)", nframes);
+
+  if(!data->conn && data->set.connect_only) {
+    result = Curl_connect_only_attach(data);
+    if(result)
+      return result;
+  }
+  if(!data->conn) {
+    failf(data, "[WS] No associated connection");
+    return CURLE_SEND_ERROR;
+  }
+  ws = Curl_conn_meta_get(data->conn, CURL_META_PROTO_WS_CONN);
+  if(!ws) {
+    failf(data, "[WS] Not a websocket transfer");
+    return CURLE_SEND_ERROR;
+  }
+  if(data->set.ws_raw_mode) {
+    failf(data, "[WS] cannot curl_ws_sendv() in raw mode");
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+  if(ws->enc.payload_remain || ws->sendbuf_payload) {
+    failf(data, "[WS] previous frame not finished");
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+
+  /* what has been accepted before goes out first */
+  result = ws_flush(data, ws, Curl_is_in_callback(data));
+  if(result)
+    goto out;
+
+  max_queued = ws->sendbuf.chunk_size * ws->sendbuf.max_chunks;
+  while(*pnsent < nframes) {
+    const struct curl_ws_vec *v = &frames[*pnsent];
+
+    if(!v->buffer && v->buflen) {
+      failf(data, "[WS] buffer is NULL when buflen is not");
+      result = CURLE_BAD_FUNCTION_ARGUMENT;
+      break;
+    }
+    if(v->flags & CURLWS_OFFSET) {
+      failf(data, "[WS] CURLWS_OFFSET is not supported by curl_ws_sendv()");
+      result = CURLE_BAD_FUNCTION_ARGUMENT;
+      break;
+    }
+    if(v->buflen > max_queued - WS_MAX_FRAME_HEAD_LEN) {
+      failf(data, "[WS] frame of %zu bytes too large for curl_ws_sendv()",
+            v->buflen);
+      result = CURLE_TOO_LARGE;
+      break;
+    }
+    if(Curl_bufq_len(&ws->sendbuf) + WS_MAX_FRAME_HEAD_LEN + v->buflen >
+       max_queued) {
+      /* the sendbuf is full, send it all off in one go */
+      result = ws_flush(data, ws, Curl_is_in_callback(data));
+      if(result)
+        break;
+      continue;
+    }
+    result = ws_enc_add_vec(data, ws, v);
+    if(result)
+      break;
+    ws->sendbuf_frames = TRUE;
+    ++(*pnsent);
+  }
+
+  if(!result) /* send off everything queued in one go */
+    result = ws_flush(data, ws, Curl_is_in_callback(data));
+  if((result == CURLE_AGAIN) && *pnsent)
+    result = CURLE_OK; /* accepted frames go out on the next send */
+
+out:
+  CURL_TRC_WS(data, "curl_ws_sendv(nframes=%zu) -> %d, %zu",
+              nframes, result, *pnsent);
+  return result;
+}
+
 static CURLcode ws_setup_conn(struct Curl_easy *data,
                               struct connectdata *conn)
 {
@@ -1966,6 +2866,33 @@ CURLcode curl_ws_send(CURL *curl, const void *buffer,
   return CURLE_NOT_BUILT_IN;
 }
 
+CURLcode curl_ws_recv_view(CURL *curl, const void **bufp, size_t *lenp,
+                           const struct curl_ws_frame **metap)
+{
+  (void)curl;
+  (void)bufp;
+  (void)lenp;
+  (void)metap;
+  return CURLE_NOT_BUILT_IN;
+}
+
+CURLcode curl_ws_recv_release(CURL *curl, size_t len)
+{
+  (void)curl;
+  (void)len;
+  return CURLE_NOT_BUILT_IN;
+}
+
+CURLcode curl_ws_sendv(CURL *curl, const struct curl_ws_vec *frames,
+                       size_t nframes, size_t *nsent)
+{
+  (void)curl;
+  (void)frames;
+  (void)nframes;
+  (void)nsent;
+  return CURLE_NOT_BUILT_IN;
+}
+
 const struct curl_ws_frame *curl_ws_meta(CURL *data)
 {
   (void)data;
@@ -32,12 +32,24 @@
 
 CURLcode Curl_ws_request(struct Curl_easy *data, struct dynbuf *req);
 CURLcode Curl_ws_accept(struct Curl_easy *data, const char *mem, size_t len);
+CURLcode Curl_ws_extensions(struct Curl_easy *data, const char *value);
 
 extern const struct Curl_handler Curl_handler_ws;
 #ifdef USE_SSL
 extern const struct Curl_handler Curl_handler_wss;
 #endif
 
+#ifdef UNITTESTS
+UNITTEST unsigned int ws_mask_scalar(unsigned char *dst,
+                                     const unsigned char *src, size_t len,
+                                     const unsigned char *mask,
+                                     unsigned int xori);
+UNITTEST unsigned int ws_mask(unsigned char *dst,
+                              const unsigned char *src, size_t len,
+                              const unsigned char *mask,
+                              unsigned int xori);
+#endif
+
 
 #else
 #define Curl_ws_request(x,y) CURLE_OK
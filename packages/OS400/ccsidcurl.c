@@ -1170,6 +1170,7 @@ curl_easy_setopt_ccsid(CURL *easy, CURLoption tag, ...)
   case CURLOPT_TLSAUTH_TYPE:
   case CURLOPT_TLSAUTH_USERNAME:
   case CURLOPT_UNIX_SOCKET_PATH:
+  case CURLOPT_UPLOAD_ENCODING:
   case CURLOPT_URL:
   case CURLOPT_USERAGENT:
   case CURLOPT_USERNAME:
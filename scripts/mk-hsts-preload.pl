@@ -0,0 +1,78 @@
+#!/usr/bin/env perl
+#***************************************************************************
+#                                  _   _ ____  _
+#  Project                     ___| | | |  _ \| |
+#                             / __| | | | |_) | |
+#                            | (__| |_| |  _ <| |___
+#                             \___|\___/|_| \_\_____|
+#
+# Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+#
+# This software is licensed as described in the file COPYING, which
+# you should have received as part of this distribution. The terms
+# are also available at https://curl.se/docs/copyright.html.
+#
+# You may opt to use, copy, modify, merge, publish, distribute and/or sell
+# copies of the Software, and permit persons to whom the Software is
+# furnished to do so, under the terms of the COPYING file.
+#
+# This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+# KIND, either express or implied.
+#
+# SPDX-License-Identifier: curl
+#
+###########################################################################
+
+=begin comment
+
+Converts HSTS entries in the text cache file format into a binary HSTS
+preload file, as described in docs/HSTS.md.
+
+Usage: mk-hsts-preload.pl [input] > preload
+
+=end comment
+=cut
+
+use strict;
+use warnings;
+use Time::Local;
+
+my %hosts;
+
+while(my $line = <>) {
+    $line =~ s/[\r\n]+$//;
+    next if($line =~ /^\s*(#|$)/);
+    if($line !~ /^\s*(\.?)([^\s"]+) "([^"]*)"/) {
+        print STDERR "$ARGV:$.: bad line, ignored\n";
+        next;
+    }
+    my ($sub, $host, $date) = ($1, lc($2), $3);
+    my $expires;
+    $host =~ s/\.$//;
+    if($date eq "unlimited") {
+        # the largest signed 64-bit value
+        $expires = "\x7f" . ("\xff" x 7);
+    }
+    elsif($date =~ /^(\d{4})(\d\d)(\d\d) (\d\d):(\d\d):(\d\d)$/) {
+        my $t = timegm($6, $5, $4, $3, $2 - 1, $1);
+        $expires = pack("NN", int($t / 4294967296), $t % 4294967296);
+    }
+    else {
+        print STDERR "$ARGV:$.: bad date, ignored\n";
+        next;
+    }
+    # the last entry for a host wins
+    $hosts{$host} = $expires . pack("C", $sub ? 1 : 0) . $host . "\0";
+}
+
+my @sorted = sort keys %hosts;
+my $offset = 16 + 4 * scalar(@sorted);
+my $table = "";
+my $entries = "";
+for my $host (@sorted) {
+    $table .= pack("N", $offset + length($entries));
+    $entries .= $hosts{$host};
+}
+
+binmode(STDOUT);
+print "curlHSTS" . pack("NN", 1, scalar(@sorted)) . $table . $entries;
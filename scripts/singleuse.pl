@@ -114,9 +114,11 @@ my %api = (
     'curl_multi_fdset' => 'API',
     'curl_multi_get_handles' => 'API',
     'curl_multi_get_offt' => 'API',
+    'curl_multi_handoff' => 'API',
     'curl_multi_info_read' => 'API',
     'curl_multi_init' => 'API',
     'curl_multi_perform' => 'API',
+    'curl_multi_preconnect' => 'API',
     'curl_multi_remove_handle' => 'API',
     'curl_multi_setopt' => 'API',
     'curl_multi_socket' => 'API',
@@ -156,7 +158,10 @@ my %api = (
     'curl_easy_nextheader' => 'API',
     'curl_ws_meta' => 'API',
     'curl_ws_recv' => 'API',
+    'curl_ws_recv_release' => 'API',
+    'curl_ws_recv_view' => 'API',
     'curl_ws_send' => 'API',
+    'curl_ws_sendv' => 'API',
     'curl_ws_start_frame' => 'API',
 
     # the following functions are provided globally in debug builds
@@ -0,0 +1,192 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+#include "tool_adapt.h"
+#include "tool_msgs.h"
+
+#include "memdebug.h" /* keep this as LAST include */
+
+/*
+ * The limit is adjusted with AIMD, like TCP congestion control does. It
+ * starts at one and grows by one for every successful transfer (slow start)
+ * until the host first shows signs of congestion. From then on it grows by
+ * one for every 'limit' successful transfers, and it is halved on every
+ * congestion event.
+ *
+ * Congestion is a 429 or 503 response, a failed connect, a timeout, or a
+ * time to first byte that has grown to more than twice the lowest one seen.
+ * Transfers started before a cut do not cut again.
+ */
+
+/* the latency must also be this much above the lowest before it counts */
+#define ADAPT_SLACK_US 5000
+
+struct adapt_host {
+  struct adapt_host *next;
+  char *name;          /* scheme://host:port */
+  long limit;          /* transfers allowed at once */
+  long max;            /* the limit never goes above this */
+  long running;
+  long ssthresh;       /* zero until the first congestion */
+  long credit;         /* successful transfers since the last increase */
+  curl_off_t started;  /* number of admitted transfers */
+  curl_off_t recover;  /* transfers admitted before this predate the cut */
+  curl_off_t min_us;   /* the lowest latency seen, drifting up slowly */
+  curl_off_t avg_us;   /* smoothed latency */
+};
+
+static struct adapt_host *hosts;
+
+static char *host_name(const char *url)
+{
+  CURLU *uh = curl_url();
+  char *name = NULL;
+  if(uh) {
+    char *scheme = NULL;
+    char *host = NULL;
+    char *port = NULL;
+    if(!curl_url_set(uh, CURLUPART_URL, url,
+                     CURLU_GUESS_SCHEME | CURLU_NON_SUPPORT_SCHEME) &&
+       !curl_url_get(uh, CURLUPART_SCHEME, &scheme, 0) &&
+       !curl_url_get(uh, CURLUPART_HOST, &host, 0) &&
+       !curl_url_get(uh, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT))
+      name = aprintf("%s://%s:%s", scheme, host, port);
+    curl_free(scheme);
+    curl_free(host);
+    curl_free(port);
+    curl_url_cleanup(uh);
+  }
+  return name;
+}
+
+struct adapt_host *adapt_host(const char *url, long max)
+{
+  struct adapt_host *h;
+  char *name = host_name(url);
+  if(!name)
+    /* all the odd ones share one state */
+    name = strdup("");
+  if(!name)
+    return NULL;
+  for(h = hosts; h; h = h->next) {
+    if(!strcmp(h->name, name)) {
+      free(name);
+      return h;
+    }
+  }
+  h = calloc(1, sizeof(*h));
+  if(!h) {
+    free(name);
+    return NULL;
+  }
+  h->name = name;
+  h->limit = 1;
+  h->max = max;
+  h->next = hosts;
+  hosts = h;
+  return h;
+}
+
+bool adapt_admit(struct adapt_host *h, curl_off_t *seq)
+{
+  if(h->running >= h->limit)
+    return FALSE;
+  h->running++;
+  *seq = h->started++;
+  return TRUE;
+}
+
+void adapt_done(struct adapt_host *h, curl_off_t seq, long code,
+                CURLcode result, curl_off_t latency)
+{
+  bool congested = (code == 429) || (code == 503) ||
+    (result == CURLE_COULDNT_CONNECT) || (result == CURLE_OPERATION_TIMEDOUT);
+  /* only a host that used at least half of what it was allowed may get
+     more */
+  bool limited = (h->running * 2 >= h->limit);
+
+  h->running--;
+  if(!congested && !result && (latency >= 0)) {
+    if(!h->min_us || (latency < h->min_us))
+      h->min_us = latency;
+    h->avg_us = h->avg_us ? h->avg_us - h->avg_us / 8 + latency / 8 : latency;
+    if((h->avg_us > 2 * h->min_us) &&
+       (h->avg_us > h->min_us + ADAPT_SLACK_US)) {
+      if(h->limit > 1)
+        congested = TRUE;
+      else
+        /* slow with a single transfer, so the host is slower for good and
+           this is what it is going to be measured against */
+        h->min_us = h->avg_us;
+    }
+  }
+
+  if(congested) {
+    if(seq >= h->recover) {
+      h->limit = (h->limit > 1) ? h->limit / 2 : 1;
+      h->ssthresh = h->limit;
+      h->credit = 0;
+      h->recover = h->started;
+      h->avg_us = 0; /* measure again with the new limit */
+    }
+  }
+  else if(!result && limited && (h->limit < h->max)) {
+    if(!h->ssthresh)
+      h->limit++;
+    else if(++h->credit >= h->limit) {
+      h->limit++;
+      h->credit = 0;
+    }
+  }
+}
+
+void adapt_cancel(struct adapt_host *h)
+{
+  if(h->running)
+    h->running--;
+}
+
+long adapt_limit(const struct adapt_host *h)
+{
+  return h->limit;
+}
+
+void adapt_report(void)
+{
+  const struct adapt_host *h;
+  for(h = hosts; h; h = h->next)
+    notef("adaptive concurrency for %s ended at %ld",
+          h->name[0] ? h->name : "other URLs", h->limit);
+}
+
+void adapt_cleanup(void)
+{
+  while(hosts) {
+    struct adapt_host *next = hosts->next;
+    free(hosts->name);
+    free(hosts);
+    hosts = next;
+  }
+}
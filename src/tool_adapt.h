@@ -0,0 +1,56 @@
+#ifndef HEADER_CURL_TOOL_ADAPT_H
+#define HEADER_CURL_TOOL_ADAPT_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+/*
+ * --parallel-adaptive limits the number of concurrent transfers per host
+ * based on how the host responds.
+ */
+
+struct adapt_host;
+
+/* the state for the host of the URL, never allowing more than 'max' */
+struct adapt_host *adapt_host(const char *url, long max);
+
+/* TRUE if one more transfer may start now, and then 'seq' is set */
+bool adapt_admit(struct adapt_host *h, curl_off_t *seq);
+
+/* a transfer ended, 'latency' is the time to the first byte in us */
+void adapt_done(struct adapt_host *h, curl_off_t seq, long code,
+                CURLcode result, curl_off_t latency);
+
+/* an admitted transfer never started, forget it without learning */
+void adapt_cancel(struct adapt_host *h);
+
+/* the current limit */
+long adapt_limit(const struct adapt_host *h);
+
+/* tell the final limits, in verbose mode */
+void adapt_report(void);
+
+void adapt_cleanup(void);
+
+#endif /* HEADER_CURL_TOOL_ADAPT_H */
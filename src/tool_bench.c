@@ -0,0 +1,299 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+#include "tool_cfgable.h"
+#include "tool_bench.h"
+#include "tool_msgs.h"
+
+#include "memdebug.h" /* keep this as LAST include */
+
+/*
+ * The latencies are counted in a histogram with 16 linear steps for every
+ * power of two microseconds, which keeps the memory use fixed no matter how
+ * many transfers are done, at the price of a precision of about 6%.
+ */
+#define BENCH_SUB 16
+#define BENCH_SUBBITS 4
+#define BENCH_BUCKETS ((64 - BENCH_SUBBITS) * BENCH_SUB)
+
+struct benchtimer {
+  const char *name;
+  curl_off_t count;
+  curl_off_t min;
+  curl_off_t max;
+  curl_off_t sum;
+  curl_off_t bucket[BENCH_BUCKETS];
+};
+
+enum {
+  BENCH_DNS,
+  BENCH_CONNECT,
+  BENCH_TLS,
+  BENCH_TTFB,
+  BENCH_TOTAL,
+  BENCH_LAST /* keep last */
+};
+
+static struct {
+  struct curltime start;
+  curl_off_t rounds;   /* started rounds of the request set */
+  curl_off_t started;  /* transfers started under --rate */
+  curl_off_t done;     /* finished transfers */
+  curl_off_t failed;
+  curl_off_t bytes;    /* received */
+  struct benchtimer timer[BENCH_LAST];
+} bench;
+
+static const char * const timer_names[] = {
+  "dns", "connect", "tls", "ttfb", "total"
+};
+
+static int bucket_index(curl_off_t us)
+{
+  int msb = BENCH_SUBBITS;
+  if(us < BENCH_SUB)
+    return (int)us;
+  while((us >> (msb + 1)) && (msb < 62))
+    msb++;
+  return ((msb - BENCH_SUBBITS + 1) * BENCH_SUB) +
+    (int)((us >> (msb - BENCH_SUBBITS)) & (BENCH_SUB - 1));
+}
+
+/* the smallest value counted in the bucket */
+static curl_off_t bucket_value(int i)
+{
+  int shift;
+  if(i < BENCH_SUB)
+    return i;
+  shift = (i / BENCH_SUB) - 1;
+  return (curl_off_t)(BENCH_SUB + (i % BENCH_SUB)) << shift;
+}
+
+static void timer_add(struct benchtimer *t, curl_off_t us)
+{
+  if(us < 0)
+    us = 0;
+  if(!t->count || (us < t->min))
+    t->min = us;
+  if(us > t->max)
+    t->max = us;
+  t->sum += us;
+  t->count++;
+  t->bucket[bucket_index(us)]++;
+}
+
+/* the value below which 'permille' of the samples are */
+static curl_off_t timer_percentile(const struct benchtimer *t, int permille)
+{
+  curl_off_t want = (t->count * permille + 999) / 1000;
+  curl_off_t seen = 0;
+  int i;
+  for(i = 0; i < BENCH_BUCKETS; i++) {
+    seen += t->bucket[i];
+    if(seen >= want) {
+      curl_off_t v = bucket_value(i);
+      /* within the known range */
+      if(v < t->min)
+        v = t->min;
+      if(v > t->max)
+        v = t->max;
+      return v;
+    }
+  }
+  return t->max;
+}
+
+void bench_init(void)
+{
+  int i;
+  memset(&bench, 0, sizeof(bench));
+  for(i = 0; i < BENCH_LAST; i++)
+    bench.timer[i].name = timer_names[i];
+  bench.start = curlx_now();
+  bench.rounds = 1;
+}
+
+bool bench_expired(void)
+{
+  return global->bench_ms &&
+    (curlx_timediff(curlx_now(), bench.start) >= global->bench_ms);
+}
+
+bool bench_next_round(void)
+{
+  if(!global->bench || bench_expired())
+    return FALSE;
+  if(global->bench_rounds && (bench.rounds >= global->bench_rounds))
+    return FALSE;
+  bench.rounds++;
+  return TRUE;
+}
+
+timediff_t bench_start_in(void)
+{
+  if(global->bench && global->ms_per_transfer) {
+    timediff_t elapsed = curlx_timediff(curlx_now(), bench.start);
+    timediff_t at = bench.started * global->ms_per_transfer;
+    if(at > elapsed)
+      return at - elapsed;
+    bench.started++;
+  }
+  return 0;
+}
+
+long bench_timeout(long ms)
+{
+  if(global->bench && global->ms_per_transfer) {
+    timediff_t elapsed = curlx_timediff(curlx_now(), bench.start);
+    timediff_t at = bench.started * global->ms_per_transfer;
+    if(at <= elapsed)
+      return 0;
+    if((at - elapsed) < ms)
+      return (long)(at - elapsed);
+  }
+  return ms;
+}
+
+void bench_add(CURL *curl, CURLcode result)
+{
+  curl_off_t namelookup = 0;
+  curl_off_t connect = 0;
+  curl_off_t appconnect = 0;
+  curl_off_t starttransfer = 0;
+  curl_off_t total = 0;
+  curl_off_t size = 0;
+  long connects = 0;
+
+  bench.done++;
+  if(result) {
+    bench.failed++;
+    return;
+  }
+  curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+  curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+  curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+  curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+  curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+  curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &size);
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+
+  bench.bytes += size;
+  if(connects) {
+    /* a reused connection has no setup times to count */
+    timer_add(&bench.timer[BENCH_DNS], namelookup);
+    timer_add(&bench.timer[BENCH_CONNECT], connect - namelookup);
+    if(appconnect)
+      timer_add(&bench.timer[BENCH_TLS], appconnect - connect);
+  }
+  timer_add(&bench.timer[BENCH_TTFB], starttransfer);
+  timer_add(&bench.timer[BENCH_TOTAL], total);
+}
+
+static const int permilles[] = { 500, 900, 990 };
+
+static void report_table(FILE *out, timediff_t ms)
+{
+  int i;
+  fprintf(out, "Transfers: %" CURL_FORMAT_CURL_OFF_T " done, %"
+          CURL_FORMAT_CURL_OFF_T " failed in %" CURL_FORMAT_CURL_OFF_T
+          ".%03" CURL_FORMAT_CURL_OFF_T " seconds, %" CURL_FORMAT_CURL_OFF_T
+          " per second\n",
+          bench.done, bench.failed, ms / 1000, ms % 1000,
+          ms ? bench.done * 1000 / ms : bench.done);
+  fprintf(out, "Received:  %" CURL_FORMAT_CURL_OFF_T " bytes, %"
+          CURL_FORMAT_CURL_OFF_T " bytes per second\n",
+          bench.bytes, ms ? bench.bytes * 1000 / ms : bench.bytes);
+  fprintf(out, "\n%-8s %8s %8s %8s %8s %8s %8s %8s\n",
+          "(ms)", "count", "min", "mean", "p50", "p90", "p99", "max");
+  for(i = 0; i < BENCH_LAST; i++) {
+    const struct benchtimer *t = &bench.timer[i];
+    size_t p;
+    fprintf(out, "%-8s %8" CURL_FORMAT_CURL_OFF_T, t->name, t->count);
+    if(!t->count) {
+      fputs("\n", out);
+      continue;
+    }
+    fprintf(out, " %8.3f %8.3f", (double)t->min / 1000.0,
+            (double)t->sum / (double)t->count / 1000.0);
+    for(p = 0; p < CURL_ARRAYSIZE(permilles); p++) {
+      curl_off_t us = timer_percentile(t, permilles[p]);
+      fprintf(out, " %8.3f", (double)us / 1000.0);
+    }
+    fprintf(out, " %8.3f\n", (double)t->max / 1000.0);
+  }
+}
+
+static void report_json(FILE *out, timediff_t ms)
+{
+  int i;
+  fprintf(out, "{\"transfers\":%" CURL_FORMAT_CURL_OFF_T
+          ",\"failed\":%" CURL_FORMAT_CURL_OFF_T
+          ",\"time_ms\":%" CURL_FORMAT_CURL_OFF_T
+          ",\"bytes\":%" CURL_FORMAT_CURL_OFF_T ",\"latency_us\":{",
+          bench.done, bench.failed, ms, bench.bytes);
+  for(i = 0; i < BENCH_LAST; i++) {
+    const struct benchtimer *t = &bench.timer[i];
+    fprintf(out, "%s\"%s\":{\"count\":%" CURL_FORMAT_CURL_OFF_T,
+            i ? "," : "", t->name, t->count);
+    if(t->count) {
+      size_t p;
+      fprintf(out, ",\"min\":%" CURL_FORMAT_CURL_OFF_T
+              ",\"mean\":%" CURL_FORMAT_CURL_OFF_T,
+              t->min, t->sum / t->count);
+      for(p = 0; p < CURL_ARRAYSIZE(permilles); p++)
+        fprintf(out, ",\"p%d\":%" CURL_FORMAT_CURL_OFF_T,
+                permilles[p] / 10, timer_percentile(t, permilles[p]));
+      fprintf(out, ",\"max\":%" CURL_FORMAT_CURL_OFF_T, t->max);
+    }
+    fputs("}", out);
+  }
+  fputs("}}", out);
+}
+
+void bench_summary(FILE *out)
+{
+  report_json(out, curlx_timediff(curlx_now(), bench.start));
+}
+
+CURLcode bench_report(void)
+{
+  timediff_t ms = curlx_timediff(curlx_now(), bench.start);
+  report_table(stdout, ms);
+  if(global->bench_json) {
+    FILE *out = stdout;
+    if(strcmp(global->bench_json, "-")) {
+      out = fopen(global->bench_json, FOPEN_WRITETEXT);
+      if(!out) {
+        errorf("cannot write '%s'", global->bench_json);
+        return CURLE_WRITE_ERROR;
+      }
+    }
+    report_json(out, ms);
+    fputs("\n", out);
+    if(out != stdout)
+      fclose(out);
+  }
+  return CURLE_OK;
+}
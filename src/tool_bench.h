@@ -0,0 +1,56 @@
+#ifndef HEADER_CURL_TOOL_BENCH_H
+#define HEADER_CURL_TOOL_BENCH_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+/*
+ * --bench repeats the transfers and reports the throughput and latency
+ * percentiles when done.
+ */
+
+void bench_init(void);
+
+/* TRUE if the request set is to be done once more */
+bool bench_next_round(void);
+
+/* TRUE when --bench is given a duration and it has passed */
+bool bench_expired(void);
+
+/* With --rate, the number of milliseconds until the next transfer may
+   start. Zero means now, and counts the transfer as started. */
+timediff_t bench_start_in(void);
+
+/* the longest time to wait for activity before starting more transfers */
+long bench_timeout(long ms);
+
+/* add the timings of a finished transfer */
+void bench_add(CURL *curl, CURLcode result);
+
+CURLcode bench_report(void);
+
+/* write the collected numbers as a JSON object, used by --metrics-file */
+void bench_summary(FILE *out);
+
+#endif /* HEADER_CURL_TOOL_BENCH_H */
@@ -27,6 +27,7 @@
 #include "tool_msgs.h"
 #include "tool_cb_dbg.h"
 #include "tool_util.h"
+#include "tool_thread.h"
 
 #include "memdebug.h" /* keep this as LAST include */
 
@@ -72,12 +73,9 @@ static void log_line_start(FILE *log, const char *timebuf,
 #define TRC_IDS_FORMAT_IDS_1  "[%" CURL_FORMAT_CURL_OFF_T "-x] "
 #define TRC_IDS_FORMAT_IDS_2  "[%" CURL_FORMAT_CURL_OFF_T "-%" \
                                    CURL_FORMAT_CURL_OFF_T "] "
-/*
-** callback for CURLOPT_DEBUGFUNCTION
-*/
-int tool_debug_cb(CURL *handle, curl_infotype type,
-                  char *data, size_t size,
-                  void *userdata)
+static int debug_cb(CURL *handle, curl_infotype type,
+                    char *data, size_t size,
+                    void *userdata)
 {
   FILE *output = tool_stderr;
   const char *text;
@@ -231,6 +229,22 @@ int tool_debug_cb(CURL *handle, curl_infotype type,
   return 0;
 }
 
+/*
+** callback for CURLOPT_DEBUGFUNCTION
+*/
+int tool_debug_cb(CURL *handle, curl_infotype type,
+                  char *data, size_t size,
+                  void *userdata)
+{
+  int rc;
+  /* the trace output and its state are shared by all transfers, which
+     may run in different threads */
+  tool_trace_lock();
+  rc = debug_cb(handle, type, data, size, userdata);
+  tool_trace_unlock();
+  return rc;
+}
+
 static void dump(const char *timebuf, const char *idsbuf, const char *text,
                  FILE *stream, const unsigned char *ptr, size_t size,
                  trace tracetype, curl_infotype infotype)
@@ -32,6 +32,8 @@
 #include "tool_msgs.h"
 #include "tool_cb_wrt.h"
 #include "tool_operate.h"
+#include "tool_segment.h"
+#include "tool_util.h"
 
 #include "memdebug.h" /* keep this as LAST include */
 
@@ -110,6 +112,194 @@ bool tool_create_output_file(struct OutStruct *outs,
   return TRUE;
 }
 
+#ifdef HAVE_PWRITE
+
+/* --direct-output writes blocks of this size, a multiple of the alignment
+   that O_DIRECT asks for */
+#define DIRECT_BUFSIZE (1024 * 1024)
+#define DIRECT_ALIGN 4096
+
+struct outdirect {
+  char *alloc;         /* the allocated memory */
+  char *buf;           /* DIRECT_ALIGN aligned, within 'alloc' */
+  size_t len;          /* amount of data in 'buf' */
+  curl_off_t offset;   /* file offset where 'buf' goes */
+  curl_off_t reserved; /* end of the preallocated space, 0 for none */
+  BIT(odirect);        /* the file is in O_DIRECT mode */
+};
+
+/* switch O_DIRECT on or off, return TRUE if done */
+static bool direct_mode(int fd, bool enable)
+{
+#ifdef O_DIRECT
+  int flags = fcntl(fd, F_GETFL);
+  if(flags == -1)
+    return FALSE;
+  if(enable)
+    flags |= O_DIRECT;
+  else
+    flags &= ~O_DIRECT;
+  return !fcntl(fd, F_SETFL, flags);
+#else
+  (void)fd;
+  (void)enable;
+  return FALSE;
+#endif
+}
+
+static bool direct_init(struct OutStruct *outs, CURL *curl, bool reserve)
+{
+  struct outdirect *d;
+  int fd = fileno(outs->stream);
+  curl_off_t offset;
+
+  /* continue where the stream is */
+  if(fflush(outs->stream))
+    return FALSE;
+  offset = lseek(fd, 0, SEEK_CUR);
+  if(offset < 0)
+    return FALSE;
+
+  d = calloc(1, sizeof(*d));
+  if(!d)
+    return FALSE;
+  d->alloc = malloc(DIRECT_BUFSIZE + DIRECT_ALIGN);
+  if(!d->alloc) {
+    free(d);
+    return FALSE;
+  }
+  d->buf = d->alloc + (DIRECT_ALIGN - 1) -
+    (((size_t)d->alloc + DIRECT_ALIGN - 1) % DIRECT_ALIGN);
+  d->offset = offset;
+
+  if(reserve) {
+    curl_off_t size = -1;
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &size);
+    if((size > 0) && tool_preallocate(fd, offset, size))
+      d->reserved = offset + size;
+  }
+  if(!(offset % DIRECT_ALIGN))
+    d->odirect = direct_mode(fd, TRUE);
+  outs->direct = d;
+  return TRUE;
+}
+
+/* write all buffered data, return TRUE on success. On failure, what could
+   not be written is left first in the buffer. */
+static bool direct_write(int fd, struct outdirect *d)
+{
+  size_t done = 0;
+  bool ok = TRUE;
+
+  while(done < d->len) {
+    ssize_t n = pwrite(fd, &d->buf[done], d->len - done,
+                       (off_t)(d->offset + done));
+    if(n < 0) {
+      /* !checksrc! disable ERRNOVAR 2 */
+      if(errno == EINTR)
+        continue;
+      if((errno == EINVAL) && d->odirect && direct_mode(fd, FALSE)) {
+        /* the file system wants another alignment, do without */
+        d->odirect = FALSE;
+        continue;
+      }
+      ok = FALSE;
+      break;
+    }
+    done += (size_t)n;
+  }
+  if(done < d->len)
+    memmove(d->buf, &d->buf[done], d->len - done);
+  d->offset += done;
+  d->len -= done;
+  return ok;
+}
+
+/* buffer the data, return the amount taken care of */
+static size_t direct_store(struct OutStruct *outs, const char *data,
+                           size_t len)
+{
+  struct outdirect *d = outs->direct;
+  size_t stored = 0;
+  size_t pending = 0; /* data of this call in the buffer, last in it */
+
+  while(stored < len) {
+    size_t n = DIRECT_BUFSIZE - d->len;
+    if(n > len - stored)
+      n = len - stored;
+    memcpy(&d->buf[d->len], &data[stored], n);
+    d->len += n;
+    stored += n;
+    pending += n;
+    if(d->len == DIRECT_BUFSIZE) {
+      if(!direct_write(fileno(outs->stream), d)) {
+        /* forget the data of this call that is not in the file, it is
+           reported as not written. Data from earlier calls stays. */
+        size_t drop = (pending < d->len) ? pending : d->len;
+        d->len -= drop;
+        return stored - drop;
+      }
+      pending = 0;
+    }
+  }
+  return len;
+}
+
+bool tool_direct_flush(struct OutStruct *outs)
+{
+  struct outdirect *d = outs->direct;
+  int fd;
+
+  if(!d || !d->len)
+    return TRUE;
+  fd = fileno(outs->stream);
+  if(d->odirect && (d->len % DIRECT_ALIGN) && direct_mode(fd, FALSE))
+    /* the unaligned tail goes through the page cache */
+    d->odirect = FALSE;
+  if(!direct_write(fd, d)) {
+    /* the data is lost, keep 'bytes' telling what is in the file */
+    outs->bytes -= d->len;
+    d->len = 0;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+void tool_direct_reset(struct OutStruct *outs, curl_off_t offset)
+{
+  struct outdirect *d = outs->direct;
+
+  if(d) {
+    d->len = 0;
+    d->offset = offset;
+    d->reserved = 0;
+    if(d->odirect && (offset % DIRECT_ALIGN) &&
+       direct_mode(fileno(outs->stream), FALSE))
+      d->odirect = FALSE;
+  }
+}
+
+bool tool_direct_close(struct OutStruct *outs)
+{
+  struct outdirect *d = outs->direct;
+  bool ok;
+
+  if(!d)
+    return TRUE;
+  ok = tool_direct_flush(outs);
+#ifdef HAVE_FTRUNCATE
+  if(ok && (d->reserved > d->offset) &&
+     ftruncate(fileno(outs->stream), (off_t)d->offset))
+    /* got less than announced, the rest of the reserved space goes */
+    ok = FALSE;
+#endif
+  free(d->alloc);
+  free(d);
+  outs->direct = NULL;
+  return ok;
+}
+#endif /* HAVE_PWRITE */
+
 #if defined(_WIN32) && !defined(UNDER_CE)
 static size_t win_console(intptr_t fhnd, struct OutStruct *outs,
                           char *buffer, size_t bytes,
@@ -308,9 +498,30 @@ size_t tool_write_cb(char *buffer, size_t sz, size_t nmemb, void *userdata)
   }
 #endif
 
+  if(per->segment_lead && !per->segment && !outs->stream) {
+    /* the response tells if the download can be split */
+    if(segment_split(&per->segment, outs, per->curl, per->url,
+                     config->segments))
+      return CURL_WRITEFUNC_ERROR;
+    if(per->segment && per->split)
+      *per->split = TRUE;
+  }
+
+  if(per->segment &&
+     !segment_write_ok(per->segment, per->curl, outs->bytes, &bytes))
+    return CURL_WRITEFUNC_ERROR;
+
   if(!outs->stream && !tool_create_output_file(outs, per->config))
     return CURL_WRITEFUNC_ERROR;
 
+#ifdef HAVE_PWRITE
+  if(config->direct_output && !outs->direct && outs->fopened &&
+     !config->show_headers && !config->resume_from)
+    /* reserve the space unless the file is written in segments, that
+       happens for the whole file at once */
+    (void)direct_init(outs, per->curl, !per->segment);
+#endif
+
   if(is_tty && (outs->bytes < 2000) && !config->terminal_binary_ok) {
     /* binary output to terminal? */
     if(memchr(buffer, 0, bytes)) {
@@ -338,7 +549,12 @@ size_t tool_write_cb(char *buffer, size_t sz, size_t nmemb, void *userdata)
       if(tool_write_headers(&per->hdrcbdata, outs->stream))
         return CURL_WRITEFUNC_ERROR;
     }
-    rc = fwrite(buffer, sz, nmemb, outs->stream);
+#ifdef HAVE_PWRITE
+    if(outs->direct)
+      rc = direct_store(outs, buffer, bytes);
+    else
+#endif
+      rc = fwrite(buffer, 1, bytes, outs->stream);
   }
 
   if(bytes == rc)
@@ -35,4 +35,17 @@ size_t tool_write_cb(char *buffer, size_t sz, size_t nmemb, void *userdata);
 bool tool_create_output_file(struct OutStruct *outs,
                              struct OperationConfig *config);
 
+#ifdef HAVE_PWRITE
+/* write out the data buffered for --direct-output, return TRUE on success */
+bool tool_direct_flush(struct OutStruct *outs);
+/* drop the buffered data and continue writing at 'offset' */
+void tool_direct_reset(struct OutStruct *outs, curl_off_t offset);
+/* flush and stop writing with --direct-output, return TRUE on success */
+bool tool_direct_close(struct OutStruct *outs);
+#else
+#define tool_direct_flush(x) TRUE
+#define tool_direct_reset(x,y) Curl_nop_stmt
+#define tool_direct_close(x) TRUE
+#endif
+
 #endif /* HEADER_CURL_TOOL_CB_WRT_H */
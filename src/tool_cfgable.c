@@ -28,6 +28,7 @@
 #include "tool_paramhlp.h"
 #include "tool_main.h"
 #include "tool_msgs.h"
+#include "tool_writeout.h"
 #include "memdebug.h" /* keep this as LAST include */
 
 static struct GlobalConfig globalconf;
@@ -71,6 +72,7 @@ static void free_config_fields(struct OperationConfig *config)
 
   curlx_dyn_free(&config->postdata);
   tool_safefree(config->query);
+  tool_safefree(config->url_stream);
   tool_safefree(config->referer);
 
   tool_safefree(config->headerfile);
@@ -160,6 +162,8 @@ static void free_config_fields(struct OperationConfig *config)
   tool_safefree(config->sasl_authzid);
   tool_safefree(config->unix_socket_path);
   tool_safefree(config->writeout);
+  writeout_free(config->writeout_ops);
+  config->writeout_ops = NULL;
   tool_safefree(config->proto_default);
 
   curl_slist_free_all(config->quote);
@@ -226,6 +230,7 @@ CURLcode globalconf_init(void)
   global->showerror = FALSE;          /* show errors when silent */
   global->styled_output = TRUE;       /* enable detection */
   global->parallel_max = PARALLEL_DEFAULT;
+  global->parallel_threads = 1;
 
   /* Allocate the initial operate config */
   global->first = global->last = config_alloc();
@@ -263,6 +268,9 @@ static void free_globalconfig(void)
   global->trace_stream = NULL;
 
   tool_safefree(global->libcurl);
+  tool_safefree(global->bench_json);
+  tool_safefree(global->metrics_file);
+  tool_safefree(global->mirror);
 #if defined(_WIN32) && !defined(UNDER_CE)
   free(global->term.buf);
 #endif
@@ -66,6 +66,15 @@ extern struct GlobalConfig *global;
 
 struct State {
   struct getout *urlnode;
+  struct getout streamnode; /* the current URL from --url-stream */
+  struct dynbuf streambuf;  /* read from the stream but not used yet */
+  struct dynbuf streamline;
+  int streamfd;             /* the stream, when 'streamopen' */
+  curl_off_t streamnum;     /* URLs read from the stream so far */
+  bool streamopen;
+  bool streamsock;          /* 'streamfd' is a socket fed by a thread */
+  bool streameof;           /* all of the stream is read */
+  bool streamwait;          /* the next line has not arrived yet */
   struct URLGlob inglob;
   struct URLGlob urlglob;
   char *httpgetfields;
@@ -123,6 +132,7 @@ struct OperationConfig {
   struct getout *url_out;   /* point to the node to fill in outfile */
   struct getout *url_ul;    /* point to the node to fill in upload */
   size_t num_urls;          /* number of URLs added to the list */
+  char *url_stream;         /* file to read more URLs from while running */
 #ifndef CURL_DISABLE_IPFS
   char *ipfs_gateway;
 #endif /* !CURL_DISABLE_IPFS */
@@ -161,6 +171,7 @@ struct OperationConfig {
   char *krblevel;
   char *request_target;
   char *writeout;           /* %-styled format string to output */
+  struct writeout *writeout_ops; /* the parsed writeout format */
   struct curl_slist *quote;
   struct curl_slist *postquote;
   struct curl_slist *prequote;
@@ -211,6 +222,7 @@ struct OperationConfig {
   long req_retry;           /* number of retries */
   long retry_delay_ms;      /* delay between retries (in milliseconds) */
   long retry_maxtime_ms;    /* maximum time to keep retrying */
+  long segments;            /* download each URL in this many parts */
 
   unsigned long mime_options; /* Mime option flags. */
   long tftp_blksize;        /* TFTP BLKSIZE option */
@@ -312,6 +324,7 @@ struct OperationConfig {
   BIT(content_disposition); /* use Content-disposition filename */
 
   BIT(xattr);               /* store metadata in extended attributes */
+  BIT(direct_output);       /* write output files with large pwrite()s */
   BIT(ssl_allow_beast);     /* allow this SSL vulnerability */
   BIT(ssl_allow_earlydata); /* allow use of TLSv1.3 early data */
   BIT(proxy_ssl_allow_beast); /* allow this SSL vulnerability for proxy */
@@ -363,10 +376,17 @@ struct GlobalConfig {
 #endif
   timediff_t ms_per_transfer;     /* start next transfer after (at least) this
                                      many milliseconds */
+  char *bench_json;               /* write the --bench report to this file */
+  curl_off_t bench_rounds;        /* --bench rounds of the transfers */
+  timediff_t bench_ms;            /* --bench duration */
+  char *metrics_file;             /* --metrics-file */
+  FILE *metrics_stream;
+  char *mirror;                   /* --mirror index file */
   trace tracetype;
   int progressmode;               /* CURL_PROGRESS_BAR / CURL_PROGRESS_STATS */
   unsigned short parallel_host; /* MAX_PARALLEL_HOST is the maximum */
   unsigned short parallel_max; /* MAX_PARALLEL is the maximum */
+  unsigned short parallel_threads; /* MAX_PARALLEL_THREADS is the maximum */
   unsigned char verbosity;        /* How verbose we should be */
 #ifdef DEBUGBUILD
   BIT(test_duphandle);
@@ -374,6 +394,7 @@ struct GlobalConfig {
 #endif
   BIT(parallel);
   BIT(parallel_connect);
+  BIT(parallel_adaptive);         /* adjust the concurrency per host */
   BIT(fail_early);                /* exit on first transfer error */
   BIT(styled_output);             /* enable fancy output style detection */
   BIT(trace_fopened);
@@ -384,6 +405,7 @@ struct GlobalConfig {
   BIT(noprogress);                /* do not show progress bar */
   BIT(isatty);                    /* Updated internally if output is a tty */
   BIT(trace_set);                 /* --trace-config has been used */
+  BIT(bench);                     /* --bench is used */
 };
 
 struct OperationConfig *config_alloc(void);
@@ -90,6 +90,8 @@ static const struct LongShort aliases[]= {
   {"append",                     ARG_BOOL, 'a', C_APPEND},
   {"aws-sigv4",                  ARG_STRG, ' ', C_AWS_SIGV4},
   {"basic",                      ARG_BOOL, ' ', C_BASIC},
+  {"bench",                      ARG_STRG, ' ', C_BENCH},
+  {"bench-json",                 ARG_FILE, ' ', C_BENCH_JSON},
   {"buffer",                     ARG_BOOL|ARG_NO, 'N', C_BUFFER},
   {"ca-native",                  ARG_BOOL|ARG_TLS, ' ', C_CA_NATIVE},
   {"cacert",                     ARG_FILE|ARG_TLS, ' ', C_CACERT},
@@ -119,6 +121,7 @@ static const struct LongShort aliases[]= {
   {"data-urlencode",             ARG_STRG, ' ', C_DATA_URLENCODE},
   {"delegation",                 ARG_STRG, ' ', C_DELEGATION},
   {"digest",                     ARG_BOOL, ' ', C_DIGEST},
+  {"direct-output",              ARG_BOOL, ' ', C_DIRECT_OUTPUT},
   {"disable",                    ARG_BOOL, 'q', C_DISABLE},
   {"disable-eprt",               ARG_BOOL, ' ', C_DISABLE_EPRT},
   {"disable-epsv",               ARG_BOOL, ' ', C_DISABLE_EPSV},
@@ -214,6 +217,8 @@ static const struct LongShort aliases[]= {
   {"max-redirs",                 ARG_STRG, ' ', C_MAX_REDIRS},
   {"max-time",                   ARG_STRG, 'm', C_MAX_TIME},
   {"metalink",                   ARG_BOOL|ARG_DEPR, ' ', C_METALINK},
+  {"metrics-file",               ARG_FILE, ' ', C_METRICS_FILE},
+  {"mirror",                     ARG_FILE, ' ', C_MIRROR},
   {"mptcp",                      ARG_BOOL, ' ', C_MPTCP},
   {"negotiate",                  ARG_BOOL, ' ', C_NEGOTIATE},
   {"netrc",                      ARG_BOOL, 'n', C_NETRC},
@@ -229,9 +234,11 @@ static const struct LongShort aliases[]= {
   {"output",                     ARG_FILE, 'o', C_OUTPUT},
   {"output-dir",                 ARG_STRG, ' ', C_OUTPUT_DIR},
   {"parallel",                   ARG_BOOL, 'Z', C_PARALLEL},
+  {"parallel-adaptive",          ARG_BOOL, ' ', C_PARALLEL_ADAPTIVE},
   {"parallel-immediate",         ARG_BOOL, ' ', C_PARALLEL_IMMEDIATE},
   {"parallel-max",               ARG_STRG, ' ', C_PARALLEL_MAX},
   {"parallel-max-host",          ARG_STRG, ' ', C_PARALLEL_HOST},
+  {"parallel-threads",           ARG_STRG, ' ', C_PARALLEL_THREADS},
   {"pass",                       ARG_STRG|ARG_CLEAR, ' ', C_PASS},
   {"path-as-is",                 ARG_BOOL, ' ', C_PATH_AS_IS},
   {"pinnedpubkey",               ARG_STRG|ARG_TLS, ' ', C_PINNEDPUBKEY},
@@ -299,6 +306,7 @@ static const struct LongShort aliases[]= {
   {"retry-max-time",             ARG_STRG, ' ', C_RETRY_MAX_TIME},
   {"sasl-authzid",               ARG_STRG, ' ', C_SASL_AUTHZID},
   {"sasl-ir",                    ARG_BOOL, ' ', C_SASL_IR},
+  {"segments",                   ARG_STRG, ' ', C_SEGMENTS},
   {"service-name",               ARG_STRG, ' ', C_SERVICE_NAME},
   {"sessionid",                  ARG_BOOL|ARG_NO, ' ', C_SESSIONID},
   {"show-error",                 ARG_BOOL, 'S', C_SHOW_ERROR},
@@ -363,6 +371,7 @@ static const struct LongShort aliases[]= {
   {"upload-flags",               ARG_STRG, ' ', C_UPLOAD_FLAGS},
   {"url",                        ARG_STRG, ' ', C_URL},
   {"url-query",                  ARG_STRG, ' ', C_URL_QUERY},
+  {"url-stream",                 ARG_FILE, ' ', C_URL_STREAM},
   {"use-ascii",                  ARG_BOOL, 'B', C_USE_ASCII},
   {"user",                       ARG_STRG|ARG_CLEAR, 'u', C_USER},
   {"user-agent",                 ARG_STRG, 'A', C_USER_AGENT},
@@ -954,6 +963,47 @@ static ParameterError set_data(cmdline_t cmd,
   return err;
 }
 
+/*
+ * --bench is given a number of rounds, or a duration when the number is
+ * followed by 's', 'm' or 'h'.
+ */
+static ParameterError set_bench(const char *nextarg)
+{
+  const char *p = nextarg;
+  curl_off_t num;
+  curl_off_t unit = 0;
+
+  if(curlx_str_number(&p, &num, CURL_OFF_T_MAX) || !num)
+    return PARAM_BAD_NUMERIC;
+  switch(*p) {
+  case 0:
+    break;
+  case 's':
+    unit = 1000;
+    break;
+  case 'm':
+    unit = 60 * 1000;
+    break;
+  case 'h':
+    unit = 60 * 60 * 1000;
+    break;
+  default:
+    errorf("unsupported --bench unit");
+    return PARAM_BAD_USE;
+  }
+  if(unit && p[1]) {
+    errorf("unsupported --bench unit");
+    return PARAM_BAD_USE;
+  }
+  if(unit && (num > CURL_OFF_T_MAX / unit))
+    return PARAM_NUMBER_TOO_LARGE;
+
+  global->bench_rounds = unit ? 0 : num;
+  global->bench_ms = unit ? num * unit : 0;
+  global->bench = TRUE;
+  return PARAM_OK;
+}
+
 static ParameterError set_rate(const char *nextarg)
 {
   /* --rate */
@@ -1845,6 +1895,9 @@ static ParameterError opt_bool(struct OperationConfig *config,
   case C_XATTR: /* --xattr */
     config->xattr = toggle;
     break;
+  case C_DIRECT_OUTPUT: /* --direct-output */
+    config->direct_output = toggle;
+    break;
   case C_FTP_SSL: /* --ftp-ssl */
   case C_SSL: /* --ssl */
     config->ftp_ssl = toggle;
@@ -2138,6 +2191,9 @@ static ParameterError opt_bool(struct OperationConfig *config,
   case C_PARALLEL: /* --parallel */
     global->parallel = toggle;
     break;
+  case C_PARALLEL_ADAPTIVE: /* --parallel-adaptive */
+    global->parallel_adaptive = toggle;
+    break;
   case C_PARALLEL_IMMEDIATE:   /* --parallel-immediate */
     global->parallel_connect = toggle;
     break;
@@ -2272,6 +2328,18 @@ static ParameterError opt_file(struct OperationConfig *config,
   case C_UPLOAD_FILE: /* --upload-file */
     err = parse_upload_file(config, nextarg);
     break;
+  case C_BENCH_JSON: /* --bench-json */
+    err = getstr(&global->bench_json, nextarg, DENY_BLANK);
+    break;
+  case C_URL_STREAM: /* --url-stream */
+    err = getstr(&config->url_stream, nextarg, DENY_BLANK);
+    break;
+  case C_METRICS_FILE: /* --metrics-file */
+    err = getstr(&global->metrics_file, nextarg, DENY_BLANK);
+    break;
+  case C_MIRROR: /* --mirror */
+    err = getstr(&global->mirror, nextarg, DENY_BLANK);
+    break;
   }
   return err;
 }
@@ -2349,6 +2417,9 @@ static ParameterError opt_string(struct OperationConfig *config,
   case C_RATE:
     err = set_rate(nextarg);
     break;
+  case C_BENCH: /* --bench */
+    err = set_bench(nextarg);
+    break;
   case C_CREATE_FILE_MODE: /* --create-file-mode */
     err = oct2nummax(&config->create_file_mode, nextarg, 0777);
     break;
@@ -2505,6 +2576,15 @@ static ParameterError opt_string(struct OperationConfig *config,
   case C_SERVICE_NAME: /* --service-name */
     err = getstr(&config->service_name, nextarg, DENY_BLANK);
     break;
+  case C_SEGMENTS: /* --segments */
+    err = str2unum(&val, nextarg);
+    if(err)
+      break;
+    if(val > MAX_SEGMENTS)
+      config->segments = MAX_SEGMENTS;
+    else
+      config->segments = val;
+    break;
   case C_PROTO_DEFAULT: /* --proto-default */
     err = getstr(&config->proto_default, nextarg, DENY_BLANK);
     if(!err)
@@ -2812,6 +2892,17 @@ static ParameterError opt_string(struct OperationConfig *config,
     else
       global->parallel_max = (unsigned short)val;
     break;
+  case C_PARALLEL_THREADS:  /* --parallel-threads */
+    err = str2unum(&val, nextarg);
+    if(err)
+      break;
+    if(val > MAX_PARALLEL_THREADS)
+      global->parallel_threads = MAX_PARALLEL_THREADS;
+    else if(val < 1)
+      global->parallel_threads = 1;
+    else
+      global->parallel_threads = (unsigned short)val;
+    break;
   case C_TIME_COND: /* --time-cond */
     err = parse_time_cond(config, nextarg);
     break;
@@ -36,6 +36,8 @@ typedef enum {
   C_APPEND,
   C_AWS_SIGV4,
   C_BASIC,
+  C_BENCH,
+  C_BENCH_JSON,
   C_BUFFER,
   C_CA_NATIVE,
   C_CACERT,
@@ -65,6 +67,7 @@ typedef enum {
   C_DATA_URLENCODE,
   C_DELEGATION,
   C_DIGEST,
+  C_DIRECT_OUTPUT,
   C_DISABLE,
   C_DISABLE_EPRT,
   C_DISABLE_EPSV,
@@ -157,6 +160,8 @@ typedef enum {
   C_MAX_REDIRS,
   C_MAX_TIME,
   C_METALINK,
+  C_METRICS_FILE,
+  C_MIRROR,
   C_MPTCP,
   C_NEGOTIATE,
   C_NETRC,
@@ -172,9 +177,11 @@ typedef enum {
   C_OUTPUT,
   C_OUTPUT_DIR,
   C_PARALLEL,
+  C_PARALLEL_ADAPTIVE,
   C_PARALLEL_HOST,
   C_PARALLEL_IMMEDIATE,
   C_PARALLEL_MAX,
+  C_PARALLEL_THREADS,
   C_PASS,
   C_PATH_AS_IS,
   C_PINNEDPUBKEY,
@@ -240,6 +247,7 @@ typedef enum {
   C_RETRY_MAX_TIME,
   C_SASL_AUTHZID,
   C_SASL_IR,
+  C_SEGMENTS,
   C_SERVICE_NAME,
   C_SESSIONID,
   C_SHOW_ERROR,
@@ -300,6 +308,7 @@ typedef enum {
   C_UPLOAD_FLAGS,
   C_URL,
   C_URL_QUERY,
+  C_URL_STREAM,
   C_USE_ASCII,
   C_USER,
   C_USER_AGENT,
@@ -51,6 +51,12 @@ const struct helptxt helptext[] = {
   {"    --basic",
    "HTTP Basic Authentication",
    CURLHELP_AUTH},
+  {"    --bench <num|time>",
+   "Repeat the transfers and report latencies",
+   CURLHELP_CURL | CURLHELP_GLOBAL},
+  {"    --bench-json <file>",
+   "Write the --bench report as JSON",
+   CURLHELP_CURL | CURLHELP_GLOBAL},
   {"    --ca-native",
    "Load CA certs from the OS",
    CURLHELP_TLS},
@@ -132,6 +138,9 @@ const struct helptxt helptext[] = {
   {"    --digest",
    "HTTP Digest Authentication",
    CURLHELP_PROXY | CURLHELP_AUTH | CURLHELP_HTTP},
+  {"    --direct-output",
+   "Write output files bypassing stdio buffers",
+   CURLHELP_OUTPUT},
   {"-q, --disable",
    "Disable .curlrc",
    CURLHELP_CURL},
@@ -393,6 +402,12 @@ const struct helptxt helptext[] = {
   {"    --metalink",
    "Process given URLs as metalink XML file",
    CURLHELP_DEPRECATED},
+  {"    --metrics-file <file>",
+   "Append per-transfer metrics as JSON lines",
+   CURLHELP_VERBOSE | CURLHELP_GLOBAL},
+  {"    --mirror <file>",
+   "Only download changed files, using an index",
+   CURLHELP_HTTP | CURLHELP_OUTPUT | CURLHELP_GLOBAL},
   {"    --mptcp",
    "Enable Multipath TCP",
    CURLHELP_CONNECTION},
@@ -457,6 +472,9 @@ const struct helptxt helptext[] = {
   {"-Z, --parallel",
    "Perform transfers in parallel",
    CURLHELP_CONNECTION | CURLHELP_CURL | CURLHELP_GLOBAL},
+  {"    --parallel-adaptive",
+   "Adjust the parallel transfers per host as it responds",
+   CURLHELP_CONNECTION | CURLHELP_CURL | CURLHELP_GLOBAL},
   {"    --parallel-immediate",
    "Do not wait for multiplexing",
    CURLHELP_CONNECTION | CURLHELP_CURL | CURLHELP_GLOBAL},
@@ -466,6 +484,9 @@ const struct helptxt helptext[] = {
   {"    --parallel-max-host <num>",
    "Maximum connections to a single host",
    CURLHELP_CONNECTION | CURLHELP_CURL | CURLHELP_GLOBAL},
+  {"    --parallel-threads <num>",
+   "Number of threads for parallel transfers",
+   CURLHELP_CONNECTION | CURLHELP_CURL | CURLHELP_GLOBAL},
   {"    --pass <phrase>",
    "Passphrase for the private key",
    CURLHELP_SSH | CURLHELP_TLS | CURLHELP_AUTH},
@@ -659,6 +680,9 @@ const struct helptxt helptext[] = {
   {"    --sasl-ir",
    "Initial response in SASL authentication",
    CURLHELP_AUTH},
+  {"    --segments <num>",
+   "Download a single URL in this many parts",
+   CURLHELP_CONNECTION | CURLHELP_CURL},
   {"    --service-name <name>",
    "SPNEGO service name",
    CURLHELP_AUTH},
@@ -829,6 +853,9 @@ const struct helptxt helptext[] = {
   {"    --url-query <data>",
    "Add a URL query part",
    CURLHELP_HTTP | CURLHELP_POST | CURLHELP_UPLOAD},
+  {"    --url-stream <file>",
+   "Read URLs from file while transferring",
+   CURLHELP_CURL},
   {"-B, --use-ascii",
    "Use ASCII/text transfer",
    CURLHELP_FTP | CURLHELP_OUTPUT | CURLHELP_LDAP},
@@ -36,4 +36,8 @@
 #define MAX_PARALLEL_HOST 65535
 #define PARALLEL_HOST_DEFAULT 0 /* means not used */
 
+#define MAX_PARALLEL_THREADS 256
+
+#define MAX_SEGMENTS 64
+
 #endif /* HEADER_CURL_TOOL_MAIN_H */
@@ -0,0 +1,411 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+#include "tool_cfgable.h"
+#include "tool_mirror.h"
+#include "tool_msgs.h"
+#include "tool_parsecfg.h"
+#include "tool_strdup.h"
+
+#include "memdebug.h" /* keep this as LAST include */
+
+/*
+ * The index is a text file with one line per downloaded URL:
+ *
+ *   URL SIZE LAST-MODIFIED ETAG PATH
+ *
+ * LAST-MODIFIED is in seconds since the epoch, -1 when not known. ETAG is a
+ * minus when there is none. PATH is the rest of the line. The lines are
+ * sorted on the URL. The file is replaced in one go when saved, so that a run
+ * that fails half-way leaves either the old or the new index around.
+ *
+ * In memory, the entries are kept in a hash table on the URL, which grows as
+ * needed to stay fast with millions of files.
+ */
+
+#define MAX_MIRROR_LINE (64*1024)
+
+struct mirror_entry {
+  struct mirror_entry *next; /* in the same bucket */
+  char *url;
+  char *etag;                /* NULL if none */
+  char *path;
+  curl_off_t lastmod;        /* -1 if not known */
+  curl_off_t size;
+};
+
+static struct {
+  struct mirror_entry **bucket;
+  size_t buckets;            /* a power of two, or zero */
+  size_t count;
+  BIT(changed);              /* needs to be saved */
+} mirror;
+
+/* FNV-1a */
+static size_t urlhash(const char *url)
+{
+  size_t h = 2166136261U;
+  while(*url) {
+    h ^= (unsigned char)*url++;
+    h *= 16777619U;
+  }
+  return h;
+}
+
+static struct mirror_entry *mirror_find(const char *url)
+{
+  struct mirror_entry *e;
+  if(!mirror.buckets)
+    return NULL;
+  for(e = mirror.bucket[urlhash(url) & (mirror.buckets - 1)]; e; e = e->next)
+    if(!strcmp(e->url, url))
+      return e;
+  return NULL;
+}
+
+static void entry_free(struct mirror_entry *e)
+{
+  free(e->url);
+  free(e->etag);
+  free(e->path);
+  free(e);
+}
+
+/* double the number of buckets */
+static CURLcode mirror_grow(void)
+{
+  size_t buckets = mirror.buckets ? mirror.buckets * 2 : 1024;
+  struct mirror_entry **bucket = calloc(buckets, sizeof(*bucket));
+  size_t i;
+  if(!bucket)
+    return CURLE_OUT_OF_MEMORY;
+  for(i = 0; i < mirror.buckets; i++) {
+    struct mirror_entry *e = mirror.bucket[i];
+    while(e) {
+      struct mirror_entry *next = e->next;
+      size_t n = urlhash(e->url) & (buckets - 1);
+      e->next = bucket[n];
+      bucket[n] = e;
+      e = next;
+    }
+  }
+  free(mirror.bucket);
+  mirror.bucket = bucket;
+  mirror.buckets = buckets;
+  return CURLE_OK;
+}
+
+/* set the data of the entry for the URL, adding it if needed */
+static CURLcode mirror_set(const char *url, const char *etag,
+                           const char *path, curl_off_t lastmod,
+                           curl_off_t size)
+{
+  struct mirror_entry *e = mirror_find(url);
+  char *etag2 = NULL;
+  char *path2 = strdup(path);
+
+  if(etag)
+    etag2 = strdup(etag);
+  if(!path2 || (etag && !etag2)) {
+    free(path2);
+    free(etag2);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  if(!e) {
+    size_t n;
+    if((mirror.count >= mirror.buckets) && mirror_grow()) {
+      free(path2);
+      free(etag2);
+      return CURLE_OUT_OF_MEMORY;
+    }
+    e = calloc(1, sizeof(*e));
+    if(e)
+      e->url = strdup(url);
+    if(!e || !e->url) {
+      free(e);
+      free(path2);
+      free(etag2);
+      return CURLE_OUT_OF_MEMORY;
+    }
+    n = urlhash(url) & (mirror.buckets - 1);
+    e->next = mirror.bucket[n];
+    mirror.bucket[n] = e;
+    mirror.count++;
+  }
+  free(e->etag);
+  free(e->path);
+  e->etag = etag2;
+  e->path = path2;
+  e->lastmod = lastmod;
+  e->size = size;
+  mirror.changed = TRUE;
+  return CURLE_OK;
+}
+
+static void mirror_remove(const char *url)
+{
+  struct mirror_entry **ep;
+  if(!mirror.buckets)
+    return;
+  for(ep = &mirror.bucket[urlhash(url) & (mirror.buckets - 1)]; *ep;
+      ep = &(*ep)->next) {
+    struct mirror_entry *e = *ep;
+    if(!strcmp(e->url, url)) {
+      *ep = e->next;
+      entry_free(e);
+      mirror.count--;
+      mirror.changed = TRUE;
+      return;
+    }
+  }
+}
+
+/* a space separated word, zero terminated in place */
+static char *word(char **linep)
+{
+  char *w = *linep;
+  char *end = strchr(w, ' ');
+  if(!end || (end == w))
+    return NULL;
+  *end = 0;
+  *linep = end + 1;
+  return w;
+}
+
+static bool number(const char *str, curl_off_t *value)
+{
+  bool negative = (*str == '-');
+  if(negative)
+    str++;
+  if(curlx_str_number(&str, value, CURL_OFF_T_MAX) || *str)
+    return FALSE;
+  if(negative)
+    *value = -*value;
+  return TRUE;
+}
+
+CURLcode mirror_load(const char *filename)
+{
+  struct dynbuf line;
+  bool error = FALSE;
+  CURLcode result = CURLE_OK;
+  FILE *file = fopen(filename, FOPEN_READTEXT);
+  if(!file)
+    /* no index yet */
+    return CURLE_OK;
+
+  curlx_dyn_init(&line, MAX_MIRROR_LINE);
+  while(!result && my_get_line(file, &line, &error)) {
+    char *p = curlx_dyn_ptr(&line);
+    char *url = word(&p);
+    char *size = url ? word(&p) : NULL;
+    char *lastmod = size ? word(&p) : NULL;
+    char *etag = lastmod ? word(&p) : NULL;
+    size_t plen = strlen(p);
+    curl_off_t s;
+    curl_off_t l;
+    if(plen && (p[plen - 1] == '\r'))
+      p[--plen] = 0;
+    if(!etag || !plen || !number(size, &s) || !number(lastmod, &l))
+      /* not a line we wrote, skip it */
+      continue;
+    result = mirror_set(url, strcmp(etag, "-") ? etag : NULL, p, l, s);
+  }
+  curlx_dyn_free(&line);
+  fclose(file);
+  if(!result && error) {
+    errorf("cannot read the mirror index '%s'", filename);
+    result = CURLE_READ_ERROR;
+  }
+  mirror.changed = FALSE;
+  return result;
+}
+
+/* move the new file in place of the old one */
+static int replace_file(const char *from, const char *to)
+{
+#ifdef _WIN32
+  return !MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING);
+#else
+  return rename(from, to);
+#endif
+}
+
+static int entrycmp(const void *p1, const void *p2)
+{
+  const struct mirror_entry *e1 = *(const struct mirror_entry * const *)p1;
+  const struct mirror_entry *e2 = *(const struct mirror_entry * const *)p2;
+  return strcmp(e1->url, e2->url);
+}
+
+CURLcode mirror_save(const char *filename)
+{
+  FILE *file;
+  char *tmp;
+  struct mirror_entry **sorted;
+  size_t n = 0;
+  size_t i;
+  bool fail = FALSE;
+
+  if(!mirror.changed)
+    return CURLE_OK;
+  sorted = malloc((mirror.count + 1) * sizeof(*sorted));
+  tmp = aprintf("%s.tmp", filename);
+  if(!sorted || !tmp) {
+    free(sorted);
+    free(tmp);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  for(i = 0; i < mirror.buckets; i++) {
+    struct mirror_entry *e;
+    for(e = mirror.bucket[i]; e; e = e->next)
+      sorted[n++] = e;
+  }
+  qsort(sorted, n, sizeof(*sorted), entrycmp);
+
+  file = fopen(tmp, FOPEN_WRITETEXT);
+  if(!file) {
+    errorf("cannot write the mirror index '%s'", tmp);
+    free(sorted);
+    free(tmp);
+    return CURLE_WRITE_ERROR;
+  }
+  fputs("# Your curl --mirror index\n"
+        "# URL SIZE LAST-MODIFIED ETAG PATH\n", file);
+  for(i = 0; (i < n) && !fail; i++) {
+    const struct mirror_entry *e = sorted[i];
+    if(strchr(e->url, ' ') || strchr(e->url, '\n') ||
+       strchr(e->path, '\n'))
+      /* cannot be read back */
+      continue;
+    if(fprintf(file, "%s %" CURL_FORMAT_CURL_OFF_T
+               " %" CURL_FORMAT_CURL_OFF_T " %s %s\n",
+               e->url, e->size, e->lastmod, e->etag ? e->etag : "-",
+               e->path) < 0)
+      fail = TRUE;
+  }
+  free(sorted);
+  if(fclose(file))
+    fail = TRUE;
+  if(fail || replace_file(tmp, filename)) {
+    errorf("cannot write the mirror index '%s'", filename);
+    unlink(tmp);
+    free(tmp);
+    return CURLE_WRITE_ERROR;
+  }
+  free(tmp);
+  mirror.changed = FALSE;
+  return CURLE_OK;
+}
+
+void mirror_cleanup(void)
+{
+  size_t i;
+  for(i = 0; i < mirror.buckets; i++) {
+    struct mirror_entry *e = mirror.bucket[i];
+    while(e) {
+      struct mirror_entry *next = e->next;
+      entry_free(e);
+      e = next;
+    }
+  }
+  free(mirror.bucket);
+  memset(&mirror, 0, sizeof(mirror));
+}
+
+CURLcode mirror_request(struct per_transfer *per, CURL *curl)
+{
+  struct OperationConfig *config = per->config;
+  const struct mirror_entry *e;
+  struct_stat fileinfo;
+
+  /* the validators are needed from every download */
+  curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
+
+  e = mirror_find(per->url);
+  if(!e || strcmp(e->path, per->outfile) ||
+     stat(per->outfile, &fileinfo) || (fileinfo.st_size != e->size))
+    /* not downloaded before, or the file is gone or changed */
+    return CURLE_OK;
+
+  if(e->etag) {
+    struct curl_slist *item;
+    char *header;
+    for(item = config->headers; item; item = item->next) {
+      struct curl_slist *list = curl_slist_append(per->mirror_headers,
+                                                  item->data);
+      if(!list)
+        return CURLE_OUT_OF_MEMORY;
+      per->mirror_headers = list;
+    }
+    header = aprintf("If-None-Match: %s", e->etag);
+    if(header) {
+      struct curl_slist *list = curl_slist_append(per->mirror_headers,
+                                                  header);
+      free(header);
+      if(!list)
+        return CURLE_OUT_OF_MEMORY;
+      per->mirror_headers = list;
+    }
+    else
+      return CURLE_OUT_OF_MEMORY;
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, per->mirror_headers);
+    per->mirror_cond = TRUE;
+  }
+  if((e->lastmod >= 0) && (config->timecond == CURL_TIMECOND_NONE)) {
+    curl_easy_setopt(curl, CURLOPT_TIMECONDITION,
+                     (long)CURL_TIMECOND_IFMODSINCE);
+    curl_easy_setopt(curl, CURLOPT_TIMEVALUE_LARGE, e->lastmod);
+    per->mirror_cond = TRUE;
+  }
+  return CURLE_OK;
+}
+
+CURLcode mirror_done(struct per_transfer *per, CURL *curl)
+{
+  struct OutStruct *outs = &per->outs;
+  struct curl_header *header;
+  const char *etag = NULL;
+  curl_off_t filetime = -1;
+  long code = 0;
+
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+  if((code == 304) || (code < 200) || (code >= 300))
+    /* not modified, or nothing new to know */
+    return CURLE_OK;
+
+  if(CURLHE_OK == curl_easy_header(curl, "ETag", 0, CURLH_HEADER, -1,
+                                   &header) &&
+     header->value[0] && !strchr(header->value, ' '))
+    etag = header->value;
+  curl_easy_getinfo(curl, CURLINFO_FILETIME_T, &filetime);
+  if(!etag && (filetime < 0)) {
+    /* nothing to make the next request conditional with */
+    mirror_remove(per->url);
+    return CURLE_OK;
+  }
+  return mirror_set(per->url, etag, per->outfile, filetime,
+                    outs->init + outs->bytes);
+}
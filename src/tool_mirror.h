@@ -0,0 +1,44 @@
+#ifndef HEADER_CURL_TOOL_MIRROR_H
+#define HEADER_CURL_TOOL_MIRROR_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+#include "tool_operate.h"
+
+/*
+ * --mirror keeps an index of the validators of the downloaded files and
+ * makes the next download of the same URL conditional.
+ */
+
+CURLcode mirror_load(const char *filename);
+CURLcode mirror_save(const char *filename);
+void mirror_cleanup(void);
+
+/* make the request conditional if the file is known and still intact */
+CURLcode mirror_request(struct per_transfer *per, CURL *curl);
+
+/* record the validators of a finished transfer */
+CURLcode mirror_done(struct per_transfer *per, CURL *curl);
+
+#endif /* HEADER_CURL_TOOL_MIRROR_H */
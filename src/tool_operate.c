@@ -55,6 +55,8 @@
 #endif
 
 #include "tool_cfgable.h"
+#include "tool_adapt.h"
+#include "tool_bench.h"
 #include "tool_cb_dbg.h"
 #include "tool_cb_hdr.h"
 #include "tool_cb_prg.h"
@@ -71,6 +73,7 @@
 #include "tool_findfile.h"
 #include "tool_libinfo.h"
 #include "tool_main.h"
+#include "tool_mirror.h"
 #include "tool_msgs.h"
 #include "tool_operate.h"
 #include "tool_operhlp.h"
@@ -78,6 +81,7 @@
 #include "tool_parsecfg.h"
 #include "tool_setopt.h"
 #include "tool_ssls.h"
+#include "tool_strdup.h"
 #include "tool_urlglob.h"
 #include "tool_util.h"
 #include "tool_writeout.h"
@@ -86,6 +90,8 @@
 #include "tool_help.h"
 #include "tool_hugehelp.h"
 #include "tool_progress.h"
+#include "tool_segment.h"
+#include "tool_thread.h"
 #include "tool_ipfs.h"
 #include "config2setopts.h"
 
@@ -203,14 +209,10 @@ static curl_off_t VmsSpecialSize(const char *name,
 struct per_transfer *transfers; /* first node */
 static struct per_transfer *transfersl; /* last node */
 
-/* add_per_transfer creates a new 'per_transfer' node in the linked
-   list of transfers */
-static CURLcode add_per_transfer(struct per_transfer **per)
+/* link_per_transfer appends the 'per_transfer' node to the linked list of
+   transfers */
+static void link_per_transfer(struct per_transfer *p)
 {
-  struct per_transfer *p;
-  p = calloc(1, sizeof(struct per_transfer));
-  if(!p)
-    return CURLE_OUT_OF_MEMORY;
   if(!transfers)
     /* first entry */
     transfersl = transfers = p;
@@ -222,6 +224,17 @@ static CURLcode add_per_transfer(struct per_transfer **per)
     /* move the last node pointer to the new entry */
     transfersl = p;
   }
+}
+
+/* add_per_transfer creates a new 'per_transfer' node in the linked
+   list of transfers */
+static CURLcode add_per_transfer(struct per_transfer **per)
+{
+  struct per_transfer *p;
+  p = calloc(1, sizeof(struct per_transfer));
+  if(!p)
+    return CURLE_OUT_OF_MEMORY;
+  link_per_transfer(p);
   *per = p;
 
   return CURLE_OK;
@@ -330,6 +343,256 @@ static CURLcode pre_transfer(struct per_transfer *per)
   return result;
 }
 
+/* the longest line accepted in a --url-stream file */
+#define MAX_URLSTREAM_LINE (100*1024)
+
+#if defined(_WIN32) && !defined(CURL_WINDOWS_UWP) && !defined(UNDER_CE)
+#define URLSTREAM_SOCKET
+#endif
+
+static void urlstream_close(struct State *state)
+{
+  if(state->streamopen) {
+#ifdef URLSTREAM_SOCKET
+    if(state->streamsock)
+      sclose((curl_socket_t)state->streamfd);
+    else
+#endif
+    if(state->streamfd != STDIN_FILENO)
+      close(state->streamfd);
+    else if(global->parallel)
+      /* leave stdin blocking again */
+      (void)curlx_nonblock((curl_socket_t)state->streamfd, FALSE);
+    state->streamopen = FALSE;
+    state->streamsock = FALSE;
+    state->streameof = FALSE;
+    curlx_dyn_free(&state->streambuf);
+    curlx_dyn_free(&state->streamline);
+  }
+  state->streamwait = FALSE;
+  tool_safefree(state->streamnode.url);
+  tool_safefree(state->streamnode.outfile);
+  if(state->urlnode == &state->streamnode)
+    state->urlnode = NULL;
+}
+
+/*
+ * Open the --url-stream file. With --parallel it is read without blocking,
+ * so that the transfers keep going while the next line has not arrived.
+ */
+static CURLcode urlstream_open(struct OperationConfig *config,
+                               struct State *state)
+{
+  int fd;
+
+  if(!strcmp(config->url_stream, "-")) {
+    fd = STDIN_FILENO;
+    CURLX_SET_BINMODE(stdin);
+#ifdef URLSTREAM_SOCKET
+    if(global->parallel) {
+      /* non-blocking stdin behavior on Windows is challenging, have a
+         thread read it and write it to a socket */
+      curl_socket_t f = win32_stdin_read_thread();
+      if((f != CURL_SOCKET_BAD) && (f <= INT_MAX)) {
+        fd = (int)f;
+        state->streamsock = TRUE;
+      }
+      else if(f != CURL_SOCKET_BAD)
+        sclose(f);
+    }
+#endif
+  }
+  else
+    fd = open(config->url_stream, O_RDONLY | CURL_O_BINARY);
+  if(fd < 0) {
+    errorf("cannot read URLs from '%s'", config->url_stream);
+    return CURLE_READ_ERROR;
+  }
+  if(global->parallel && curlx_nonblock((curl_socket_t)fd, TRUE) < 0)
+    warnf("fcntl failed on fd=%d: %s", fd, strerror(errno));
+  state->streamfd = fd;
+  state->streamopen = TRUE;
+  curlx_dyn_init(&state->streambuf, MAX_URLSTREAM_LINE * 2);
+  curlx_dyn_init(&state->streamline, MAX_URLSTREAM_LINE);
+  return CURLE_OK;
+}
+
+/* Read more of the --url-stream file. CURLE_AGAIN means that nothing has
+   arrived yet. */
+static CURLcode urlstream_fill(struct State *state)
+{
+  char buffer[4096];
+  ssize_t nread;
+
+#ifdef URLSTREAM_SOCKET
+  if(state->streamsock) {
+    nread = recv((curl_socket_t)state->streamfd, buffer, sizeof(buffer), 0);
+    if((nread < 0) && (SOCKERRNO == SOCKEWOULDBLOCK))
+      return CURLE_AGAIN;
+  }
+  else
+#endif
+  {
+    nread = read(state->streamfd, buffer, sizeof(buffer));
+    if((nread < 0) && (errno == EAGAIN))
+      return CURLE_AGAIN;
+  }
+  if(nread < 0)
+    return CURLE_READ_ERROR;
+  if(!nread)
+    state->streameof = TRUE;
+  else if(curlx_dyn_addn(&state->streambuf, buffer, (size_t)nread))
+    return CURLE_OUT_OF_MEMORY;
+  return CURLE_OK;
+}
+
+/* Get the next line of the --url-stream file that is not empty or a
+   comment into 'streamline'. Sets '*gotp' FALSE at the end of the file. */
+static CURLcode urlstream_line(struct State *state, bool *gotp)
+{
+  *gotp = FALSE;
+  for(;;) {
+    const char *buf = curlx_dyn_ptr(&state->streambuf);
+    size_t len = curlx_dyn_len(&state->streambuf);
+    const char *nl = len ? memchr(buf, '\n', len) : NULL;
+    CURLcode result;
+
+    if(nl || (state->streameof && len)) {
+      size_t linelen = nl ? (size_t)(nl - buf) : len;
+      const char *line;
+
+      curlx_dyn_reset(&state->streamline);
+      while(linelen && ISSPACE(buf[linelen - 1]))
+        linelen--;
+      if(linelen &&
+         curlx_dyn_addn(&state->streamline, buf, linelen))
+        return CURLE_READ_ERROR; /* too long */
+      result = curlx_dyn_tail(&state->streambuf,
+                              nl ? (size_t)(&buf[len] - nl - 1) : 0);
+      if(result)
+        return result;
+      line = curlx_dyn_ptr(&state->streamline);
+      if(!line)
+        continue; /* empty */
+      while(ISBLANK(*line))
+        line++;
+      /* a line with # in the first non-blank column is a comment */
+      if(*line && (*line != '#')) {
+        *gotp = TRUE;
+        return CURLE_OK;
+      }
+      continue;
+    }
+    if(state->streameof)
+      return CURLE_OK;
+    if(len >= MAX_URLSTREAM_LINE)
+      return CURLE_READ_ERROR; /* too long */
+    result = urlstream_fill(state);
+    if(result)
+      return result;
+  }
+}
+
+/* Continue with the URLs from --url-stream, if there is one */
+static void urlstream_start(struct OperationConfig *config,
+                            struct State *state)
+{
+  struct getout *node = &state->streamnode;
+
+  tool_safefree(node->url);
+  tool_safefree(node->outfile);
+  node->outset = FALSE;
+  node->useremote = FALSE;
+  state->urlnode = config->url_stream ? node : NULL;
+}
+
+/*
+ * Give 'node' the URL of the next line of the --url-stream file. A line
+ * holds a URL, optionally followed by the name of the file to save it in.
+ * That name is used unless the node already has output options. Leaves the
+ * URL NULL when there are no more, returns CURLE_AGAIN when the next line
+ * has not arrived yet.
+ */
+static CURLcode urlstream_next(struct OperationConfig *config,
+                               struct State *state, struct getout *node)
+{
+  const char *line;
+  const char *end;
+  size_t len;
+  bool got = FALSE;
+  CURLcode result;
+
+  if(!config->url_stream)
+    return CURLE_OK;
+
+  if(!state->streamopen) {
+    if(state->streamnum)
+      return CURLE_OK; /* already read to the end */
+    result = urlstream_open(config, state);
+    if(result)
+      return result;
+  }
+
+  result = urlstream_line(state, &got);
+  if(result == CURLE_AGAIN)
+    return result;
+  if(result || !got) {
+    urlstream_close(state);
+    /* make sure it is not opened again */
+    state->streamnum++;
+    if(result) {
+      errorf("cannot read URLs from '%s'", config->url_stream);
+      return CURLE_READ_ERROR;
+    }
+    return CURLE_OK;
+  }
+
+  line = curlx_dyn_ptr(&state->streamline);
+  while(ISBLANK(*line))
+    line++;
+  end = line;
+  while(*end && !ISSPACE(*end))
+    end++;
+  node->url = memdup0(line, end - line);
+  if(!node->url)
+    return CURLE_OUT_OF_MEMORY;
+  node->urlset = TRUE;
+  node->noglob = TRUE;
+  node->num = (curl_off_t)config->num_urls + state->streamnum++;
+
+  if(!node->outset) {
+    /* the rest of the line is the output filename */
+    line = end;
+    while(ISSPACE(*line))
+      line++;
+    len = strlen(line);
+    if(len) {
+      node->outfile = memdup0(line, len);
+      if(!node->outfile)
+        return CURLE_OUT_OF_MEMORY;
+    }
+    node->outset = !!len;
+    node->useremote = !len;
+  }
+  return CURLE_OK;
+}
+
+/* The --url-stream descriptor to wait for when the next line has not
+   arrived yet, CURL_SOCKET_BAD if there is none */
+static curl_socket_t urlstream_waitfd(void)
+{
+  struct State *state = &global->state;
+
+  if(!state->streamwait)
+    return CURL_SOCKET_BAD;
+#ifdef _WIN32
+  /* only sockets can be waited for */
+  if(!state->streamsock)
+    return CURL_SOCKET_BAD;
+#endif
+  return (curl_socket_t)state->streamfd;
+}
+
 void single_transfer_cleanup(void)
 {
   struct State *state = &global->state;
@@ -338,6 +601,8 @@ void single_transfer_cleanup(void)
   tool_safefree(state->uploadfile);
   /* Free list of globbed upload files */
   glob_cleanup(&state->inglob);
+  urlstream_close(state);
+  state->streamnum = 0;
 }
 
 static CURLcode retrycheck(struct OperationConfig *config,
@@ -479,7 +744,10 @@ static CURLcode retrycheck(struct OperationConfig *config,
         per->retry_sleep = RETRY_SLEEP_MAX;
     }
 
-    if(outs->bytes && outs->filename && outs->stream) {
+    if(per->segment)
+      /* keep what the segment got so far and ask for the rest */
+      segment_retry(per->segment, outs, curl);
+    else if(outs->bytes && outs->filename && outs->stream) {
 #ifndef __MINGW32CE__
       struct_stat fileinfo;
 
@@ -493,6 +761,7 @@ static CURLcode retrycheck(struct OperationConfig *config,
       {
         int rc;
         /* We have written data to an output file, we truncate file */
+        tool_direct_reset(outs, outs->init);
         fflush(outs->stream);
         notef("Throwing away %"  CURL_FORMAT_CURL_OFF_T " bytes",
               outs->bytes);
@@ -570,6 +839,10 @@ static CURLcode post_per_transfer(struct per_transfer *per,
   if(per->skip)
     goto skip;
 
+  if(per->segment && segment_stopped(per->segment, outs->bytes, result))
+    /* it got its segment, the rest of the response was not wanted */
+    result = CURLE_OK;
+
 #ifdef __VMS
   if(is_vms_shell()) {
     /* VMS DCL shell behavior */
@@ -614,6 +887,12 @@ static CURLcode post_per_transfer(struct per_transfer *per,
     /* do not create (or even overwrite) the file in case we get no
        data because of unmet condition */
     curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &cond_unmet);
+    if(!cond_unmet && per->mirror_cond) {
+      /* a --mirror ETag match leaves the file alone as well */
+      long code = 0;
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+      cond_unmet = (code == 304);
+    }
     if(!cond_unmet && !tool_create_output_file(outs, config))
       result = CURLE_WRITE_ERROR;
   }
@@ -645,6 +924,13 @@ static CURLcode post_per_transfer(struct per_transfer *per,
       return CURLE_OK; /* retry! */
   }
 
+  if(global->bench || global->metrics_stream)
+    bench_add(curl, result);
+  if(global->metrics_stream)
+    metrics_write(per, result);
+  if(global->mirror && !result && outs->filename && !per->segment)
+    result = mirror_done(per, curl);
+
   if((global->progressmode == CURL_PROGRESS_BAR) &&
      per->progressbar.calls)
     /* if the custom progress bar has been displayed, we output a
@@ -653,8 +939,9 @@ static CURLcode post_per_transfer(struct per_transfer *per,
 
   /* Close the outs file */
   if(outs->fopened && outs->stream) {
+    bool flushed = tool_direct_close(outs);
     rc = fclose(outs->stream);
-    if(!result && rc) {
+    if(!result && (rc || !flushed)) {
       /* something went wrong in the writing process */
       result = CURLE_WRITE_ERROR;
       errorf("curl: (%d) Failed writing body", result);
@@ -674,6 +961,14 @@ static CURLcode post_per_transfer(struct per_transfer *per,
     }
   }
 
+  if(per->segment) {
+    bool complete;
+    result = segment_done(per->segment, outs->bytes, result, &complete);
+    per->segment = NULL;
+    if(!complete)
+      goto skip; /* the file time is set once all segments are in */
+  }
+
   /* File time can only be set _after_ the file has been closed */
   if(!result && config->remote_time && outs->s_isreg && outs->filename) {
     /* Ask libcurl if we got a remote file time */
@@ -701,6 +996,8 @@ skip:
     tool_safefree(per->etag_save.filename);
 
   curl_easy_cleanup(per->curl);
+  curl_slist_free_all(per->mirror_headers);
+  per->mirror_headers = NULL;
   if(outs->alloc_filename)
     free(outs->filename);
   free(per->url);
@@ -1071,6 +1368,126 @@ static void check_stdin_upload(struct OperationConfig *config,
   }
 }
 
+/* Return TRUE if this transfer can be done as a segmented download */
+static bool segment_usable(struct OperationConfig *config,
+                           struct per_transfer *per)
+{
+  return (config->segments > 1) && per->outs.filename &&
+    !per->outs.out_null && !per->skip && !per->uploadfile &&
+    !config->resume_from && !config->resume_from_current &&
+    !config->range && !config->show_headers && !config->no_body &&
+    !config->content_disposition && !config->rm_partial && !global->mirror &&
+    (config->file_clobber_mode != CLOBBER_NEVER);
+}
+
+/* Add a copy of 'per' to get the segment 'seg' of the same download. The
+   copy only joins the transfers once it is ready to go, so that a failure
+   cannot leave one behind that gets the whole thing. */
+static CURLcode segment_transfer(struct per_transfer *per, CURLSH *share,
+                                 struct segment *seg)
+{
+  struct OperationConfig *config = per->config;
+  struct per_transfer *clone;
+  CURLcode result = CURLE_OUT_OF_MEMORY;
+
+  clone = calloc(1, sizeof(*clone));
+  if(!clone)
+    return CURLE_OUT_OF_MEMORY;
+  clone->config = config;
+  clone->curl = curl_easy_init();
+  clone->urlnum = per->urlnum;
+  clone->noprogress = per->noprogress;
+  clone->infd = STDIN_FILENO;
+  clone->url = strdup(per->url);
+  clone->outfile = strdup(per->outfile);
+  if(clone->curl && clone->url && clone->outfile) {
+    clone->outs.filename = clone->outfile;
+    clone->outs.s_isreg = TRUE;
+    /* headers only go to a --dump-header file, which the first transfer
+       writes */
+    clone->hdrcbdata.outs = &clone->outs;
+    clone->hdrcbdata.heads = &clone->heads;
+    clone->hdrcbdata.etag_save = &clone->etag_save;
+    clone->hdrcbdata.config = config;
+
+    result = config2setopts(config, clone, clone->curl, share);
+    if(!result)
+      result = segment_start(seg, &clone->outs, clone->curl);
+  }
+  if(result) {
+    curl_easy_cleanup(clone->curl);
+    free(clone->url);
+    free(clone->outfile);
+    free(clone);
+    return result;
+  }
+
+  clone->segment = seg;
+  clone->retry_sleep_default = config->retry_delay_ms;
+  clone->retry_remaining = config->req_retry;
+  clone->retry_sleep = clone->retry_sleep_default; /* ms */
+  clone->retrystart = curlx_now();
+  link_per_transfer(clone);
+  return CURLE_OK;
+}
+
+/* Resume the segmented download of 'per' when there is one to pick up.
+   'per' gets the first segment still missing, new transfers are added for
+   the others. Otherwise 'per' asks for all of it as a range and the
+   response tells how to split it. */
+static CURLcode segments_create(struct per_transfer *per, CURLSH *share)
+{
+  struct segdl *dl;
+  CURLcode result;
+  unsigned int i;
+
+  result = segment_resume(&dl, per->outfile, per->config->segments);
+  if(result)
+    return result;
+  if(!dl) {
+    per->segment_lead = TRUE;
+    (void)curl_easy_setopt(per->curl, CURLOPT_RANGE, "0-");
+    return CURLE_OK;
+  }
+
+  for(i = 0; !result && (i < dl->count); i++) {
+    struct segment *seg = &dl->seg[i];
+
+    if(segment_complete(seg))
+      continue;
+    if(per->segment)
+      result = segment_transfer(per, share, seg);
+    else {
+      result = segment_start(seg, &per->outs, per->curl);
+      if(!result)
+        per->segment = seg;
+      else
+        /* without its range it would get all of it */
+        per->skip = TRUE;
+    }
+  }
+  if(!dl->pending)
+    segment_free(dl);
+  return result;
+}
+
+/* Add transfers for the other segments once the response for 'per' split
+   the download */
+static CURLcode segments_add(struct per_transfer *per, CURLSH *share)
+{
+  CURLcode result = CURLE_OK;
+  struct segdl *dl;
+  unsigned int i;
+
+  if(!per->segment_lead || !per->segment)
+    return CURLE_OK;
+  per->segment_lead = FALSE;
+  dl = per->segment->dl;
+  for(i = 1; !result && (i < dl->count); i++)
+    result = segment_transfer(per, share, &dl->seg[i]);
+  return result;
+}
+
 /* create the next (singular) transfer */
 static CURLcode single_transfer(struct OperationConfig *config,
                                 CURLSH *share, bool *added, bool *skipped)
@@ -1102,10 +1519,14 @@ static CURLcode single_transfer(struct OperationConfig *config,
   if(result)
     return result;
 
+  state->streamwait = FALSE;
   if(!state->urlnode) {
     /* first time caller, setup things */
     state->urlnode = config->url_list;
     state->upnum = 1;
+    if(!state->urlnode)
+      /* only URLs from --url-stream */
+      urlstream_start(config, state);
   }
 
   while(state->urlnode) {
@@ -1119,9 +1540,22 @@ static CURLcode single_transfer(struct OperationConfig *config,
     FILE *err = (!global->silent || global->showerror) ? tool_stderr : NULL;
 
     if(!u->url) {
-      /* This node has no URL. End of the road. */
-      warnf("Got more output options than URLs");
-      break;
+      /* a node without URL, as from output options, gets the next one from
+         --url-stream */
+      result = urlstream_next(config, state, u);
+      if(result == CURLE_AGAIN) {
+        /* come back once it has arrived */
+        state->streamwait = TRUE;
+        return CURLE_OK;
+      }
+      if(result)
+        return result;
+      if(!u->url) {
+        /* This node has no URL. End of the road. */
+        if(u != &state->streamnode)
+          warnf("Got more output options than URLs");
+        break;
+      }
     }
     if(u->infile) {
       if(!config->globoff && !glob_inuse(&state->inglob))
@@ -1130,9 +1564,17 @@ static CURLcode single_transfer(struct OperationConfig *config,
         if(glob_inuse(&state->inglob))
           result = glob_next_url(&state->uploadfile, &state->inglob);
         else if(!state->upidx) {
-          /* copy the allocated string */
-          state->uploadfile = u->infile;
-          u->infile = NULL;
+          if(global->bench) {
+            /* the next round uploads it again */
+            state->uploadfile = strdup(u->infile);
+            if(!state->uploadfile)
+              return CURLE_OUT_OF_MEMORY;
+          }
+          else {
+            /* copy the allocated string */
+            state->uploadfile = u->infile;
+            u->infile = NULL;
+          }
         }
       }
       if(result)
@@ -1145,6 +1587,9 @@ static CURLcode single_transfer(struct OperationConfig *config,
       glob_cleanup(&state->inglob);
       state->upidx = 0;
       state->urlnode = u->next; /* next node */
+      if(!state->urlnode)
+        /* continue with the URLs from --url-stream, if any */
+        urlstream_start(config, state);
       continue;
     }
 
@@ -1244,7 +1689,8 @@ static CURLcode single_transfer(struct OperationConfig *config,
         return CURLE_OUT_OF_MEMORY;
     }
 
-    outs->out_null = u->out_null;
+    /* --bench throws away the received data */
+    outs->out_null = u->out_null || global->bench;
     if(!outs->out_null &&
        (u->useremote || (per->outfile && strcmp("-", per->outfile)))) {
       result = setup_outfile(config, per, outs, skipped);
@@ -1311,12 +1757,24 @@ static CURLcode single_transfer(struct OperationConfig *config,
     if(result)
       return result;
 
+    if(global->mirror && outs->filename && !per->skip) {
+      result = mirror_request(per, curl);
+      if(result)
+        return result;
+    }
+
     /* initialize retry vars for loop below */
     per->retry_sleep_default = config->retry_delay_ms;
     per->retry_remaining = config->req_retry;
     per->retry_sleep = per->retry_sleep_default; /* ms */
     per->retrystart = curlx_now();
 
+    if(segment_usable(config, per)) {
+      result = segments_create(per, share);
+      if(result)
+        return result;
+    }
+
     state->urlidx++;
     /* Here's looping around each globbed URL */
     if(state->urlidx >= state->urlnum) {
@@ -1333,22 +1791,110 @@ static CURLcode single_transfer(struct OperationConfig *config,
 
 static long all_added; /* number of easy handles currently added */
 
+struct parastate {
+  CURLM *multi;
+  CURLSH *share;
+  CURLMcode mcode;
+  CURLcode result;
+  int still_running;
+  struct curltime start;
+  bool more_transfers;
+  bool added_transfers;
+  /* segments_split is set TRUE when a transfer split its download */
+  bool segments_split;
+  /* urlready is set TRUE when more of --url-stream arrived */
+  bool urlready;
+  /* wrapitup is set TRUE after a critical error occurs to end all transfers */
+  bool wrapitup;
+  /* wrapitup_processed is set TRUE after the per transfer abort flag is set */
+  bool wrapitup_processed;
+  time_t tick;
+  struct parastate *all; /* the states of all threads, or just this one */
+  unsigned short nstates; /* number of states in 'all' */
+  long max;   /* the most transfers to have added to this multi */
+  long added; /* number of transfers currently added to this multi */
+  curl_off_t xfers_added;   /* the multi's transfer counters, for the */
+  curl_off_t xfers_running; /* progress meter */
+#ifdef TOOL_THREADS
+  tool_mutex_t *lock; /* protects all tool state when running in threads */
+  struct tool_thread thread;
+#endif
+};
+
+#ifdef TOOL_THREADS
+#define PARA_LOCK(s)                            \
+  do {                                          \
+    if((s)->lock)                               \
+      tool_mutex_lock((s)->lock);               \
+  } while(0)
+#define PARA_UNLOCK(s)                          \
+  do {                                          \
+    if((s)->lock)                               \
+      tool_mutex_unlock((s)->lock);             \
+  } while(0)
+#else
+#define PARA_LOCK(s)   Curl_nop_stmt
+#define PARA_UNLOCK(s) Curl_nop_stmt
+#endif
+
+/* TRUE if --parallel-adaptive lets this transfer start now */
+static bool adaptive_admit(struct per_transfer *per)
+{
+  if(!per->adapt) {
+    per->adapt = adapt_host(per->url, global->parallel_max);
+    if(!per->adapt)
+      return TRUE; /* out of memory, go without */
+  }
+  per->adapted = adapt_admit(per->adapt, &per->adapt_seq);
+  return per->adapted;
+}
+
+/* the admitted transfer could not be started */
+static void adaptive_cancel(struct per_transfer *per)
+{
+  if(per->adapted) {
+    adapt_cancel(per->adapt);
+    per->adapted = FALSE;
+  }
+}
+
+/* tell --parallel-adaptive how the transfer went */
+static void adaptive_done(struct per_transfer *per, CURLcode result)
+{
+  long code = 0;
+  curl_off_t pretransfer = 0;
+  curl_off_t starttransfer = 0;
+  curl_off_t latency = -1;
+
+  if(!per->adapted)
+    return;
+  curl_easy_getinfo(per->curl, CURLINFO_RESPONSE_CODE, &code);
+  curl_easy_getinfo(per->curl, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+  curl_easy_getinfo(per->curl, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+  if(starttransfer)
+    /* how long the server took to respond */
+    latency = starttransfer - pretransfer;
+  adapt_done(per->adapt, per->adapt_seq, code, result, latency);
+  per->adapted = FALSE;
+}
+
 /*
- * add_parallel_transfers() sets 'morep' to TRUE if there are more transfers
- * to add even after this call returns. sets 'addedp' to TRUE if one or more
- * transfers were added.
+ * add_parallel_transfers() sets 'more_transfers' to TRUE if there are more
+ * transfers to add even after this call returns. sets 'added_transfers' to
+ * TRUE if one or more transfers were added.
  */
-static CURLcode add_parallel_transfers(CURLM *multi, CURLSH *share,
-                                       bool *morep, bool *addedp)
+static CURLcode add_parallel_transfers(struct parastate *s)
 {
   struct per_transfer *per;
   CURLcode result = CURLE_OK;
   CURLMcode mcode;
   bool sleeping = FALSE;
   curl_off_t nxfers;
+  CURLM *multi = s->multi;
+  CURLSH *share = s->share;
 
-  *addedp = FALSE;
-  *morep = FALSE;
+  s->added_transfers = FALSE;
+  s->more_transfers = FALSE;
   mcode = curl_multi_get_offt(multi, CURLMINFO_XFERS_CURRENT, &nxfers);
   if(mcode) {
     DEBUGASSERT(0);
@@ -1358,32 +1904,51 @@ static CURLcode add_parallel_transfers(CURLM *multi, CURLSH *share,
   if(nxfers < (curl_off_t)(global->parallel_max*2)) {
     bool skipped = FALSE;
     do {
-      result = create_transfer(share, addedp, &skipped);
+      result = create_transfer(share, &s->added_transfers, &skipped);
       if(result)
         return result;
     } while(skipped);
   }
-  for(per = transfers; per && (all_added < global->parallel_max);
+  for(per = transfers;
+      per && (all_added < global->parallel_max) && (s->added < s->max);
       per = per->next) {
     if(per->added || per->skip)
       /* already added or to be skipped */
       continue;
+    if(global->bench && bench_expired()) {
+      /* the --bench time is up, do not start the queued ones */
+      per->skip = TRUE;
+      continue;
+    }
     if(per->startat && (time(NULL) < per->startat)) {
       /* this is still delaying */
       sleeping = TRUE;
       continue;
     }
+    if(global->bench && bench_start_in()) {
+      /* not yet time to start the next one for the --rate */
+      sleeping = TRUE;
+      break;
+    }
+    if(global->parallel_adaptive && !adaptive_admit(per)) {
+      /* the host has all the transfers it can take for now */
+      sleeping = TRUE;
+      continue;
+    }
     per->added = TRUE;
 
     result = pre_transfer(per);
-    if(result)
+    if(result) {
+      adaptive_cancel(per);
       return result;
+    }
 
     /* parallel connect means that we do not set PIPEWAIT since pipewait
        will make libcurl prefer multiplexing */
     (void)curl_easy_setopt(per->curl, CURLOPT_PIPEWAIT,
                            global->parallel_connect ? 0L : 1L);
     (void)curl_easy_setopt(per->curl, CURLOPT_PRIVATE, per);
+    per->split = &s->segments_split;
     /* curl does not use signals, switching this on saves some system calls */
     (void)curl_easy_setopt(per->curl, CURLOPT_NOSIGNAL, 1L);
     (void)curl_easy_setopt(per->curl, CURLOPT_XFERINFOFUNCTION, xferinfo_cb);
@@ -1398,6 +1963,7 @@ static CURLcode add_parallel_transfers(CURLM *multi, CURLSH *share,
     mcode = curl_multi_add_handle(multi, per->curl);
     if(mcode) {
       DEBUGASSERT(mcode == CURLM_OUT_OF_MEMORY);
+      adaptive_cancel(per);
       result = CURLE_OUT_OF_MEMORY;
     }
 
@@ -1416,28 +1982,13 @@ static CURLcode add_parallel_transfers(CURLM *multi, CURLSH *share,
     per->errorbuffer[0] = 0;
     per->added = TRUE;
     all_added++;
-    *addedp = TRUE;
+    s->added++;
+    s->added_transfers = TRUE;
   }
-  *morep = (per || sleeping);
+  s->more_transfers = (per || sleeping || global->state.streamwait);
   return CURLE_OK;
 }
 
-struct parastate {
-  CURLM *multi;
-  CURLSH *share;
-  CURLMcode mcode;
-  CURLcode result;
-  int still_running;
-  struct curltime start;
-  bool more_transfers;
-  bool added_transfers;
-  /* wrapitup is set TRUE after a critical error occurs to end all transfers */
-  bool wrapitup;
-  /* wrapitup_processed is set TRUE after the per transfer abort flag is set */
-  bool wrapitup_processed;
-  time_t tick;
-};
-
 #if defined(DEBUGBUILD) && defined(USE_LIBUV)
 
 #define DEBUG_UV    0
@@ -1466,9 +2017,7 @@ static void check_multi_info(struct datauv *uv)
     uv->s->result = result;
 
   if(uv->s->more_transfers) {
-    result = add_parallel_transfers(uv->s->multi, uv->s->share,
-                                    &uv->s->more_transfers,
-                                    &uv->s->added_transfers);
+    result = add_parallel_transfers(uv->s);
     if(result && !uv->s->result)
       uv->s->result = result;
     if(result)
@@ -1649,8 +2198,7 @@ static CURLcode parallel_event(struct parastate *s)
     }
 
     if(s->more_transfers) {
-      result = add_parallel_transfers(s->multi, s->share, &s->more_transfers,
-                                      &s->added_transfers);
+      result = add_parallel_transfers(s);
       if(result && !s->result)
         s->result = result;
     }
@@ -1680,13 +2228,70 @@ static CURLcode parallel_event(struct parastate *s)
 
 #endif
 
+static void parallel_progress(struct parastate *s, bool final)
+{
+  curl_off_t xfers_added = 0;
+  curl_off_t xfers_running = 0;
+  unsigned short i;
+
+  for(i = 0; i < s->nstates; i++) {
+    xfers_added += s->all[i].xfers_added;
+    xfers_running += s->all[i].xfers_running;
+  }
+  (void)progress_meter(xfers_added, xfers_running, &s->start, final);
+}
+
+/* a critical error ends the transfers in all threads */
+static void parallel_wrapitup(struct parastate *s)
+{
+  unsigned short i;
+
+  for(i = 0; i < s->nstates; i++) {
+    struct parastate *other = &s->all[i];
+    if((other != s) && !other->wrapitup) {
+      other->wrapitup = TRUE;
+      (void)curl_multi_wakeup(other->multi);
+    }
+  }
+}
+
+/* Add the transfers for the other segments of the downloads that were split
+   by transfers in this multi */
+static CURLcode parallel_segments(struct parastate *s)
+{
+  CURLcode result = CURLE_OK;
+  CURL **handles = curl_multi_get_handles(s->multi);
+  size_t i;
+
+  s->segments_split = FALSE;
+  if(!handles)
+    return CURLE_OUT_OF_MEMORY;
+  for(i = 0; !result && handles[i]; i++) {
+    struct per_transfer *per;
+    curl_easy_getinfo(handles[i], CURLINFO_PRIVATE, (void *)&per);
+    result = segments_add(per, s->share);
+  }
+  curl_free(handles);
+  return result;
+}
+
 static CURLcode check_finished(struct parastate *s)
 {
   CURLcode result = CURLE_OK;
   int rc;
   CURLMsg *msg;
   bool checkmore = FALSE;
-  progress_meter(s->multi, &s->start, FALSE);
+  (void)curl_multi_get_offt(s->multi, CURLMINFO_XFERS_ADDED,
+                            &s->xfers_added);
+  (void)curl_multi_get_offt(s->multi, CURLMINFO_XFERS_RUNNING,
+                            &s->xfers_running);
+  parallel_progress(s, FALSE);
+  if(s->segments_split) {
+    result = parallel_segments(s);
+    if(is_fatal_error(result) || (result && global->fail_early))
+      s->wrapitup = TRUE;
+    checkmore = TRUE;
+  }
   do {
     msg = curl_multi_info_read(s->multi, &rc);
     if(msg) {
@@ -1697,6 +2302,7 @@ static CURLcode check_finished(struct parastate *s)
       CURLcode tres = msg->data.result;
       curl_easy_getinfo(easy, CURLINFO_PRIVATE, (void *)&ended);
       curl_multi_remove_handle(s->multi, easy);
+      adaptive_done(ended, tres);
 
       if(ended->abort && (tres == CURLE_ABORTED_BY_CALLBACK)) {
         msnprintf(ended->errorbuffer, CURL_ERROR_SIZE,
@@ -1706,6 +2312,7 @@ static CURLcode check_finished(struct parastate *s)
       tres = post_per_transfer(ended, tres, &retry, &delay);
       progress_finalize(ended); /* before it goes away */
       all_added--; /* one fewer added */
+      s->added--;
       checkmore = TRUE;
       if(retry) {
         ended->added = FALSE; /* add it again */
@@ -1730,12 +2337,15 @@ static CURLcode check_finished(struct parastate *s)
         checkmore = TRUE;
         s->tick = tock;
       }
+      else if(global->bench && !bench_timeout(1000))
+        checkmore = TRUE;
+      else if(s->urlready)
+        checkmore = TRUE;
     }
+    s->urlready = FALSE;
     if(checkmore) {
       /* one or more transfers completed, add more! */
-      CURLcode tres = add_parallel_transfers(s->multi, s->share,
-                                             &s->more_transfers,
-                                             &s->added_transfers);
+      CURLcode tres = add_parallel_transfers(s);
       if(tres)
         result = tres;
       if(s->added_transfers)
@@ -1745,28 +2355,186 @@ static CURLcode check_finished(struct parastate *s)
     if(is_fatal_error(result) || (result && global->fail_early))
       s->wrapitup = TRUE;
   }
+  if(s->wrapitup)
+    parallel_wrapitup(s);
   return result;
 }
 
-static CURLcode parallel_transfers(CURLSH *share)
+static void parastate_init(struct parastate *s, CURLSH *share)
 {
-  CURLcode result;
-  struct parastate p;
-  struct parastate *s = &p;
+  memset(s, 0, sizeof(*s));
   s->share = share;
-  s->mcode = CURLM_OK;
-  s->result = CURLE_OK;
   s->still_running = 1;
   s->start = curlx_now();
-  s->wrapitup = FALSE;
-  s->wrapitup_processed = FALSE;
   s->tick = time(NULL);
+  s->all = s;
+  s->nstates = 1;
+  s->max = global->parallel_max;
+}
+
+/*
+ * Drive the transfers of the multi handle and keep adding more until all
+ * are done. When running in threads, this is called with the lock held and
+ * it is only released while libcurl does the transfers.
+ */
+static CURLcode parallel_loop(struct parastate *s)
+{
+  CURLcode result = CURLE_OK;
+
+  while(!s->mcode && (s->still_running || s->more_transfers)) {
+    int timeout_ms;
+    struct curl_waitfd wfd;
+    unsigned int nfds;
+    /* If stopping prematurely (eg due to a --fail-early condition) then
+       signal that any transfers in the multi should abort (via progress
+       callback). */
+    if(s->wrapitup) {
+      if(!s->still_running)
+        break;
+      if(!s->wrapitup_processed) {
+        struct per_transfer *per;
+        for(per = transfers; per; per = per->next) {
+          if(per->added)
+            per->abort = TRUE;
+        }
+        s->wrapitup_processed = TRUE;
+      }
+    }
+
+    /* wake up in time to start the next --bench transfer */
+    timeout_ms = (int)bench_timeout(1000);
+    /* and when the next --url-stream line arrives */
+    wfd.fd = urlstream_waitfd();
+    wfd.events = CURL_WAIT_POLLIN;
+    wfd.revents = 0;
+    nfds = (wfd.fd != CURL_SOCKET_BAD) ? 1 : 0;
+    PARA_UNLOCK(s);
+    s->mcode = curl_multi_poll(s->multi, nfds ? &wfd : NULL, nfds,
+                               timeout_ms, NULL);
+    if(!s->mcode)
+      s->mcode = curl_multi_perform(s->multi, &s->still_running);
+    PARA_LOCK(s);
+    if(wfd.revents)
+      s->urlready = TRUE;
+    if(!s->mcode)
+      result = check_finished(s);
+  }
+
+  /* Make sure to return some kind of error if there was a multi problem */
+  if(s->mcode) {
+    result = (s->mcode == CURLM_OUT_OF_MEMORY) ? CURLE_OUT_OF_MEMORY :
+      /* The other multi errors should never happen, so return
+         something suitably generic */
+      CURLE_BAD_FUNCTION_ARGUMENT;
+  }
+  return result;
+}
+
+#ifdef TOOL_THREADS
+static void parallel_worker(void *arg)
+{
+  struct parastate *s = arg;
+
+  PARA_LOCK(s);
+  s->result = add_parallel_transfers(s);
+  /* the other threads might have taken all transfers */
+  s->still_running = (s->added > 0);
+  if(!s->result)
+    s->result = parallel_loop(s);
+  else
+    parallel_wrapitup(s);
+  PARA_UNLOCK(s);
+}
+
+/*
+ * Run the parallel transfers in several threads, each with a multi handle of
+ * its own. The threads take turns in creating, adding and finishing
+ * transfers, protected by a common lock, while the transfers themselves are
+ * done concurrently.
+ */
+static CURLcode parallel_threaded(CURLSH *share)
+{
+  CURLcode result = CURLE_OK;
+  struct parastate *all;
+  tool_mutex_t lock;
+  unsigned short nstates = global->parallel_threads;
+  unsigned short started = 0;
+  unsigned short i;
+
+  /* there is no point in having threads without transfers */
+  if(nstates > global->parallel_max)
+    nstates = global->parallel_max;
+  all = calloc(nstates, sizeof(*all));
+  if(!all)
+    return CURLE_OUT_OF_MEMORY;
+
+  for(i = 0; i < nstates; i++) {
+    struct parastate *s = &all[i];
+    parastate_init(s, share);
+    s->start = all[0].start;
+    s->all = all;
+    s->nstates = nstates;
+    s->max = (global->parallel_max + nstates - 1) / nstates;
+    s->lock = &lock;
+    s->thread.func = parallel_worker;
+    s->thread.arg = s;
+    s->multi = curl_multi_init();
+    if(!s->multi) {
+      result = CURLE_OUT_OF_MEMORY;
+      break;
+    }
+  }
+
+  if(!result) {
+    tool_mutex_init(&lock);
+    tool_trace_locking(TRUE);
+    /* the first state is run in this thread */
+    for(started = 1; started < nstates; started++) {
+      if(!tool_thread_start(&all[started].thread)) {
+        warnf("could only start %u of %u threads", started, nstates);
+        break;
+      }
+    }
+    parallel_worker(&all[0]);
+    for(i = 1; i < started; i++)
+      tool_thread_join(&all[i].thread);
+    tool_trace_locking(FALSE);
+    tool_mutex_destroy(&lock);
+
+    for(i = 0; i < nstates; i++) {
+      if(all[i].xfers_added) {
+        parallel_progress(&all[0], TRUE);
+        break;
+      }
+    }
+    for(i = 0; !result && (i < started); i++)
+      result = all[i].result;
+  }
+
+  for(i = 0; i < nstates; i++)
+    curl_multi_cleanup(all[i].multi);
+  free(all);
+  return result;
+}
+#endif /* TOOL_THREADS */
+
+static CURLcode parallel_transfers(CURLSH *share)
+{
+  CURLcode result;
+  struct parastate p;
+  struct parastate *s = &p;
+
+#ifdef TOOL_THREADS
+  if(global->parallel_threads > 1)
+    return parallel_threaded(share);
+#endif
+
+  parastate_init(s, share);
   s->multi = curl_multi_init();
   if(!s->multi)
     return CURLE_OUT_OF_MEMORY;
 
-  result = add_parallel_transfers(s->multi, s->share,
-                                  &s->more_transfers, &s->added_transfers);
+  result = add_parallel_transfers(s);
   if(result) {
     curl_multi_cleanup(s->multi);
     return result;
@@ -1782,40 +2550,9 @@ static CURLcode parallel_transfers(CURLSH *share)
   else
 #endif
 
-  if(all_added) {
-    while(!s->mcode && (s->still_running || s->more_transfers)) {
-      /* If stopping prematurely (eg due to a --fail-early condition) then
-         signal that any transfers in the multi should abort (via progress
-         callback). */
-      if(s->wrapitup) {
-        if(!s->still_running)
-          break;
-        if(!s->wrapitup_processed) {
-          struct per_transfer *per;
-          for(per = transfers; per; per = per->next) {
-            if(per->added)
-              per->abort = TRUE;
-          }
-          s->wrapitup_processed = TRUE;
-        }
-      }
-
-      s->mcode = curl_multi_poll(s->multi, NULL, 0, 1000, NULL);
-      if(!s->mcode)
-        s->mcode = curl_multi_perform(s->multi, &s->still_running);
-      if(!s->mcode)
-        result = check_finished(s);
-    }
-
-    (void)progress_meter(s->multi, &s->start, TRUE);
-  }
-
-  /* Make sure to return some kind of error if there was a multi problem */
-  if(s->mcode) {
-    result = (s->mcode == CURLM_OUT_OF_MEMORY) ? CURLE_OUT_OF_MEMORY :
-      /* The other multi errors should never happen, so return
-         something suitably generic */
-      CURLE_BAD_FUNCTION_ARGUMENT;
+  if(all_added || s->more_transfers) {
+    result = parallel_loop(s);
+    parallel_progress(s, TRUE);
   }
 
   curl_multi_cleanup(s->multi);
@@ -1878,6 +2615,13 @@ static CURLcode serial_transfers(CURLSH *share)
         result = curl_easy_perform(per->curl);
     }
 
+    if(per->segment_lead) {
+      /* the response might have split the download */
+      CURLcode sres = segments_add(per, share);
+      if(sres)
+        result = sres;
+    }
+
     returncode = post_per_transfer(per, result, &retry, &delay_ms);
     if(retry) {
       curlx_wait_ms(delay_ms);
@@ -2024,7 +2768,7 @@ static CURLcode transfer_per_config(struct OperationConfig *config,
   *added = FALSE;
 
   /* Check we have a url */
-  if(!config->url_list || !config->url_list->url) {
+  if((!config->url_list || !config->url_list->url) && !config->url_stream) {
     helpf("(%d) no URL specified", CURLE_FAILED_INIT);
     return CURLE_FAILED_INIT;
   }
@@ -2056,7 +2800,7 @@ static CURLcode transfer_per_config(struct OperationConfig *config,
 
   if(!result) {
     result = single_transfer(config, share, added, skipped);
-    if(!*added || result)
+    if((!*added && !global->state.streamwait) || result)
       single_transfer_cleanup();
   }
 
@@ -2073,11 +2817,17 @@ static CURLcode create_transfer(CURLSH *share,
 {
   CURLcode result = CURLE_OK;
   *added = FALSE;
+  if(global->bench && bench_expired())
+    /* the --bench time is up, start no more */
+    return CURLE_OK;
   while(global->current) {
     result = transfer_per_config(global->current, share, added, skipped);
-    if(!result && !*added) {
+    if(!result && !*added && !global->state.streamwait) {
       /* when one set is drained, continue to next */
       global->current = global->current->next;
+      if(!global->current && bench_next_round())
+        /* start over with the next --bench round */
+        global->current = global->first;
       continue;
     }
     break;
@@ -2093,6 +2843,13 @@ static CURLcode run_all_transfers(CURLSH *share,
   bool orig_isatty = global->isatty;
   struct per_transfer *per;
 
+  if(global->bench || global->metrics_file)
+    bench_init();
+  if(!result && global->metrics_file)
+    result = metrics_open();
+  if(!result && global->mirror)
+    result = mirror_load(global->mirror);
+
   /* Time to actually do the transfers */
   if(!result) {
     if(global->parallel)
@@ -2116,6 +2873,21 @@ static CURLcode run_all_transfers(CURLSH *share,
     per = del_per_transfer(per);
   }
 
+  if(global->bench) {
+    CURLcode result2 = bench_report();
+    if(!result)
+      result = result2;
+  }
+  metrics_close();
+  if(global->mirror) {
+    CURLcode result2 = mirror_save(global->mirror);
+    if(!result)
+      result = result2;
+    mirror_cleanup();
+  }
+  adapt_report();
+  adapt_cleanup();
+
   /* Reset the global config variables */
   global->noprogress = orig_noprogress;
   global->isatty = orig_isatty;
@@ -2211,6 +2983,12 @@ CURLcode operate(int argc, argv_item_t argv[])
         }
 
         if(!result) {
+          if(global->parallel && (global->parallel_threads > 1) &&
+             curl_share_setopt(share, CURLSHOPT_BUILTIN_LOCKS, 1L)) {
+            warnf("no thread support, doing the parallel transfers in "
+                  "a single thread");
+            global->parallel_threads = 1;
+          }
           curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
           curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
           curl_share_setopt(share, CURLSHOPT_SHARE,
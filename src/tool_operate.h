@@ -66,6 +66,11 @@ struct per_transfer {
 
   /* NULL or malloced */
   char *uploadfile;
+  struct segment *segment; /* NULL unless a part of a segmented download */
+  bool *split; /* set TRUE to tell the parallel loop about a split download */
+  struct adapt_host *adapt; /* --parallel-adaptive state for the host */
+  curl_off_t adapt_seq;
+  struct curl_slist *mirror_headers; /* with the --mirror If-None-Match */
   char errorbuffer[CURL_ERROR_SIZE];
   BIT(infdopen); /* TRUE if infd needs closing */
   BIT(noprogress);
@@ -76,6 +81,9 @@ struct per_transfer {
                  error (eg --fail-early) has occurred in another transfer and
                  this transfer will be aborted in the progress callback */
   BIT(skip);  /* considered already done */
+  BIT(adapted); /* counted as running by --parallel-adaptive */
+  BIT(mirror_cond); /* a --mirror conditional request */
+  BIT(segment_lead); /* split into segments once the response arrives */
 };
 
 CURLcode operate(int argc, argv_item_t argv[]);
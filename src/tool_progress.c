@@ -148,7 +148,8 @@ static struct speedcount speedstore[SPEEDCNT];
   |DL% UL%  Dled  Uled  Xfers  Live Total     Current  Left    Speed
   |  6 --   9.9G     0     2     2   0:00:40  0:00:02  0:00:37 4087M
 */
-bool progress_meter(CURLM *multi,
+bool progress_meter(curl_off_t xfers_added,
+                    curl_off_t xfers_running,
                     struct curltime *start,
                     bool final)
 {
@@ -180,8 +181,6 @@ bool progress_meter(CURLM *multi,
     struct per_transfer *per;
     curl_off_t all_dlnow = 0;
     curl_off_t all_ulnow = 0;
-    curl_off_t xfers_added = 0;
-    curl_off_t xfers_running = 0;
     bool dlknown = TRUE;
     bool ulknown = TRUE;
     curl_off_t speed = 0;
@@ -271,8 +270,6 @@ bool progress_meter(CURLM *multi,
     }
     time2str(time_spent, spent);
 
-    (void)curl_multi_get_offt(multi, CURLMINFO_XFERS_ADDED, &xfers_added);
-    (void)curl_multi_get_offt(multi, CURLMINFO_XFERS_RUNNING, &xfers_running);
     fprintf(tool_stderr,
             "\r"
             "%-3s " /* percent downloaded */
@@ -31,7 +31,8 @@ int xferinfo_cb(void *clientp,
                 curl_off_t ultotal,
                 curl_off_t ulnow);
 
-bool progress_meter(CURLM *multi,
+bool progress_meter(curl_off_t xfers_added,
+                    curl_off_t xfers_running,
                     struct curltime *start,
                     bool final);
 void progress_finalize(struct per_transfer *per);
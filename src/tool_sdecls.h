@@ -57,14 +57,20 @@
  * 'init' member holds original file size or offset at which truncation is
  * taking place. Always zero unless appending to a non-empty regular file.
  *
+ * 'direct' member is non-NULL when the data is written with --direct-output,
+ * holding the data not yet written to the file.
+ *
  * [Windows]
  * 'utf8seq' member holds an incomplete UTF-8 sequence destined for the console
  * until it can be completed (1-4 bytes) + NUL.
  */
 
+struct outdirect;
+
 struct OutStruct {
   char *filename;
   FILE *stream;
+  struct outdirect *direct;
   curl_off_t bytes;
   curl_off_t init;
 #ifdef _WIN32
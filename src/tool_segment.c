@@ -0,0 +1,377 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+#include "tool_cfgable.h"
+#include "tool_cb_wrt.h"
+#include "tool_libinfo.h"
+#include "tool_msgs.h"
+#include "tool_segment.h"
+#include "tool_util.h"
+
+#include "memdebug.h" /* keep this as LAST include */
+
+#define SEGMENT_STATE_SUFFIX ".segments"
+#define SEGMENT_STATE_MAGIC "curl-segments"
+
+/* the number of segments to split 'size' bytes into */
+static unsigned int segment_count(curl_off_t size, long segments)
+{
+  if(size < segments)
+    return (size > 0) ? (unsigned int)size : 0;
+  return (unsigned int)segments;
+}
+
+/* TRUE if the response holds the bytes 'first' to 'last' of the 'size'
+   bytes of the resource */
+static bool range_ok(CURL *curl, curl_off_t first, curl_off_t last,
+                     curl_off_t size)
+{
+  struct curl_header *h;
+  char range[128];
+  CURLHcode hcode = curl_easy_header(curl, "Content-Range", 0, CURLH_HEADER,
+                                     -1, &h);
+
+  if(hcode == CURLHE_NOT_BUILT_IN)
+    return TRUE; /* the response code has to do */
+  if(hcode)
+    return FALSE;
+  msnprintf(range, sizeof(range), "bytes %" CURL_FORMAT_CURL_OFF_T
+            "-%" CURL_FORMAT_CURL_OFF_T "/%" CURL_FORMAT_CURL_OFF_T,
+            first, last, size);
+  return curl_strequal(h->value, range);
+}
+
+static struct segdl *segment_alloc(const char *filename, curl_off_t size,
+                                   unsigned int count)
+{
+  struct segdl *dl;
+  curl_off_t len = size / count;
+  unsigned int i;
+
+  dl = calloc(1, sizeof(*dl));
+  if(!dl)
+    return NULL;
+  dl->seg = calloc(count, sizeof(struct segment));
+  dl->statefile = aprintf("%s" SEGMENT_STATE_SUFFIX, filename);
+  if(!dl->seg || !dl->statefile) {
+    segment_free(dl);
+    return NULL;
+  }
+  dl->size = size;
+  dl->count = count;
+  for(i = 0; i < count; i++) {
+    struct segment *seg = &dl->seg[i];
+    seg->dl = dl;
+    seg->start = i * len;
+    seg->end = (i == count - 1) ? size - 1 : seg->start + len - 1;
+  }
+  return dl;
+}
+
+static CURLcode segment_save(struct segdl *dl)
+{
+  unsigned int i;
+  int rc;
+  FILE *file = fopen(dl->statefile, FOPEN_WRITETEXT);
+
+  if(!file) {
+    warnf("cannot write '%s'", dl->statefile);
+    return CURLE_WRITE_ERROR;
+  }
+  fprintf(file, SEGMENT_STATE_MAGIC " %" CURL_FORMAT_CURL_OFF_T " %u\n",
+          dl->size, dl->count);
+  for(i = 0; i < dl->count; i++)
+    fprintf(file, "%" CURL_FORMAT_CURL_OFF_T "\n", dl->seg[i].done);
+  rc = fclose(file);
+  if(rc) {
+    warnf("cannot write '%s'", dl->statefile);
+    return CURLE_WRITE_ERROR;
+  }
+  return CURLE_OK;
+}
+
+CURLcode segment_resume(struct segdl **dlp, const char *filename,
+                        long segments)
+{
+  char line[128];
+  const char *p = line;
+  char *statefile;
+  struct segdl *dl;
+  struct_stat fileinfo;
+  curl_off_t size;
+  curl_off_t num;
+  unsigned int i;
+  bool missing = FALSE;
+  FILE *file;
+
+  *dlp = NULL;
+  if(stat(filename, &fileinfo) || !S_ISREG(fileinfo.st_mode))
+    return CURLE_OK;
+  statefile = aprintf("%s" SEGMENT_STATE_SUFFIX, filename);
+  if(!statefile)
+    return CURLE_OUT_OF_MEMORY;
+  file = fopen(statefile, FOPEN_READTEXT);
+  free(statefile);
+  if(!file)
+    return CURLE_OK;
+
+  if(!fgets(line, sizeof(line), file) ||
+     strncmp(p, SEGMENT_STATE_MAGIC " ", sizeof(SEGMENT_STATE_MAGIC)))
+    goto out;
+  p += sizeof(SEGMENT_STATE_MAGIC);
+  if(curlx_str_number(&p, &size, CURL_OFF_T_MAX) ||
+     curlx_str_singlespace(&p) ||
+     curlx_str_number(&p, &num, UINT_MAX) || (num < 2) ||
+     (num != (curl_off_t)segment_count(size, segments)))
+    goto out;
+
+  dl = segment_alloc(filename, size, (unsigned int)num);
+  if(!dl) {
+    fclose(file);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  for(i = 0; i < dl->count; i++) {
+    struct segment *seg = &dl->seg[i];
+    p = line;
+    if(!fgets(line, sizeof(line), file) ||
+       curlx_str_number(&p, &num, seg->end - seg->start + 1)) {
+      missing = FALSE;
+      break;
+    }
+    seg->done = num;
+    if(!segment_complete(seg))
+      missing = TRUE;
+  }
+  if(missing) {
+    notef("resumes the segmented download of \"%s\"", filename);
+    *dlp = dl;
+  }
+  else
+    segment_free(dl);
+
+out:
+  fclose(file);
+  return CURLE_OK;
+}
+
+/* Open the output at the segment's offset */
+static CURLcode segment_open(struct segment *seg, struct OutStruct *outs)
+{
+  FILE *file = fopen(outs->filename, "rb+");
+
+  if(!file) {
+    errorf("cannot open '%s'", outs->filename);
+    return CURLE_WRITE_ERROR;
+  }
+  if(tool_fseek(file, seg->start + seg->done, SEEK_SET)) {
+    fclose(file);
+    errorf("cannot seek in '%s'", outs->filename);
+    return CURLE_WRITE_ERROR;
+  }
+  outs->stream = file;
+  outs->fopened = TRUE;
+  outs->s_isreg = TRUE;
+  outs->bytes = 0;
+  outs->init = seg->start + seg->done;
+  seg->dl->pending++;
+  return CURLE_OK;
+}
+
+CURLcode segment_split(struct segment **segp, struct OutStruct *outs,
+                       CURL *curl, const char *url, long segments)
+{
+  struct segdl *dl;
+  curl_off_t size = -1;
+  unsigned int count;
+  bool ranges = TRUE;
+  const char *scheme = NULL;
+  CURLcode result;
+  FILE *file;
+
+  *segp = NULL;
+  curl_easy_getinfo(curl, CURLINFO_SCHEME, &scheme);
+  scheme = proto_token(scheme);
+  curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &size);
+  if(scheme == proto_http || scheme == proto_https) {
+    long code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    ranges = (code == 206) && (size > 0) && range_ok(curl, 0, size - 1, size);
+  }
+  else if(scheme != proto_file && scheme != proto_ftp && scheme != proto_ftps)
+    ranges = FALSE;
+  if(!ranges || (size < 0)) {
+    warnf("cannot get \"%s\" in segments, the server does not tell the "
+          "size or does not support ranges", url);
+    return CURLE_OK;
+  }
+  count = segment_count(size, segments);
+  if(count < 2)
+    return CURLE_OK;
+
+  dl = segment_alloc(outs->filename, size, count);
+  if(!dl)
+    return CURLE_OUT_OF_MEMORY;
+  /* start over with an empty file */
+  file = fopen(outs->filename, "wb");
+  if(!file) {
+    errorf("cannot open '%s'", outs->filename);
+    segment_free(dl);
+    return CURLE_WRITE_ERROR;
+  }
+  /* keep the parts together on disk */
+  (void)tool_preallocate(fileno(file), 0, size);
+  fclose(file);
+  result = segment_save(dl);
+  if(!result)
+    result = segment_open(&dl->seg[0], outs);
+  if(result) {
+    segment_free(dl);
+    return result;
+  }
+  /* the rest of the response belongs to the other segments */
+  dl->seg[0].open = TRUE;
+  *segp = &dl->seg[0];
+  return CURLE_OK;
+}
+
+void segment_free(struct segdl *dl)
+{
+  if(dl) {
+    free(dl->statefile);
+    free(dl->seg);
+    free(dl);
+  }
+}
+
+bool segment_complete(const struct segment *seg)
+{
+  return seg->done == (seg->end - seg->start + 1);
+}
+
+static void segment_range(struct segment *seg, CURL *curl)
+{
+  char range[128];
+  msnprintf(range, sizeof(range),
+            "%" CURL_FORMAT_CURL_OFF_T "-%" CURL_FORMAT_CURL_OFF_T,
+            seg->start + seg->done, seg->end);
+  (void)curl_easy_setopt(curl, CURLOPT_RANGE, range);
+}
+
+CURLcode segment_start(struct segment *seg, struct OutStruct *outs,
+                       CURL *curl)
+{
+  CURLcode result = segment_open(seg, outs);
+
+  if(!result)
+    segment_range(seg, curl);
+  return result;
+}
+
+bool segment_write_ok(struct segment *seg, CURL *curl, curl_off_t stored,
+                      size_t *lenp)
+{
+  curl_off_t left = seg->end - seg->start + 1 - seg->done - stored;
+
+  if(!stored) {
+    /* the first data of this attempt, make sure it is the range we asked
+       for and not the whole thing */
+    const char *scheme = NULL;
+    curl_easy_getinfo(curl, CURLINFO_SCHEME, &scheme);
+    scheme = proto_token(scheme);
+    if(scheme == proto_http || scheme == proto_https) {
+      long code = 0;
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+      if((code != 206) ||
+         !range_ok(curl, seg->start + seg->done,
+                   seg->open ? seg->dl->size - 1 : seg->end, seg->dl->size)) {
+        errorf("the server did not send the requested range");
+        return FALSE;
+      }
+    }
+  }
+  if((curl_off_t)*lenp > left) {
+    if(!seg->open) {
+      errorf("the server sent more than the requested range");
+      return FALSE;
+    }
+    /* store what is left of the segment, the shorter write then stops the
+       transfer */
+    *lenp = (size_t)left;
+  }
+  return TRUE;
+}
+
+bool segment_stopped(const struct segment *seg, curl_off_t stored,
+                     CURLcode result)
+{
+  return (result == CURLE_WRITE_ERROR) && seg->open &&
+    (seg->done + stored == seg->end - seg->start + 1);
+}
+
+void segment_retry(struct segment *seg, struct OutStruct *outs, CURL *curl)
+{
+  if(outs->stream) {
+    /* drops what cannot be written from 'bytes' */
+    (void)tool_direct_flush(outs);
+    (void)fflush(outs->stream);
+  }
+  seg->done += outs->bytes;
+  outs->bytes = 0;
+  seg->open = FALSE;
+  segment_range(seg, curl);
+  (void)segment_save(seg->dl);
+}
+
+CURLcode segment_done(struct segment *seg, curl_off_t stored,
+                      CURLcode result, bool *completep)
+{
+  struct segdl *dl = seg->dl;
+  CURLcode result2;
+
+  *completep = FALSE;
+  seg->done += stored;
+  if(!result && !segment_complete(seg))
+    result = CURLE_PARTIAL_FILE;
+  result2 = segment_save(dl);
+  if(!result)
+    result = result2;
+
+  if(!--dl->pending) {
+    unsigned int i;
+    for(i = 0; i < dl->count; i++) {
+      if(!segment_complete(&dl->seg[i]))
+        break;
+    }
+    if(i == dl->count) {
+      *completep = TRUE;
+      unlink(dl->statefile);
+    }
+    else
+      notef("the download is incomplete, its state is kept in \"%s\"",
+            dl->statefile);
+    segment_free(dl);
+  }
+  return result;
+}
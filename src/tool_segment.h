@@ -0,0 +1,91 @@
+#ifndef HEADER_CURL_TOOL_SEGMENT_H
+#define HEADER_CURL_TOOL_SEGMENT_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+#include "tool_sdecls.h"
+
+/*
+ * A download split into byte ranges, each fetched by a transfer of its own
+ * and stored at its offset in the output file.
+ */
+
+struct segdl;
+
+struct segment {
+  struct segdl *dl;     /* the download this is a part of */
+  curl_off_t start;     /* offset of the first byte */
+  curl_off_t end;       /* offset of the last byte */
+  curl_off_t done;      /* bytes stored by earlier attempts */
+  bool open;            /* the request asked for more than the segment */
+};
+
+struct segdl {
+  char *statefile;      /* remembers the progress between runs */
+  curl_off_t size;      /* of the whole download */
+  unsigned int count;   /* number of segments */
+  unsigned int pending; /* segments with a transfer not finished yet */
+  struct segment *seg;  /* 'count' entries */
+};
+
+/* Pick up the progress of an earlier run from the state file, if there is
+   one for 'filename' that is split into as many segments as asked for.
+   Sets '*dlp' to NULL if there is nothing to resume. */
+CURLcode segment_resume(struct segdl **dlp, const char *filename,
+                        long segments);
+
+/* The first response arrived for a transfer that asked for all of 'url' as
+   a range. If the response tells the size and the server sends ranges, the
+   download is split into segments. The transfer then continues with the
+   first one, returned in '*segp'. */
+CURLcode segment_split(struct segment **segp, struct OutStruct *outs,
+                       CURL *curl, const char *url, long segments);
+void segment_free(struct segdl *dl);
+
+bool segment_complete(const struct segment *seg);
+
+/* Open the output for the segment and ask for the range still missing */
+CURLcode segment_start(struct segment *seg, struct OutStruct *outs,
+                       CURL *curl);
+
+/* Check data before it gets stored. 'stored' is the amount stored in this
+   attempt so far. Shortens '*lenp' to what is left of the segment if the
+   request asked for more. */
+bool segment_write_ok(struct segment *seg, CURL *curl, curl_off_t stored,
+                      size_t *lenp);
+
+/* TRUE if the write error 'result' only stopped the transfer because its
+   segment is complete */
+bool segment_stopped(const struct segment *seg, curl_off_t stored,
+                     CURLcode result);
+
+/* Keep what was stored and ask for the rest when the segment is retried */
+void segment_retry(struct segment *seg, struct OutStruct *outs, CURL *curl);
+
+/* The transfer of the segment is over. Sets 'completep' TRUE when this was
+   the last segment of a download that is complete now. */
+CURLcode segment_done(struct segment *seg, curl_off_t stored,
+                      CURLcode result, bool *completep);
+
+#endif /* HEADER_CURL_TOOL_SEGMENT_H */
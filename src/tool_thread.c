@@ -0,0 +1,110 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+#include "tool_thread.h"
+
+#ifdef TOOL_THREADS
+
+#ifdef USE_THREADS_WIN32
+#include <process.h>
+#endif
+
+#include "memdebug.h" /* keep this as LAST include */
+
+#ifdef USE_THREADS_POSIX
+
+static void *thread_run(void *arg)
+{
+  struct tool_thread *t = arg;
+  t->func(t->arg);
+  return NULL;
+}
+
+bool tool_thread_start(struct tool_thread *t)
+{
+  return !pthread_create(&t->id, NULL, thread_run, t);
+}
+
+void tool_thread_join(struct tool_thread *t)
+{
+  (void)pthread_join(t->id, NULL);
+}
+
+#else /* USE_THREADS_WIN32 */
+
+#if defined(CURL_WINDOWS_UWP) || defined(UNDER_CE)
+static DWORD WINAPI thread_run(LPVOID arg)
+#else
+static unsigned int WINAPI thread_run(void *arg)
+#endif
+{
+  struct tool_thread *t = arg;
+  t->func(t->arg);
+  return 0;
+}
+
+bool tool_thread_start(struct tool_thread *t)
+{
+#if defined(CURL_WINDOWS_UWP) || defined(UNDER_CE)
+  t->id = CreateThread(NULL, 0, thread_run, t, 0, NULL);
+#else
+  t->id = (HANDLE)_beginthreadex(NULL, 0, thread_run, t, 0, NULL);
+#endif
+  return t->id && (t->id != INVALID_HANDLE_VALUE);
+}
+
+void tool_thread_join(struct tool_thread *t)
+{
+  (void)WaitForSingleObject(t->id, INFINITE);
+  CloseHandle(t->id);
+}
+
+#endif /* USE_THREADS_POSIX */
+
+static tool_mutex_t trace_mutex;
+static bool trace_locked;
+
+void tool_trace_locking(bool enable)
+{
+  if(enable && !trace_locked)
+    tool_mutex_init(&trace_mutex);
+  else if(!enable && trace_locked)
+    tool_mutex_destroy(&trace_mutex);
+  trace_locked = enable;
+}
+
+void tool_trace_lock(void)
+{
+  if(trace_locked)
+    tool_mutex_lock(&trace_mutex);
+}
+
+void tool_trace_unlock(void)
+{
+  if(trace_locked)
+    tool_mutex_unlock(&trace_mutex);
+}
+
+#endif /* TOOL_THREADS */
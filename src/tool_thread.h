@@ -0,0 +1,73 @@
+#ifndef HEADER_CURL_TOOL_THREAD_H
+#define HEADER_CURL_TOOL_THREAD_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "tool_setup.h"
+
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+#define TOOL_THREADS
+
+#ifdef USE_THREADS_POSIX
+#define tool_mutex_t           pthread_mutex_t
+#define tool_mutex_init(m)     pthread_mutex_init(m, NULL)
+#define tool_mutex_lock(m)     pthread_mutex_lock(m)
+#define tool_mutex_unlock(m)   pthread_mutex_unlock(m)
+#define tool_mutex_destroy(m)  pthread_mutex_destroy(m)
+#else
+#define tool_mutex_t           CRITICAL_SECTION
+#define tool_mutex_init(m)     InitializeCriticalSection(m)
+#define tool_mutex_lock(m)     EnterCriticalSection(m)
+#define tool_mutex_unlock(m)   LeaveCriticalSection(m)
+#define tool_mutex_destroy(m)  DeleteCriticalSection(m)
+#endif
+
+struct tool_thread {
+#ifdef USE_THREADS_POSIX
+  pthread_t id;
+#else
+  HANDLE id;
+#endif
+  void (*func)(void *arg); /* what the thread runs */
+  void *arg;
+};
+
+/* start a thread running t->func(t->arg) */
+bool tool_thread_start(struct tool_thread *t);
+/* wait for a started thread to finish */
+void tool_thread_join(struct tool_thread *t);
+
+/* Switch the locking of the trace output on/off. It is on while transfers
+   run in more than one thread. */
+void tool_trace_locking(bool enable);
+void tool_trace_lock(void);
+void tool_trace_unlock(void);
+
+#else /* TOOL_THREADS */
+
+#define tool_trace_lock() Curl_nop_stmt
+#define tool_trace_unlock() Curl_nop_stmt
+
+#endif /* !TOOL_THREADS */
+
+#endif /* HEADER_CURL_TOOL_THREAD_H */
@@ -23,6 +23,11 @@
  ***************************************************************************/
 #include "tool_setup.h"
 
+#ifdef HAVE_FCNTL_H
+/* for posix_fallocate() */
+#include <fcntl.h>
+#endif
+
 #include "tool_util.h"
 #include "memdebug.h" /* keep this as LAST include */
 
@@ -79,6 +84,36 @@ int struplocompare4sort(const void *p1, const void *p2)
   return struplocompare(* (char * const *) p1, * (char * const *) p2);
 }
 
+/* fseek() that works with offsets beyond 2GB where possible */
+int tool_fseek(void *stream, curl_off_t offset, int whence)
+{
+#if defined(_WIN32) && defined(USE_WIN32_LARGE_FILES)
+  return _fseeki64(stream, (__int64)offset, whence);
+#elif defined(HAVE_FSEEKO) && defined(HAVE_DECL_FSEEKO)
+  return fseeko(stream, (off_t)offset, whence);
+#else
+  if(offset > LONG_MAX)
+    return -1;
+  return fseek(stream, (long)offset, whence);
+#endif
+}
+
+bool tool_preallocate(int fd, curl_off_t offset, curl_off_t len)
+{
+#ifdef HAVE_POSIX_FALLOCATE
+  /* make sure the values fit */
+  if(((curl_off_t)(off_t)offset != offset) ||
+     ((curl_off_t)(off_t)len != len))
+    return FALSE;
+  return !posix_fallocate(fd, (off_t)offset, (off_t)len);
+#else
+  (void)fd;
+  (void)offset;
+  (void)len;
+  return FALSE;
+#endif
+}
+
 #ifdef USE_TOOL_FTRUNCATE
 
 #ifdef UNDER_CE
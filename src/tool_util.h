@@ -34,6 +34,11 @@ struct timeval tvrealnow(void);
 int struplocompare(const char *p1, const char *p2);
 int struplocompare4sort(const void *p1, const void *p2);
 
+int tool_fseek(void *stream, curl_off_t offset, int whence);
+
+/* Reserve disk space for 'len' bytes at 'offset' in the file */
+bool tool_preallocate(int fd, curl_off_t offset, curl_off_t len);
+
 #if defined(_WIN32) && !defined(UNDER_CE)
 FILE *tool_execpath(const char *filename, char **pathp);
 #endif
@@ -26,6 +26,9 @@
 #include "tool_cfgable.h"
 #include "tool_writeout.h"
 #include "tool_writeout_json.h"
+#include "tool_bench.h"
+#include "tool_msgs.h"
+#include "tool_strdup.h"
 #include "memdebug.h" /* keep this as LAST include */
 
 static int writeTime(FILE *stream, const struct writeoutvar *wovar,
@@ -615,173 +618,402 @@ static const char *outtime(const char *ptr, /* %time{ ... */
   return ptr;
 }
 
-void ourWriteOut(struct OperationConfig *config, struct per_transfer *per,
-                 CURLcode per_result)
+/* what a compiled --write-out template outputs, in order */
+typedef enum {
+  WO_TEXT,     /* plain text, with the escapes already resolved */
+  WO_VAR,      /* %{variable} */
+  WO_UNKNOWN,  /* %{variable} with an unknown name */
+  WO_HEADER,   /* %header{name} */
+  WO_TIME,     /* %time{format}, kept as-is since it needs the current time */
+  WO_OUTPUT    /* %output{file} */
+} wotype;
+
+struct writeout_op {
+  wotype type;
+  const struct writeoutvar *wv; /* for WO_VAR */
+  char *str;                    /* text, name, %time{} or filename */
+  size_t len;
+  BIT(append);                  /* WO_OUTPUT with >> */
+};
+
+struct writeout {
+  struct writeout_op *op;
+  size_t count;
+  size_t alloc;
+};
+
+void writeout_free(struct writeout *wo)
 {
-  FILE *stream = stdout;
-  const char *writeinfo = config->writeout;
-  const char *ptr = writeinfo;
-  bool done = FALSE;
-  bool fclose_stream = FALSE;
-  struct dynbuf name;
+  if(wo) {
+    size_t i;
+    for(i = 0; i < wo->count; i++)
+      free(wo->op[i].str);
+    free(wo->op);
+    free(wo);
+  }
+}
 
-  if(!writeinfo)
-    return;
+static struct writeout_op *wo_add(struct writeout *wo, wotype type,
+                                  const char *str, size_t len)
+{
+  struct writeout_op *op;
+  if(wo->count == wo->alloc) {
+    size_t alloc = wo->alloc ? wo->alloc * 2 : 8;
+    op = realloc(wo->op, alloc * sizeof(*op));
+    if(!op)
+      return NULL;
+    wo->op = op;
+    wo->alloc = alloc;
+  }
+  op = &wo->op[wo->count];
+  memset(op, 0, sizeof(*op));
+  if(str) {
+    op->str = memdup0(str, len);
+    if(!op->str)
+      return NULL;
+    op->len = len;
+  }
+  op->type = type;
+  wo->count++;
+  return op;
+}
 
-  curlx_dyn_init(&name, MAX_WRITEOUT_NAME_LENGTH);
-  while(ptr && *ptr && !done) {
+/* add the collected text, if any, as an op of its own */
+static CURLcode wo_text(struct writeout *wo, struct dynbuf *text)
+{
+  if(curlx_dyn_len(text)) {
+    if(!wo_add(wo, WO_TEXT, curlx_dyn_ptr(text), curlx_dyn_len(text)))
+      return CURLE_OUT_OF_MEMORY;
+    curlx_dyn_reset(text);
+  }
+  return CURLE_OK;
+}
+
+/*
+ * Parse the --write-out template into a list of ops once, so that each
+ * finished transfer only has to walk the list.
+ */
+static struct writeout *writeout_compile(const char *ptr)
+{
+  struct writeout *wo = calloc(1, sizeof(*wo));
+  struct dynbuf text;
+  CURLcode result = CURLE_OK;
+
+  if(!wo)
+    return NULL;
+  /* the text is never longer than the template */
+  curlx_dyn_init(&text, strlen(ptr) + 1);
+  while(*ptr && !result) {
     if('%' == *ptr && ptr[1]) {
+      const char *end;
+      size_t vlen;
       if('%' == ptr[1]) {
         /* an escaped %-letter */
-        fputc('%', stream);
+        result = curlx_dyn_addn(&text, "%", 1);
         ptr += 2;
       }
-      else {
+      else if('{' == ptr[1]) {
         /* this is meant as a variable to output */
-        char *end;
-        size_t vlen;
-        if('{' == ptr[1]) {
-          struct writeoutvar *wv = NULL;
-          struct writeoutvar find = { 0 };
-          end = strchr(ptr, '}');
-          ptr += 2; /* pass the % and the { */
-          if(!end) {
-            fputs("%{", stream);
-            continue;
-          }
-          vlen = end - ptr;
-
-          curlx_dyn_reset(&name);
-          if(!curlx_dyn_addn(&name, ptr, vlen)) {
-            find.name = curlx_dyn_ptr(&name);
-            wv = bsearch(&find,
-                         variables, CURL_ARRAYSIZE(variables),
-                         sizeof(variables[0]), matchvar);
-          }
-          if(wv) {
-            switch(wv->id) {
-            case VAR_ONERROR:
-              if(per_result == CURLE_OK)
-                /* this is not error so skip the rest */
-                done = TRUE;
-              break;
-            case VAR_STDOUT:
-              if(fclose_stream)
-                fclose(stream);
-              fclose_stream = FALSE;
-              stream = stdout;
-              break;
-            case VAR_STDERR:
-              if(fclose_stream)
-                fclose(stream);
-              fclose_stream = FALSE;
-              stream = tool_stderr;
-              break;
-            case VAR_JSON:
-              ourWriteOutJSON(stream, variables,
-                              CURL_ARRAYSIZE(variables),
-                              per, per_result);
-              break;
-            case VAR_HEADER_JSON:
-              headerJSON(stream, per);
-              break;
-            default:
-              (void)wv->writefunc(stream, wv, per, per_result, false);
-              break;
-            }
-          }
-          else {
-            fprintf(tool_stderr,
-                    "curl: unknown --write-out variable: '%.*s'\n",
-                    (int)vlen, ptr);
-          }
-          ptr = end + 1; /* pass the end */
+        const struct writeoutvar *wv = NULL;
+        struct writeoutvar find = { 0 };
+        char name[MAX_WRITEOUT_NAME_LENGTH];
+        end = strchr(ptr, '}');
+        ptr += 2; /* pass the % and the { */
+        if(!end) {
+          result = curlx_dyn_addn(&text, "%{", 2);
+          continue;
         }
-        else if(!strncmp("header{", &ptr[1], 7)) {
-          ptr += 8;
-          end = strchr(ptr, '}');
-          if(end) {
-            char hname[256]; /* holds the longest header field name */
-            struct curl_header *header;
-            vlen = end - ptr;
-            if(vlen < sizeof(hname)) {
-              memcpy(hname, ptr, vlen);
-              hname[vlen] = 0;
-              if(CURLHE_OK == curl_easy_header(per->curl, hname, 0,
-                                               CURLH_HEADER, -1, &header))
-                fputs(header->value, stream);
-            }
-            ptr = end + 1;
-          }
-          else
-            fputs("%header{", stream);
+        vlen = end - ptr;
+        if(vlen < sizeof(name)) {
+          memcpy(name, ptr, vlen);
+          name[vlen] = 0;
+          find.name = name;
+          wv = bsearch(&find, variables, CURL_ARRAYSIZE(variables),
+                       sizeof(variables[0]), matchvar);
         }
-        else if(!strncmp("time{", &ptr[1], 5)) {
-          ptr = outtime(ptr, stream);
+        result = wo_text(wo, &text);
+        if(!result) {
+          struct writeout_op *op = wv ?
+            wo_add(wo, WO_VAR, NULL, 0) : wo_add(wo, WO_UNKNOWN, ptr, vlen);
+          if(op)
+            op->wv = wv;
+          else
+            result = CURLE_OUT_OF_MEMORY;
         }
-        else if(!strncmp("output{", &ptr[1], 7)) {
-          bool append = FALSE;
-          ptr += 8;
-          if((ptr[0] == '>') && (ptr[1] == '>')) {
-            append = TRUE;
-            ptr += 2;
-          }
-          end = strchr(ptr, '}');
-          if(end) {
-            char fname[512]; /* holds the longest filename */
-            size_t flen = end - ptr;
-            if(flen < sizeof(fname)) {
-              FILE *stream2;
-              memcpy(fname, ptr, flen);
-              fname[flen] = 0;
-              stream2 = fopen(fname, append ? FOPEN_APPENDTEXT :
-                              FOPEN_WRITETEXT);
-              if(stream2) {
-                /* only change if the open worked */
-                if(fclose_stream)
-                  fclose(stream);
-                stream = stream2;
-                fclose_stream = TRUE;
-              }
-            }
-            ptr = end + 1;
+        ptr = end + 1; /* pass the end */
+      }
+      else if(!strncmp("header{", &ptr[1], 7)) {
+        ptr += 8;
+        end = strchr(ptr, '}');
+        if(end) {
+          vlen = end - ptr;
+          /* longer names cannot be headers */
+          if(vlen < 256) {
+            result = wo_text(wo, &text);
+            if(!result && !wo_add(wo, WO_HEADER, ptr, vlen))
+              result = CURLE_OUT_OF_MEMORY;
           }
-          else
-            fputs("%output{", stream);
+          ptr = end + 1;
+        }
+        else
+          result = curlx_dyn_add(&text, "%header{");
+      }
+      else if(!strncmp("time{", &ptr[1], 5)) {
+        end = strchr(ptr, '}');
+        if(end) {
+          result = wo_text(wo, &text);
+          if(!result && !wo_add(wo, WO_TIME, ptr, end - ptr + 1))
+            result = CURLE_OUT_OF_MEMORY;
+          ptr = end + 1;
         }
         else {
-          /* illegal syntax, then just output the characters that are used */
-          fputc('%', stream);
-          fputc(ptr[1], stream);
+          result = curlx_dyn_add(&text, "%time{");
+          ptr += 6;
+        }
+      }
+      else if(!strncmp("output{", &ptr[1], 7)) {
+        bool append = FALSE;
+        ptr += 8;
+        if((ptr[0] == '>') && (ptr[1] == '>')) {
+          append = TRUE;
           ptr += 2;
         }
+        end = strchr(ptr, '}');
+        if(end) {
+          /* longer filenames are ignored */
+          if((size_t)(end - ptr) < 512) {
+            struct writeout_op *op;
+            result = wo_text(wo, &text);
+            if(!result) {
+              op = wo_add(wo, WO_OUTPUT, ptr, end - ptr);
+              if(op)
+                op->append = append;
+              else
+                result = CURLE_OUT_OF_MEMORY;
+            }
+          }
+          ptr = end + 1;
+        }
+        else
+          result = curlx_dyn_add(&text, "%output{");
+      }
+      else {
+        /* illegal syntax, then just output the characters that are used */
+        result = curlx_dyn_addn(&text, ptr, 2);
+        ptr += 2;
       }
     }
     else if('\\' == *ptr && ptr[1]) {
       switch(ptr[1]) {
       case 'r':
-        fputc('\r', stream);
+        result = curlx_dyn_addn(&text, "\r", 1);
         break;
       case 'n':
-        fputc('\n', stream);
+        result = curlx_dyn_addn(&text, "\n", 1);
         break;
       case 't':
-        fputc('\t', stream);
+        result = curlx_dyn_addn(&text, "\t", 1);
         break;
       default:
         /* unknown, just output this */
-        fputc(*ptr, stream);
-        fputc(ptr[1], stream);
+        result = curlx_dyn_addn(&text, ptr, 2);
         break;
       }
       ptr += 2;
     }
     else {
-      fputc(*ptr, stream);
-      ptr++;
+      /* the plain text up to the next special character */
+      size_t len = strcspn(ptr + 1, "%\\") + 1;
+      result = curlx_dyn_addn(&text, ptr, len);
+      ptr += len;
+    }
+  }
+  if(!result)
+    result = wo_text(wo, &text);
+  curlx_dyn_free(&text);
+  if(result) {
+    writeout_free(wo);
+    return NULL;
+  }
+  return wo;
+}
+
+void ourWriteOut(struct OperationConfig *config, struct per_transfer *per,
+                 CURLcode per_result)
+{
+  FILE *stream = stdout;
+  bool done = FALSE;
+  bool fclose_stream = FALSE;
+  const struct writeout *wo;
+  size_t i;
+
+  if(!config->writeout)
+    return;
+
+  if(!config->writeout_ops) {
+    config->writeout_ops = writeout_compile(config->writeout);
+    if(!config->writeout_ops) {
+      errorf("out of memory");
+      return;
+    }
+  }
+  wo = config->writeout_ops;
+
+  for(i = 0; (i < wo->count) && !done; i++) {
+    const struct writeout_op *op = &wo->op[i];
+    switch(op->type) {
+    case WO_TEXT:
+      fwrite(op->str, 1, op->len, stream);
+      break;
+    case WO_VAR:
+      switch(op->wv->id) {
+      case VAR_ONERROR:
+        if(per_result == CURLE_OK)
+          /* this is not error so skip the rest */
+          done = TRUE;
+        break;
+      case VAR_STDOUT:
+        if(fclose_stream)
+          fclose(stream);
+        fclose_stream = FALSE;
+        stream = stdout;
+        break;
+      case VAR_STDERR:
+        if(fclose_stream)
+          fclose(stream);
+        fclose_stream = FALSE;
+        stream = tool_stderr;
+        break;
+      case VAR_JSON:
+        ourWriteOutJSON(stream, variables,
+                        CURL_ARRAYSIZE(variables),
+                        per, per_result);
+        break;
+      case VAR_HEADER_JSON:
+        headerJSON(stream, per);
+        break;
+      default:
+        (void)op->wv->writefunc(stream, op->wv, per, per_result, false);
+        break;
+      }
+      break;
+    case WO_UNKNOWN:
+      fprintf(tool_stderr,
+              "curl: unknown --write-out variable: '%s'\n", op->str);
+      break;
+    case WO_HEADER: {
+      struct curl_header *header;
+      if(CURLHE_OK == curl_easy_header(per->curl, op->str, 0,
+                                       CURLH_HEADER, -1, &header))
+        fputs(header->value, stream);
+      break;
+    }
+    case WO_TIME:
+      (void)outtime(op->str, stream);
+      break;
+    case WO_OUTPUT: {
+      FILE *stream2 = fopen(op->str, op->append ? FOPEN_APPENDTEXT :
+                            FOPEN_WRITETEXT);
+      if(stream2) {
+        /* only change if the open worked */
+        if(fclose_stream)
+          fclose(stream);
+        stream = stream2;
+        fclose_stream = TRUE;
+      }
+      break;
+    }
     }
   }
   if(fclose_stream)
     fclose(stream);
-  curlx_dyn_free(&name);
+}
+
+/* the --write-out variables written to --metrics-file for each transfer */
+static const char * const metrics_names[] = {
+  "url",
+  "url_effective",
+  "exitcode",
+  "response_code",
+  "http_version",
+  "scheme",
+  "remote_ip",
+  "remote_port",
+  "conn_id",
+  "num_connects",
+  "num_redirects",
+  "num_retries",
+  "size_download",
+  "size_upload",
+  "size_header",
+  "size_request",
+  "speed_download",
+  "speed_upload",
+  "time_queue",
+  "time_namelookup",
+  "time_connect",
+  "time_appconnect",
+  "time_pretransfer",
+  "time_posttransfer",
+  "time_starttransfer",
+  "time_redirect",
+  "time_total"
+};
+
+/* looked up once in metrics_open() */
+static const struct writeoutvar *metrics_vars[CURL_ARRAYSIZE(metrics_names)];
+
+CURLcode metrics_open(void)
+{
+  size_t i;
+  for(i = 0; i < CURL_ARRAYSIZE(metrics_names); i++) {
+    struct writeoutvar find = { 0 };
+    find.name = metrics_names[i];
+    metrics_vars[i] = bsearch(&find, variables, CURL_ARRAYSIZE(variables),
+                              sizeof(variables[0]), matchvar);
+    DEBUGASSERT(metrics_vars[i]);
+  }
+  if(!strcmp(global->metrics_file, "-"))
+    global->metrics_stream = stdout;
+  else {
+    global->metrics_stream = fopen(global->metrics_file, FOPEN_APPENDTEXT);
+    if(!global->metrics_stream) {
+      errorf("cannot write '%s'", global->metrics_file);
+      return CURLE_WRITE_ERROR;
+    }
+  }
+  return CURLE_OK;
+}
+
+void metrics_write(struct per_transfer *per, CURLcode per_result)
+{
+  FILE *out = global->metrics_stream;
+  curl_off_t conn_id = -1;
+  long connects = 0;
+  size_t i;
+
+  fputc('{', out);
+  for(i = 0; i < CURL_ARRAYSIZE(metrics_vars); i++) {
+    if(i)
+      fputc(',', out);
+    (void)metrics_vars[i]->writefunc(out, metrics_vars[i], per, per_result,
+                                     true);
+  }
+  curl_easy_getinfo(per->curl, CURLINFO_CONN_ID, &conn_id);
+  curl_easy_getinfo(per->curl, CURLINFO_NUM_CONNECTS, &connects);
+  fprintf(out, ",\"reused\":%s}\n",
+          ((conn_id >= 0) && !connects) ? "true" : "false");
+}
+
+void metrics_close(void)
+{
+  FILE *out = global->metrics_stream;
+  if(out) {
+    fputs("{\"summary\":", out);
+    bench_summary(out);
+    fputs("}\n", out);
+    if(out != stdout)
+      fclose(out);
+    global->metrics_stream = NULL;
+  }
 }
@@ -112,7 +112,15 @@ struct writeoutvar {
                    bool use_json);
 };
 
+struct writeout;
+
 void ourWriteOut(struct OperationConfig *config, struct per_transfer *per,
                  CURLcode per_result);
+void writeout_free(struct writeout *wo);
+
+/* --metrics-file */
+CURLcode metrics_open(void);
+void metrics_write(struct per_transfer *per, CURLcode per_result);
+void metrics_close(void);
 
 #endif /* HEADER_CURL_TOOL_WRITEOUT_H */
@@ -0,0 +1,67 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+/* journal cookie changes, then replay them from a new handle */
+static CURLcode test_lib1619(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURL *ch = NULL;
+  char *url2 = NULL;
+  global_init(CURL_GLOBAL_ALL);
+
+  url2 = curl_maprintf("%s0002", URL);
+  if(!url2) {
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+
+  easy_init(ch);
+  easy_setopt(ch, CURLOPT_URL, URL);
+  easy_setopt(ch, CURLOPT_COOKIEFILE, libtest_arg2);
+  easy_setopt(ch, CURLOPT_COOKIEJAR, libtest_arg2);
+  easy_setopt(ch, CURLOPT_COOKIEJOURNAL, 1L);
+  res = curl_easy_perform(ch);
+  if(res)
+    goto test_cleanup;
+
+  /* does not rewrite the jar */
+  curl_easy_cleanup(ch);
+
+  easy_init(ch);
+  easy_setopt(ch, CURLOPT_URL, url2);
+  easy_setopt(ch, CURLOPT_COOKIEFILE, libtest_arg2);
+  easy_setopt(ch, CURLOPT_COOKIEJAR, libtest_arg2);
+  easy_setopt(ch, CURLOPT_COOKIEJOURNAL, 1L);
+  res = curl_easy_perform(ch);
+
+test_cleanup:
+  curl_free(url2);
+  curl_easy_cleanup(ch);
+  curl_global_cleanup();
+
+  return res;
+}
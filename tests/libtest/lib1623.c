@@ -0,0 +1,158 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+/* transfers in several threads using a share with the built-in locks */
+
+#define T1623_THREADS 4
+#define T1623_TRANSFERS 5
+
+struct t1623_ctx {
+  CURLSH *share;
+  const char *url;
+  CURLcode result;
+};
+
+static size_t t1623_write(char *ptr, size_t size, size_t nmemb, void *userp)
+{
+  (void)ptr;
+  (void)userp;
+  return size * nmemb;
+}
+
+static CURLcode t1623_transfers(struct t1623_ctx *ctx)
+{
+  CURLcode res = CURLE_OK;
+  int i;
+  for(i = 0; !res && (i < T1623_TRANSFERS); i++) {
+    CURL *curl = curl_easy_init();
+    if(!curl)
+      return TEST_ERR_EASY_INIT;
+    test_setopt(curl, CURLOPT_URL, ctx->url);
+    test_setopt(curl, CURLOPT_SHARE, ctx->share);
+    test_setopt(curl, CURLOPT_COOKIEFILE, "");
+    test_setopt(curl, CURLOPT_WRITEFUNCTION, t1623_write);
+    res = curl_easy_perform(curl);
+test_cleanup:
+    curl_easy_cleanup(curl);
+  }
+  return res;
+}
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+
+static void *t1623_run_thread(void *ptr)
+{
+  struct t1623_ctx *ctx = ptr;
+  ctx->result = t1623_transfers(ctx);
+  return NULL;
+}
+#endif
+
+static CURLcode test_lib1623(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLSH *share = NULL;
+  CURL *curl = NULL;
+  struct curl_slist *cookies = NULL;
+  struct curl_slist *c;
+  struct t1623_ctx ctx[T1623_THREADS];
+  int count = 0;
+  int i;
+#ifdef HAVE_PTHREAD_H
+  pthread_t tids[T1623_THREADS];
+  int nthreads = 0;
+#endif
+
+  global_init(CURL_GLOBAL_ALL);
+
+  share = curl_share_init();
+  if(!share) {
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  if(curl_share_setopt(share, CURLSHOPT_BUILTIN_LOCKS, 1L) ||
+     curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) ||
+     curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE) ||
+     curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_HSTS)) {
+    curl_mfprintf(stderr, "curl_share_setopt() failed\n");
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+
+  for(i = 0; i < T1623_THREADS; i++) {
+    ctx[i].share = share;
+    ctx[i].url = URL;
+    ctx[i].result = CURLE_OK;
+  }
+
+#ifdef HAVE_PTHREAD_H
+  for(; nthreads < T1623_THREADS; nthreads++) {
+    if(pthread_create(&tids[nthreads], NULL, t1623_run_thread,
+                      &ctx[nthreads])) {
+      curl_mfprintf(stderr, "Couldn't create thread\n");
+      res = TEST_ERR_MAJOR_BAD;
+      break;
+    }
+  }
+  for(i = 0; i < nthreads; i++)
+    pthread_join(tids[i], NULL);
+#else
+  /* without threads, the transfers are done one after the other */
+  for(i = 0; i < T1623_THREADS; i++)
+    ctx[i].result = t1623_transfers(&ctx[i]);
+#endif
+
+  for(i = 0; i < T1623_THREADS; i++) {
+    if(ctx[i].result) {
+      curl_mfprintf(stderr, "transfers %d failed: %d\n", i,
+                    (int)ctx[i].result);
+      if(!res)
+        res = ctx[i].result;
+    }
+  }
+  if(res)
+    goto test_cleanup;
+
+  /* all threads stored the same cookie in the shared jar */
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_SHARE, share);
+  res = curl_easy_getinfo(curl, CURLINFO_COOKIELIST, &cookies);
+  if(res)
+    goto test_cleanup;
+  for(c = cookies; c; c = c->next)
+    count++;
+  curl_mprintf("%d cookies\n", count);
+
+test_cleanup:
+  curl_slist_free_all(cookies);
+  curl_easy_cleanup(curl);
+  curl_share_cleanup(share);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+/* pre-connect, then verify that the transfer reuses the connection */
+static CURLcode test_lib1624(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *multi = NULL;
+  CURL *curl = NULL;
+  struct curl_slist *urls = NULL;
+  int running;
+  int numfds;
+  long connects = -1;
+  long timeout_ms = -1;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+
+  urls = curl_slist_append(NULL, URL);
+  if(!urls) {
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  if(curl_multi_preconnect(multi, NULL, urls, 1)) {
+    res = TEST_ERR_MULTI;
+    goto test_cleanup;
+  }
+
+  /* the pre-connect is not a running handle, wait until libcurl has
+     nothing left to do for it */
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(running) {
+      curl_mfprintf(stderr, "the pre-connect counts as running\n");
+      res = TEST_ERR_FAILURE;
+      goto test_cleanup;
+    }
+    multi_timeout(multi, &timeout_ms);
+    if(timeout_ms >= 0)
+      multi_poll(multi, NULL, 0, 1000, &numfds);
+    abort_on_test_timeout();
+  } while(timeout_ms >= 0);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  multi_add_handle(multi, curl);
+
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(running)
+      multi_poll(multi, NULL, 0, 1000, &numfds);
+    abort_on_test_timeout();
+  } while(running);
+
+  res = curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  if(!res)
+    curl_mfprintf(stderr, "num connects: %ld\n", connects);
+  if(connects) {
+    curl_mfprintf(stderr, "the pre-made connection was not reused\n");
+    res = TEST_ERR_FAILURE;
+  }
+
+test_cleanup:
+  curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  curl_multi_cleanup(multi);
+  curl_slist_free_all(urls);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "testutil.h"
+#include "memdebug.h"
+
+/* the multi keeps an upkeep timer for its idle connection */
+static CURLcode test_lib1625(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *multi = NULL;
+  int running;
+  int numfds;
+  long timeout_ms = -1;
+  long connects = -1;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+  multi_setopt(multi, CURLMOPT_UPKEEP_INTERVAL, 100L);
+
+  res = tutil_multi_transfer(multi, URL, &connects);
+  if(res)
+    goto test_cleanup;
+
+  multi_timeout(multi, &timeout_ms);
+  if(timeout_ms < 0) {
+    curl_mfprintf(stderr, "no upkeep timer for the idle connection\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  /* let the upkeep run a few times, the test checks the trace it leaves
+     in stderr after this line */
+  curl_mfprintf(stderr, "idle connection left for upkeep\n");
+  do {
+    multi_poll(multi, NULL, 0, 1000, &numfds);
+    abort_on_test_timeout();
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+  } while(curlx_timediff(curlx_now(), tv_test_start) < 500);
+
+  multi_timeout(multi, &timeout_ms);
+  if(timeout_ms < 0) {
+    curl_mfprintf(stderr, "the upkeep timer was not set again\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  res = tutil_multi_transfer(multi, URL, &connects);
+  if(res)
+    goto test_cleanup;
+  if(connects) {
+    curl_mfprintf(stderr, "the idle connection was not reused\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  /* a timeout already handed out may still expire once */
+  multi_setopt(multi, CURLMOPT_UPKEEP_INTERVAL, 0L);
+  multi_poll(multi, NULL, 0, 200, &numfds);
+  multi_perform(multi, &running);
+  multi_timeout(multi, &timeout_ms);
+  if(timeout_ms >= 0) {
+    curl_mfprintf(stderr, "upkeep timer left after switching it off\n");
+    res = TEST_ERR_FAILURE;
+  }
+
+test_cleanup:
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+
+  return res;
+}
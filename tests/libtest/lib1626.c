@@ -0,0 +1,96 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "testutil.h"
+#include "memdebug.h"
+
+/* move an idle connection to another multi handle and reuse it there */
+static CURLcode test_lib1626(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *m1 = NULL;
+  CURLM *m2 = NULL;
+  unsigned int moved = 0;
+  long connects = -1;
+  char *url2 = NULL;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(m1);
+  multi_init(m2);
+
+  res = tutil_multi_transfer(m1, URL, &connects);
+  if(res)
+    goto test_cleanup;
+  curl_mprintf("first multi: %ld new connection(s)\n", connects);
+
+  /* another origin */
+  if(curl_multi_handoff(m1, m2, "http://example.invalid/", 10, &moved) ||
+     moved) {
+    curl_mfprintf(stderr, "moved %u connections to the wrong origin\n",
+                  moved);
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  if(curl_multi_handoff(m1, m2, URL, 10, &moved) || (moved != 1)) {
+    curl_mfprintf(stderr, "moved %u connections, expected 1\n", moved);
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  /* another URL of the same origin gets the moved connection */
+  url2 = tutil_suburl(URL, 2);
+  if(!url2) {
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  res = tutil_multi_transfer(m2, url2, &connects);
+  if(res)
+    goto test_cleanup;
+  curl_mprintf("second multi: %ld new connection(s)\n", connects);
+  if(connects) {
+    curl_mfprintf(stderr, "the moved connection was not reused\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  /* nothing left to move */
+  if(curl_multi_handoff(m1, m2, NULL, 10, &moved) || moved) {
+    curl_mfprintf(stderr, "moved %u connections from an empty pool\n",
+                  moved);
+    res = TEST_ERR_FAILURE;
+  }
+
+test_cleanup:
+  curl_free(url2);
+  curl_multi_cleanup(m1);
+  curl_multi_cleanup(m2);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "testutil.h"
+#include "memdebug.h"
+
+struct t1627_sock {
+  curl_socket_t fd;
+  int action;
+};
+
+static struct t1627_sock t1627_socks[8];
+static size_t t1627_nsocks;
+
+static int t1627_sock_cb(CURL *easy, curl_socket_t s, int action,
+                         void *userp, void *socketp)
+{
+  size_t i;
+  (void)easy;
+  (void)userp;
+  (void)socketp;
+  for(i = 0; i < t1627_nsocks; i++) {
+    if(t1627_socks[i].fd == s)
+      break;
+  }
+  if(i == t1627_nsocks) {
+    if(t1627_nsocks == CURL_ARRAYSIZE(t1627_socks))
+      return -1;
+    t1627_socks[t1627_nsocks++].fd = s;
+  }
+  t1627_socks[i].action = action;
+  return 0;
+}
+
+/* the number of sockets the application is asked to watch for input only */
+static size_t t1627_watched_in(void)
+{
+  size_t i, n = 0;
+  for(i = 0; i < t1627_nsocks; i++) {
+    if(t1627_socks[i].action == CURL_POLL_IN)
+      n++;
+  }
+  return n;
+}
+
+/* an idle connection has its socket watched by the event API and is
+   reused without a liveness check */
+static CURLcode test_lib1627(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *multi = NULL;
+  long connects = -1;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+  multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, t1627_sock_cb);
+
+  res = tutil_multi_transfer(multi, URL, &connects);
+  if(res)
+    goto test_cleanup;
+
+  if(t1627_watched_in() != 1) {
+    curl_mfprintf(stderr, "idle connection not watched for input\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  res = tutil_multi_transfer(multi, URL, &connects);
+  if(res)
+    goto test_cleanup;
+  if(connects) {
+    curl_mfprintf(stderr, "the idle connection was not reused\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+
+  curl_multi_cleanup(multi);
+  multi = NULL;
+  if(t1627_watched_in()) {
+    curl_mfprintf(stderr, "socket still watched after cleanup\n");
+    res = TEST_ERR_FAILURE;
+  }
+
+test_cleanup:
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+
+  return res;
+}
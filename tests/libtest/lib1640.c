@@ -0,0 +1,132 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+/*
+ * Upload a file with the default fread() and as a mime file part, both
+ * without verbose output, so that the body can be sent from the file
+ * directly.
+ */
+
+static CURLcode test_lib1640(const char *URL)
+{
+  CURL *curl = NULL;
+  CURLcode res = CURLE_OK;
+  curl_mime *mime = NULL;
+  curl_mimepart *part;
+  FILE *hd_src;
+  struct_stat file_info;
+
+  if(!libtest_arg2) {
+    curl_mfprintf(stderr, "Usage: <url> <file-to-upload>\n");
+    return TEST_ERR_USAGE;
+  }
+
+  hd_src = fopen(libtest_arg2, "rb");
+  if(!hd_src) {
+    curl_mfprintf(stderr, "fopen failed with error (%d) %s\n",
+                  errno, strerror(errno));
+    curl_mfprintf(stderr, "Error opening file '%s'\n", libtest_arg2);
+    return TEST_ERR_MAJOR_BAD;
+  }
+
+  if(fstat(fileno(hd_src), &file_info) == -1) {
+    curl_mfprintf(stderr, "fstat() failed with error (%d) %s\n",
+                  errno, strerror(errno));
+    fclose(hd_src);
+    return TEST_ERR_MAJOR_BAD;
+  }
+
+  if(curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) {
+    curl_mfprintf(stderr, "curl_global_init() failed\n");
+    fclose(hd_src);
+    return TEST_ERR_MAJOR_BAD;
+  }
+
+  curl = curl_easy_init();
+  if(!curl) {
+    curl_mfprintf(stderr, "curl_easy_init() failed\n");
+    curl_global_cleanup();
+    fclose(hd_src);
+    return TEST_ERR_MAJOR_BAD;
+  }
+
+  /* a small buffer, so most of the body does not fit next to the headers */
+  test_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, 16384L);
+  test_setopt(curl, CURLOPT_HEADER, 1L);
+  test_setopt(curl, CURLOPT_URL, URL);
+
+  /* PUT the file, read with the default read function */
+  test_setopt(curl, CURLOPT_UPLOAD, 1L);
+  test_setopt(curl, CURLOPT_READDATA, hd_src);
+  test_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+              (curl_off_t)file_info.st_size);
+
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+
+  /* POST the same file as a mime part, between two others */
+  mime = curl_mime_init(curl);
+  if(!mime) {
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  part = curl_mime_addpart(mime);
+  res = curl_mime_name(part, "before");
+  if(!res)
+    res = curl_mime_data(part, "one", CURL_ZERO_TERMINATED);
+  if(!res) {
+    part = curl_mime_addpart(mime);
+    res = curl_mime_name(part, "file");
+  }
+  if(!res)
+    res = curl_mime_filedata(part, libtest_arg2);
+  if(!res)
+    res = curl_mime_filename(part, "upload.txt");
+  if(!res) {
+    part = curl_mime_addpart(mime);
+    res = curl_mime_name(part, "after");
+  }
+  if(!res)
+    res = curl_mime_data(part, "two", CURL_ZERO_TERMINATED);
+  if(res)
+    goto test_cleanup;
+
+  test_setopt(curl, CURLOPT_UPLOAD, 0L);
+  test_setopt(curl, CURLOPT_MIMEPOST, mime);
+
+  res = curl_easy_perform(curl);
+
+test_cleanup:
+
+  curl_easy_cleanup(curl);
+  curl_mime_free(mime);
+  curl_global_cleanup();
+  fclose(hd_src);
+
+  return res;
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "testutil.h"
+#include "memdebug.h"
+
+/* grow the cookie journal until the jar is rewritten after an add */
+static CURLcode test_lib1646(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURL *ch = NULL;
+  char *url2 = NULL;
+  char *journal = NULL;
+  FILE *jp;
+  int i;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  url2 = tutil_suburl(URL, 2);
+  journal = curl_maprintf("%s-journal", libtest_arg2);
+  if(!url2 || !journal) {
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+
+  easy_init(ch);
+  easy_setopt(ch, CURLOPT_COOKIEFILE, libtest_arg2);
+  easy_setopt(ch, CURLOPT_COOKIEJAR, libtest_arg2);
+  easy_setopt(ch, CURLOPT_COOKIEJOURNAL, 1L);
+
+  /* 20 times 50 updates fill the journal up to the limit */
+  easy_setopt(ch, CURLOPT_URL, URL);
+  for(i = 0; i < 20; i++) {
+    res = curl_easy_perform(ch);
+    if(res)
+      goto test_cleanup;
+  }
+
+  jp = fopen(journal, "rb");
+  curl_mprintf("journal before: %s\n", jp ? "present" : "missing");
+  if(jp)
+    fclose(jp);
+
+  /* one more update compacts the jar */
+  easy_setopt(ch, CURLOPT_URL, url2);
+  res = curl_easy_perform(ch);
+  if(res)
+    goto test_cleanup;
+
+  jp = fopen(journal, "rb");
+  curl_mprintf("journal after: %s\n", jp ? "present" : "missing");
+  if(jp)
+    fclose(jp);
+
+test_cleanup:
+  curl_free(url2);
+  curl_free(journal);
+  /* does not rewrite the jar */
+  curl_easy_cleanup(ch);
+  curl_global_cleanup();
+
+  return res;
+}
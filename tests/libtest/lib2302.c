@@ -32,6 +32,7 @@ struct ws_data {
   size_t nwrites;
   int has_meta;
   int meta_flags;
+  int sent;
 };
 
 #define LIB2302_BUFSIZE (1024 * 1024)
@@ -86,6 +87,17 @@ static size_t t2302_write_cb(char *buffer, size_t size, size_t nitems, void *p)
   meta = curl_ws_meta(ws_data->easy);
   incoming = add_data(ws_data, buffer, incoming, meta);
 
+  if(testnum == 2305 && !ws_data->sent && meta &&
+     (meta->flags == CURLWS_TEXT) && !meta->bytesleft) {
+    /* answer the first complete TEXT message, compressed */
+    size_t sent;
+    CURLcode result = curl_ws_send(ws_data->easy, "Hello", 5, &sent, 0,
+                                   CURLWS_TEXT);
+    curl_mfprintf(stderr, "curl_ws_send() returned %d, sent %zu\n",
+                  result, sent);
+    ws_data->sent = 1;
+  }
+
   if(nitems != incoming)
     curl_mfprintf(stderr, "returns error from callback\n");
   return nitems;
@@ -114,6 +126,8 @@ static CURLcode test_lib2302(const char *URL)
       curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
       curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, t2302_write_cb);
       curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ws_data);
+      if(testnum == 2305)
+        curl_easy_setopt(curl, CURLOPT_WS_OPTIONS, CURLWS_DEFLATE);
       res = curl_easy_perform(curl);
       curl_mfprintf(stderr, "curl_easy_perform() returned %d\n", res);
       /* always cleanup */
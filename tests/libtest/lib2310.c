@@ -0,0 +1,125 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#ifndef CURL_DISABLE_WEBSOCKETS
+/* receive and show the next view, release `rlen` bytes of it at most */
+static CURLcode t2310_view(CURL *curl, size_t rlen)
+{
+  const void *buf;
+  size_t len, i;
+  const struct curl_ws_frame *meta;
+  CURLcode result;
+  int tries = 0;
+
+  do {
+    result = curl_ws_recv_view(curl, &buf, &len, &meta);
+    if(result == CURLE_AGAIN)
+      curlx_wait_ms(10);
+  } while((result == CURLE_AGAIN) && (tries++ < 500));
+  if(result) {
+    curl_mfprintf(stderr, "curl_ws_recv_view() returned %d\n", result);
+    return result;
+  }
+  if(rlen > len)
+    rlen = len;
+  curl_mprintf("view: flags %x, offset %" CURL_FORMAT_CURL_OFF_T
+               ", bytesleft %" CURL_FORMAT_CURL_OFF_T ", len %zu:",
+               meta->flags, meta->offset, meta->bytesleft, meta->len);
+  for(i = 0; i < rlen; ++i)
+    curl_mprintf(" %02x", ((const unsigned char *)buf)[i]);
+  curl_mprintf("\n");
+  return curl_ws_recv_release(curl, rlen);
+}
+
+static CURLcode t2310_websocket(CURL *curl)
+{
+  struct curl_ws_vec frames[3];
+  size_t nsent = 0;
+  CURLcode result;
+
+  /* "hello" in two parts, the rest stays in place after a partial
+   * release, then an empty BINARY and a fragmented TEXT */
+  result = t2310_view(curl, 2);
+  if(!result)
+    result = t2310_view(curl, 1000);
+  if(!result)
+    result = t2310_view(curl, 1000);
+  if(!result)
+    result = t2310_view(curl, 1000);
+  if(!result)
+    result = t2310_view(curl, 1000);
+  if(result)
+    return result;
+  if(curl_ws_recv_release(curl, 1) != CURLE_BAD_FUNCTION_ARGUMENT) {
+    curl_mfprintf(stderr, "releasing more than lent did not fail\n");
+    return TEST_ERR_FAILURE;
+  }
+
+  frames[0].buffer = "one";
+  frames[0].buflen = 3;
+  frames[0].flags = CURLWS_TEXT;
+  frames[1].buffer = "two";
+  frames[1].buflen = 3;
+  frames[1].flags = CURLWS_BINARY;
+  frames[2].buffer = "";
+  frames[2].buflen = 0;
+  frames[2].flags = CURLWS_CLOSE;
+  result = curl_ws_sendv(curl, frames, 3, &nsent);
+  curl_mfprintf(stderr, "curl_ws_sendv() returned %d, sent %zu\n",
+                result, nsent);
+  if(!result && (nsent != 3))
+    result = TEST_ERR_FAILURE;
+  return result;
+}
+#endif
+
+static CURLcode test_lib2310(const char *URL)
+{
+#ifndef CURL_DISABLE_WEBSOCKETS
+  CURL *curl;
+  CURLcode res = CURLE_OK;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  curl = curl_easy_init();
+  if(curl) {
+    curl_easy_setopt(curl, CURLOPT_URL, URL);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "websocket/2310");
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 2L); /* websocket style */
+    res = curl_easy_perform(curl);
+    curl_mfprintf(stderr, "curl_easy_perform() returned %d\n", res);
+    if(res == CURLE_OK)
+      res = t2310_websocket(curl);
+
+    /* always cleanup */
+    curl_easy_cleanup(curl);
+  }
+  curl_global_cleanup();
+  return res;
+#else
+  NO_SUPPORT_BUILT_IN
+#endif
+}
@@ -31,6 +31,34 @@ char *tutil_suburl(const char *base, int i)
   return curl_maprintf("%s%.4d", base, i);
 }
 
+/* do a transfer on the multi handle, return the number of new connections */
+CURLcode tutil_multi_transfer(CURLM *multi, const char *URL, long *connects)
+{
+  CURLcode res = CURLE_OK;
+  CURL *curl = NULL;
+  int running;
+  int numfds;
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  multi_add_handle(multi, curl);
+
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(running)
+      multi_poll(multi, NULL, 0, 1000, &numfds);
+    abort_on_test_timeout();
+  } while(running);
+
+  res = curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, connects);
+
+test_cleanup:
+  curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  return res;
+}
+
 #if defined(HAVE_GETRLIMIT) && defined(HAVE_SETRLIMIT)
 void tutil_rlim2str(char *buf, size_t len, rlim_t val)
 {
@@ -28,6 +28,9 @@
 /* build request url */
 char *tutil_suburl(const char *base, int i);
 
+/* do a transfer on the multi handle, return the number of new connections */
+CURLcode tutil_multi_transfer(CURLM *multi, const char *URL, long *connects);
+
 #ifdef HAVE_SYS_RESOURCE_H
 #include <sys/resource.h>  /* for getrlimit() */
 #endif
@@ -0,0 +1,125 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "tool_adapt.h"
+
+#include "memdebug.h" /* LAST include file */
+
+#define SIM_MAX 50
+
+/* One round against a simulated server that handles 'capacity' transfers
+   at once. Beyond that it either responds 429 to the extra ones, or gets
+   slower for all of them when 'queue' is set. Returns the number of
+   transfers started in the round. */
+static long sim_round(struct adapt_host *h, long capacity, bool queue)
+{
+  curl_off_t seq[SIM_MAX + 1];
+  long n = 0;
+  long i;
+
+  while((n <= SIM_MAX) && adapt_admit(h, &seq[n]))
+    n++;
+  for(i = 0; i < n; i++) {
+    long code = 200;
+    curl_off_t latency = 10000;
+    if(n > capacity) {
+      if(queue)
+        latency = latency * n / capacity;
+      else if(i >= capacity)
+        code = 429;
+    }
+    adapt_done(h, seq[i], code, CURLE_OK, latency);
+  }
+  return n;
+}
+
+/* run the simulation and check that the number of transfers per round
+   settles between 'lo' and 'hi' */
+static void sim_check(const char *url, long capacity, bool queue,
+                      long lo, long hi)
+{
+  struct adapt_host *h = adapt_host(url, SIM_MAX);
+  long min = SIM_MAX + 1;
+  long max = 0;
+  int i;
+
+  if(!h) {
+    fail("adapt_host() failed");
+    return;
+  }
+  for(i = 0; i < 100; i++)
+    (void)sim_round(h, capacity, queue);
+  for(i = 0; i < 200; i++) {
+    long n = sim_round(h, capacity, queue);
+    if(n < min)
+      min = n;
+    if(n > max)
+      max = n;
+  }
+  printf("%s: capacity %ld, settled between %ld and %ld\n", url, capacity,
+         min, max);
+  fail_unless(min >= lo, "too few transfers");
+  fail_unless(max <= hi, "too many transfers");
+}
+
+static CURLcode test_tool1638(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  struct adapt_host *h = adapt_host("http://example.com/a", SIM_MAX);
+  int i;
+
+  abort_unless(h, "adapt_host");
+  fail_unless(h == adapt_host("http://example.com:80/b", SIM_MAX),
+              "same host, different state");
+  fail_unless(h != adapt_host("https://example.com/", SIM_MAX),
+              "different scheme, same state");
+
+  /* a host without trouble gets everything quickly */
+  fail_unless(adapt_limit(h) == 1, "not starting at one");
+  for(i = 0; i < 20; i++)
+    (void)sim_round(h, 1000, FALSE);
+  fail_unless(adapt_limit(h) == SIM_MAX, "not reaching the max");
+
+  /* a transfer that never started gives its slot back */
+  {
+    struct adapt_host *c = adapt_host("http://cancel.example/", SIM_MAX);
+    curl_off_t seq;
+    abort_unless(c, "adapt_host");
+    fail_unless(adapt_admit(c, &seq), "first not admitted");
+    fail_unless(!adapt_admit(c, &seq), "second admitted over the limit");
+    adapt_cancel(c);
+    fail_unless(adapt_admit(c, &seq), "slot not given back");
+    fail_unless(adapt_limit(c) == 1, "limit changed by cancel");
+  }
+
+  /* the 429 responses keep it around the capacity */
+  sim_check("http://throttle.example/", 10, FALSE, 5, 11);
+
+  /* the growing latency keeps it below about twice the capacity */
+  sim_check("http://queue.example/", 10, TRUE, 5, 25);
+
+  UNITTEST_END(adapt_cleanup())
+}
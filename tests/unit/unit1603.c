@@ -159,6 +159,27 @@ static CURLcode test_unit1603(const char *arg)
   nodep = Curl_hash_pick(&hash_static, &key3, strlen(key3));
   fail_unless(nodep == key3, "hash retrieval failed");
 
+  /* Grow the table, all entries must still be found */
+  rc = Curl_hash_resize(&hash_static, 13);
+  fail_unless(rc == 0, "hash resize failed");
+  fail_unless(Curl_hash_count(&hash_static) == 3, "hash count changed");
+  nodep = Curl_hash_pick(&hash_static, &key1, strlen(key1));
+  fail_unless(nodep == notakey, "hash retrieval after resize failed");
+  nodep = Curl_hash_pick(&hash_static, &key2, strlen(key2));
+  fail_unless(nodep == key2, "hash retrieval after resize failed");
+  nodep = Curl_hash_pick(&hash_static, &key3, strlen(key3));
+  fail_unless(nodep == key3, "hash retrieval after resize failed");
+
+  /* Only grow the table when the chains get long */
+  Curl_hash_grow_if_needed(&hash_static);
+  fail_unless(hash_static.slots == 13, "hash grew too early");
+  rc = Curl_hash_resize(&hash_static, 1);
+  fail_unless(rc == 0, "hash resize failed");
+  Curl_hash_grow_if_needed(&hash_static);
+  fail_unless(hash_static.slots == 3, "hash did not grow");
+  nodep = Curl_hash_pick(&hash_static, &key2, strlen(key2));
+  fail_unless(nodep == key2, "hash retrieval after growth failed");
+
   /* Add element with own destructor */
   nodep = Curl_hash_add2(&hash_static, &key1, strlen(key1), &key1,
                          my_elem_dtor);
@@ -112,6 +112,7 @@ static CURLcode test_unit1660(const char *arg)
 
   CURLcode result;
   struct stsentry *e;
+  struct stsentry pre;
   struct hsts *h = Curl_hsts_init();
   int i;
   const char *chost;
@@ -147,7 +148,7 @@ static CURLcode test_unit1660(const char *arg)
     }
 
     chost = headers[i].chost ? headers[i].chost : headers[i].host;
-    e = Curl_hsts(h, chost, strlen(chost), TRUE);
+    e = Curl_hsts(h, chost, strlen(chost), TRUE, &pre);
     showsts(e, chost);
   }
 
@@ -156,11 +157,21 @@ static CURLcode test_unit1660(const char *arg)
   /* verify that it is exists for 7 seconds */
   chost = "expire.example";
   for(i = 100; i < 110; i++) {
-    e = Curl_hsts(h, chost, strlen(chost), TRUE);
+    e = Curl_hsts(h, chost, strlen(chost), TRUE, &pre);
     showsts(e, chost);
     deltatime++; /* another second passed */
   }
 
+  /* short-lived entries do not pile up in the cache */
+  for(i = 0; i < 1000; i++) {
+    char host[32];
+    curl_msnprintf(host, sizeof(host), "%d.prune.example", i);
+    result = Curl_hsts_parse(h, host, "max-age=\"1\"");
+    fail_unless(!result, "Curl_hsts_parse() failed");
+    deltatime += 2;
+  }
+  fail_unless(Curl_llist_count(&h->list) < 200, "expired entries kept");
+
   curl_msnprintf(savename, sizeof(savename), "%s.save", arg);
   (void)Curl_hsts_save(easy, h, savename);
   Curl_hsts_cleanup(&h);
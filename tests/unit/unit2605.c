@@ -0,0 +1,127 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "urldata.h"
+#include "ws.h"
+#include "curlx/timeval.h"
+
+#if defined(CURL_DISABLE_WEBSOCKETS) || defined(CURL_DISABLE_HTTP)
+static CURLcode test_unit2605(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+  puts("nothing to do when WebSockets are disabled");
+  UNITTEST_END_SIMPLE
+}
+#else
+
+#define MASK_BENCH_LEN   (64*1024)
+#define MASK_BENCH_ROUNDS 2000
+
+/* Compare the speed of the scalar and the fast masking. Only run when
+ * CURL_WS_MASK_BENCH is set, output goes to stderr. */
+static void mask_bench(void)
+{
+  static unsigned char buf[MASK_BENCH_LEN];
+  const unsigned char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+  struct curltime start;
+  timediff_t us_scalar, us_fast;
+  unsigned int xori = 0;
+  int i;
+
+  memset(buf, 'x', sizeof(buf));
+  start = curlx_now();
+  for(i = 0; i < MASK_BENCH_ROUNDS; ++i)
+    xori = ws_mask_scalar(buf, buf, sizeof(buf), mask, xori);
+  us_scalar = curlx_timediff_us(curlx_now(), start);
+
+  start = curlx_now();
+  for(i = 0; i < MASK_BENCH_ROUNDS; ++i)
+    xori = ws_mask(buf, buf, sizeof(buf), mask, xori);
+  us_fast = curlx_timediff_us(curlx_now(), start);
+
+  curl_mfprintf(stderr, "ws mask %d x %d bytes: scalar %" FMT_TIMEDIFF_T
+                "us, fast %" FMT_TIMEDIFF_T "us\n", MASK_BENCH_ROUNDS,
+                MASK_BENCH_LEN, us_scalar, us_fast);
+}
+
+static CURLcode test_unit2605(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  static unsigned char src[300];
+  static unsigned char exp[300];
+  static unsigned char out[300];
+  const unsigned char mask[4] = { 0xa5, 0x01, 0xff, 0x3c };
+  size_t len, off, i;
+  unsigned int xori, exp_xori, out_xori;
+
+  for(i = 0; i < sizeof(src); ++i)
+    src[i] = (unsigned char)(i * 7 + 3);
+
+  /* every length up to beyond the widest block, at every alignment
+   * and starting at every mask index */
+  for(off = 0; off < 4; ++off) {
+    for(len = 0; len <= sizeof(src) - 4; ++len) {
+      for(xori = 0; xori < 4; ++xori) {
+        exp_xori = ws_mask_scalar(exp, src + off, len, mask, xori);
+        out_xori = ws_mask(out + (3 - off), src + off, len, mask, xori);
+        fail_unless(exp_xori == (unsigned int)((xori + len) & 3),
+                    "scalar mask index wrong");
+        fail_unless(out_xori == exp_xori, "mask index differs");
+        fail_unless(!memcmp(out + (3 - off), exp, len),
+                    "masked data differs");
+
+        /* in place */
+        memcpy(out + off, src + off, len);
+        out_xori = ws_mask(out + off, out + off, len, mask, xori);
+        fail_unless(out_xori == exp_xori, "in place mask index differs");
+        fail_unless(!memcmp(out + off, exp, len),
+                    "in place masked data differs");
+
+        /* masking twice restores the original */
+        (void)ws_mask(out + off, out + off, len, mask, xori);
+        fail_unless(!memcmp(out + off, src + off, len),
+                    "unmasking does not restore data");
+      }
+    }
+  }
+
+  /* continuing a frame in pieces gives the same result as all at once */
+  xori = 0;
+  for(off = 0; off < sizeof(src) - 4; off += len) {
+    len = CURLMIN(off % 37 + 1, sizeof(src) - 4 - off);
+    xori = ws_mask(out + off, src + off, len, mask, xori);
+  }
+  exp_xori = ws_mask_scalar(exp, src, sizeof(src) - 4, mask, 0);
+  fail_unless(xori == exp_xori, "piecewise mask index differs");
+  fail_unless(!memcmp(out, exp, sizeof(src) - 4),
+              "piecewise masked data differs");
+
+  if(getenv("CURL_WS_MASK_BENCH"))
+    mask_bench();
+
+  UNITTEST_END_SIMPLE
+}
+#endif